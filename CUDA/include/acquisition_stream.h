@@ -0,0 +1,66 @@
+#ifndef INCLUDE_ACQUISITION_STREAM_H_
+
+#define INCLUDE_ACQUISITION_STREAM_H_
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+#include <string>
+#include <vector>
+#include "./raw_data_reader.h"
+
+/**
+ * \brief Producer/consumer pipeline for raw data acquisitions
+ *
+ * A background thread reads and decodes blocks of consecutive acquisitions
+ * through RawDataReader::GetAcquisitions and places them into a bounded
+ * queue. The consumer fetches the decoded blocks in acquisition order via
+ * NextBlock, i.e. scattering of one block overlaps with reading the next one.
+ *
+ * The reader must not be accessed by other threads while the stream is
+ * running.
+ */
+class AcquisitionStream
+{
+ public:
+  AcquisitionStream(const RawDataReader *reader, unsigned blockSize = 256,
+                    unsigned maxQueuedBlocks = 4);
+  virtual ~AcquisitionStream();
+
+  /**
+   * \brief Start the reading thread.
+   */
+  void Start();
+
+  /**
+   * \brief Fetch the next block of acquisitions.
+   *
+   * Blocks until data is available. Returns false after the last block has
+   * been delivered. Errors raised while reading are rethrown as
+   * std::runtime_error.
+   */
+  bool NextBlock(std::vector<Acquisition> &block);
+
+  unsigned GetNumberOfAcquisitions() const;
+
+ private:
+  const RawDataReader *reader;
+  unsigned blockSize;
+  unsigned maxQueuedBlocks;
+  unsigned numberOfAcquisitions;
+
+  std::deque<std::vector<Acquisition> > queue;
+  bool finished;
+  bool aborted;
+  std::string errorMessage;
+
+  boost::thread producer;
+  boost::mutex mutex;
+  boost::condition_variable queueNotFull;
+  boost::condition_variable queueNotEmpty;
+
+  void ReadBlocks();
+};
+
+#endif  // INCLUDE_ACQUISITION_STREAM_H_
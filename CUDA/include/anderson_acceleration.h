@@ -0,0 +1,75 @@
+#ifndef INCLUDE_ANDERSON_ACCELERATION_H_
+
+#define INCLUDE_ANDERSON_ACCELERATION_H_
+
+#include <vector>
+#include "./types.h"
+
+/**
+ * \brief Anderson acceleration of a fixed-point iteration u = T(u)
+ *
+ * Type-II Anderson mixing with a history of the last depth differences of
+ * iterates \f$\Delta g_i\f$ and residuals \f$\Delta f_i\f$, \f$f = T(u) -
+ * u\f$. Each update solves the (regularized) least squares problem
+ * \f$\min_\gamma |f_k - \Delta F\gamma|\f$ on the host and returns
+ * \f$u_{k+1} = T(u_k) - \Delta G\gamma\f$.
+ *
+ * The state is a single (flat) vector, the history needs 2 * depth + 3
+ * vectors of the state size.
+ */
+class AndersonAcceleration
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] depth number of stored differences m
+   * \param[in] size size of the flat state vector
+   * */
+  AndersonAcceleration(unsigned depth, unsigned size);
+
+  virtual ~AndersonAcceleration();
+
+  /** \brief Clear the history, e.g. after the map T changed. */
+  void Reset();
+
+  /** \brief Accelerate one fixed-point step.
+   *
+   * \param[in,out] g result of the last iteration T(u_k), replaced by the
+   * accelerated iterate u_{k+1}
+   * \return true, if g was replaced
+   */
+  bool Update(CVector &g);
+
+  unsigned GetDepth() const;
+
+  /** \brief Number of stored differences */
+  unsigned GetHistorySize() const;
+
+ private:
+  /** \brief Solve the least squares problem for the current history. */
+  bool SolveCoefficients(std::vector<RType> &gamma);
+
+  unsigned depth;
+  unsigned size;
+
+  std::vector<CVector> deltaF;
+  std::vector<CVector> deltaG;
+
+  /** \brief Input of the last iteration u_k */
+  CVector u;
+  CVector f;
+  CVector fLast;
+  CVector gLast;
+
+  /** \brief Gram matrix of deltaF, dims: depth * depth */
+  std::vector<RType> gram;
+  /** \brief Inner products of deltaF and f */
+  std::vector<RType> rhs;
+
+  unsigned count;
+  unsigned next;
+  bool hasInput;
+  bool hasLast;
+};
+
+#endif  // INCLUDE_ANDERSON_ACCELERATION_H_
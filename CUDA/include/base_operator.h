@@ -74,6 +74,22 @@ class BaseOperator
    * (Cartesian, Non-Cartesian).*/
   virtual RType AdaptLambda(RType k, RType d) = 0;
 
+  /** \brief True, if forward and backward operations can be restricted to
+   * a subset of coils. */
+  virtual bool SupportsCoilSubsets() const;
+
+  /** \brief Restrict forward and backward operations to a subset of coils.
+   *
+   * Backward operations only write the k-space data of the selected coils,
+   * forward operations only sum up their contributions. An empty subset
+   * selects all coils.
+   *
+   * \param subset coil indices
+   * \throw std::invalid_argument if subsets are not supported or a coil
+   * index is invalid
+   */
+  void SetCoilSubset(const std::vector<unsigned> &subset);
+
  protected:
   /** \brief Image dimension width */
   unsigned int width;
@@ -86,6 +102,9 @@ class BaseOperator
   /** \brief Image dimension amount of frames */
   unsigned int frames;
 
+  /** \brief Coils used in forward and backward operations */
+  std::vector<unsigned> activeCoils;
+
  private:
 };
 
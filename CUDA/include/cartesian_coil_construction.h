@@ -24,6 +24,22 @@ class CartesianCoilConstruction : public CoilConstruction
 
   void TimeAveragedReconstruction(CVector &kdata, CVector &u, CVector &crec, bool applyPhase = true);
 
+  /** \brief Coil construction on the k-space centre.
+   *
+   * Coil sensitivities are smooth, hence the construction is performed on a
+   * grid reduced by params.lowResFactor and b1 and u are upsampled to full
+   * resolution afterwards.
+   *
+   * \param[in] kdata chopped k-space data, dims: width*height*coils*frames
+   * \param[in] mask sampling mask, dims: width*height*frames
+   * \param[out] u image estimate, dims: width*height*coils
+   * \param[out] b1 coil sensitivities, dims: width*height*coils
+   * */
+  static void PerformLowResCoilConstruction(
+      unsigned width, unsigned height, unsigned coils, unsigned frames,
+      CoilConstructionParams &params, CVector &kdata, RVector &mask,
+      CVector &u, CVector &b1, communicator_type &com, bool verbose = false);
+
  private:
   CartesianOperator *mrOp;
 };
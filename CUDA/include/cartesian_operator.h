@@ -74,6 +74,9 @@ class CartesianOperator : public BaseOperator
    * dependence on acceleration factor. */ 
   RType AdaptLambda(RType k, RType d);
 
+  /** \brief Coils are processed one at a time, subsets are supported. */
+  bool SupportsCoilSubsets() const;
+
   /** \brief Determines whether the centered (shifted) or non-centered FFT has
    * to be applied. */
   bool centered;
@@ -0,0 +1,121 @@
+#ifndef INCLUDE_COIL_COMPRESSION_H_
+
+#define INCLUDE_COIL_COMPRESSION_H_
+
+#include <vector>
+#include <cublas_v2.h>
+#include "cufft.h"
+#include "./types.h"
+
+/** \brief Parameter struct used in coil compression. */
+typedef struct CoilCompressionParams
+{
+  CoilCompressionParams()
+    : virtualCoils(0), energyThreshold(1.0), geometric(false)
+  {
+  }
+
+  /** \brief Number of virtual coils, 0 selects by energy threshold */
+  unsigned virtualCoils;
+
+  /** \brief Fraction of the signal energy retained by the virtual coils */
+  RType energyThreshold;
+
+  /** \brief Readout position dependent compression (Cartesian data only) */
+  bool geometric;
+
+} CoilCompressionParams;
+
+/**
+ * \brief Compresses multi-coil k-space data to a reduced set of virtual coils
+ *
+ * The compression matrix is obtained from the eigen-decomposition of the
+ * channel covariance matrix \f$A^HA\f$, which is equivalent to an SVD of the
+ * data matrix \f$A\f$ (samples x coils).
+ *
+ * For Cartesian data a geometric compression can be applied instead: the data
+ * is transformed to hybrid space along the readout direction, one compression
+ * matrix is computed for each readout position and adjacent matrices are
+ * aligned such that the virtual coils remain smooth along the readout.
+ *
+ * Since every operator application scales linearly with the number of coils,
+ * the expected speedup of coil construction and reconstruction is reported as
+ * ratio of physical to virtual coils.
+ */
+class CoilCompression
+{
+ public:
+  CoilCompression(const CoilCompressionParams &params);
+
+  virtual ~CoilCompression();
+
+  /** \brief Returns true if the parameters request any compression. */
+  static bool IsEnabled(const CoilCompressionParams &params);
+
+  /** \brief Compress k-space data in place.
+   *
+   * \param[in,out] kdata k-space data, dims: samples * coils * frames
+   * \param[in,out] dims data dimensions, coils is set to the number of
+   *virtual coils
+   * \param[in] cartesian flag to indicate Cartesian data, dims: width * height
+   *samples per coil
+   * */
+  void Compress(CVector &kdata, Dimension &dims, bool cartesian);
+
+  /** \brief Number of virtual coils of the last compression */
+  unsigned GetVirtualCoils() const;
+
+  /** \brief Relative error \f$\|A - AWW^H\|_F / \|A\|_F\f$ of the last
+   * compression */
+  RType GetCompressionError() const;
+
+  /** \brief Expected speedup of all coil-wise operations */
+  RType GetEstimatedSpeedup() const;
+
+  void SetVerbose(bool verbose);
+
+  /** \brief Eigen-decomposition of a hermitian matrix by cyclic Jacobi
+   * rotations.
+   *
+   * \param[in] matrix column major n x n hermitian matrix
+   * \param[in] n matrix size
+   * \param[out] eigenvalues eigenvalues in descending order
+   * \param[out] eigenvectors column major matrix of the corresponding
+   *eigenvectors
+   * */
+  static void HermitianEigen(const std::vector<CType> &matrix, unsigned n,
+                             std::vector<RType> &eigenvalues,
+                             std::vector<CType> &eigenvectors);
+
+ private:
+  CoilCompressionParams params;
+  bool verbose;
+
+  unsigned coils;
+  unsigned virtualCoils;
+  RType compressionError;
+
+  /** \brief Number of virtual coils for given descending eigenvalues */
+  unsigned SelectVirtualCoils(const std::vector<RType> &eigenvalues);
+
+  /** \brief Discarded energy fraction for given eigenvalues */
+  RType DiscardedEnergy(const std::vector<RType> &eigenvalues,
+                        unsigned nVirtual);
+
+  void CompressUniform(CVector &kdata, Dimension &dims,
+                       cublasHandle_t handle);
+
+  void CompressGeometric(CVector &kdata, Dimension &dims,
+                         cublasHandle_t handle);
+
+  /** \brief Transform one frame to hybrid space, layout (x, coil, y) */
+  void ToHybridSpace(const CType *frame, CVector &kspace, CVector &hybrid,
+                     unsigned width, unsigned height, unsigned nCoils,
+                     cufftHandle plan, cublasHandle_t handle);
+
+  /** \brief Align compression matrix of neighbouring readout position */
+  void AlignCompressionMatrix(const std::vector<CType> &previous,
+                              std::vector<CType> &current);
+};
+
+#endif  // INCLUDE_COIL_COMPRESSION_H_
@@ -8,6 +8,7 @@
 #include "./utils.h"
 #include "./cg_forward_operation.h"
 #include "./pd_recon.h"
+#include "./screened_poisson_solver.h"
 
 #include "agile/agile.hpp"
 
@@ -29,15 +30,35 @@ typedef struct CoilConstructionParams : public PDParams
   RType uAlpha0;
   RType uAlpha1;
 
+  /** \brief Iterations of the warm-started UTGV2Recon calls during the greedy
+   * coil loop (0: cold start with uNrIt iterations) */
+  unsigned uWarmNrIt;
+
   RType b1Reg;
   unsigned b1NrIt;
   RType b1Tau;
   RType b1Sigma;
   RType b1SigmaTauRatio;
 
+  /** \brief Number of coils whose b1 phase is estimated simultaneously in
+   * each step of the greedy coil loop */
+  unsigned b1BatchSize;
+
   RType b1FinalReg;
   unsigned b1FinalNrIt;
 
+  /** \brief Solve the quadratic b1 problems of B1FromUH1 and B1Recon by FFT
+   * preconditioned CG instead of plain CG / primal-dual iterations (off by
+   * default) */
+  bool pcgSolver;
+
+  /** \brief Relative residual tolerance of the preconditioned CG solver */
+  RType pcgTolerance;
+
+  /** \brief Downsampling factor of the coil construction grid, b1 and u are
+   * upsampled to full resolution afterwards (1: full resolution) */
+  unsigned lowResFactor;
+
 } CoilConstructionParams;
 
 typedef agile::GPUCommunicator<unsigned, CType, CType> communicator_type;
@@ -71,6 +92,19 @@ class CoilConstruction : public PDRecon
   /** \brief Find index of coil with maximum sum over elements (l1-norm) */
   unsigned FindMaximumSum(CVector &crec);
 
+  /** \brief Correlation \f$\sum_x |crec_i||crec_j|\f$ of all coil pairs,
+   * computed in one batched pass
+   *
+   * \param[in] crec coil images, dims: width * height * coils
+   * \param[out] correlation coils x coils matrix
+   * */
+  void ComputeCoilCorrelation(CVector &crec, std::vector<RType> &correlation);
+
+  /** \brief Greedy coil order: start with the coil of maximum sum and
+   * continue with the remaining coil of maximum correlation to its
+   * predecessor */
+  std::vector<unsigned> FindCoilOrder(CVector &crec);
+
   /** \brief Reconstruct the time averaged k-space, i.e. frame-wise k-space data
    *is accumulated to one full k-space
    * \param[in] kdata coil-wise k-space data, dims: width * height * coils *
@@ -87,6 +121,8 @@ class CoilConstruction : public PDRecon
    *
    * \f$|b_j| = arg \min \frac{\mu}{2}\|bu_0-|crec_j|\|^2_2+\|\nabla b\|_2\f$
    *
+   * If pcgSolver is set, all coils are solved at once by preconditioned CG.
+   *
    * */
   void B1FromUH1(CVector &u, CVector &crec, communicator_type &com,
                  CVector &b1);
@@ -102,17 +138,23 @@ class CoilConstruction : public PDRecon
    * \param[in] crec0 Coil reconstructions performed by
    *TimeAveragedReconstruction
    * \param[in] inds Set of coil indices, which have to be processed
-   * \param[out] x1 Reconstructed u
+   * \param[in,out] x1 Initial guess and reconstructed u
+   * \param[in] warmStart continue from the auxiliary and dual variables of
+   *the previous call and run uWarmNrIt iterations (if uWarmNrIt > 0)
    *
    * */
   void UTGV2Recon(CVector &b10, CVector &crec0, CVector &x1,
-                  std::vector<unsigned> inds);
+                  std::vector<unsigned> inds, bool warmStart = false);
 
   /** \brief Compute new b1 from iteratively updated u
    *
    * \f$\phi = arg \min_p (\frac{\mu}{2}\|\nabla p\|^2_2 +
    *\frac{1}{2}\|p|\sigma|u-v\|^2_2\|^2_2)\f$
    *
+   * If pcgSolver is set, the optimality condition
+   * \f$(|u|^2 + \mu\nabla^T\nabla)p = \bar{u}v\f$ is solved for all coils
+   * at once by preconditioned CG and maxIt bounds the CG iterations.
+   *
    * \param[in] u0 Current u computed by B1FromUH1
    * \param[in] crec Coil reconstructions created by TimeAveragedReconstruction
    * \param[in] coils Amount of already processed coils
@@ -124,6 +166,19 @@ class CoilConstruction : public PDRecon
   void B1Recon(CVector &u0, CVector &crec, CVector &b1, unsigned coils,
                unsigned maxIt = 500, RType mu = 2);
 
+  /** \brief Estimate b1 of several coils independently, each with its own
+   * weighted image, as in B1Recon for a single coil
+   *
+   * \param[in] u0 weighted images, dims: width * height * count
+   * \param[in] crec coil reconstructions, dims: width * height * count
+   * \param[out] x1 b1 estimates, of which only the phase is used
+   * \param[in] count Number of coils
+   * \param[in] maxIt Maximum number of iterations
+   * \param[in] mu Regularization parameter
+   * */
+  void B1PhaseRecon(CVector &u0, CVector &crec, CVector &x1, unsigned count,
+                    unsigned maxIt, RType mu);
+
   /** \brief Construct coil sensitivities and initial image estimate from
    *k-space data.
    *
@@ -140,6 +195,25 @@ class CoilConstruction : public PDRecon
  private:
   CoilConstructionParams params;
   void InitParams();
+
+  /** \brief Auxiliary and dual variables of UTGV2Recon kept for warm
+   * starts */
+  std::vector<CVector> utgvX2;
+  std::vector<CVector> utgvY1;
+  std::vector<CVector> utgvY2;
+
+  /** \brief Scale u0 such that its maximum absolute value is 1 */
+  void NormalizeByMaximum(CVector &u0, CVector &u0Normed);
+
+  /** \brief B1Recon by preconditioned CG on the optimality condition */
+  void B1ReconPCG(CVector &u0, CVector &crec, CVector &x1, unsigned coils,
+                  unsigned maxIt, RType mu);
+
+  /** \brief Normalize b1 by the sum-of-squares over the given coils */
+  void NormalizeB1(CVector &b1, unsigned coils);
+
+  /** \brief Log convergence information of the preconditioned CG solver */
+  void LogSolver(const char *name, ScreenedPoissonSolver &solver);
 };
 
 #endif  // INCLUDE_COIL_CONSTRUCTION_H_
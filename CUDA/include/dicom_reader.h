@@ -28,10 +28,19 @@ class DicomReader : public SiemensVD11Reader
 
   DicomFileList GetDicomFileList();
 
+  /**
+   * \brief Concatenate the raw data embedded in all dicom files into the
+   * passed in-memory buffer.
+   */
+  void ExtractRawData(std::vector<char> &rawData);
+
   void GenerateMeasDat(const std::string &rawDataFile);
 
  private:
   const std::string &filepath;
+
+  // extracted raw data, indexed and decoded in place by SiemensVD11Reader
+  std::vector<char> embeddedRawData;
 };
 
 #endif  // INCLUDE_DICOM_LOADER_H_
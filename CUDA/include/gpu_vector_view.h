@@ -0,0 +1,130 @@
+#ifndef INCLUDE_GPU_VECTOR_VIEW_H_
+
+#define INCLUDE_GPU_VECTOR_VIEW_H_
+
+#include <cuda_runtime.h>
+#include "agile/gpu_vector.hpp"
+#include "agile/agile.hpp"
+
+/**
+ * \brief Non-owning view of elements of a GPU vector
+ *
+ * A view references length elements, starting at an offset and separated by
+ * a stride. Views with unit stride, e.g. one coil or frame slice of a stacked
+ * vector, can be passed directly to the pointer based agile::lowlevel
+ * functions and to the view overloads of the utils functions, such that slice
+ * access requires no copies.
+ *
+ * Views with non-unit stride (e.g. one pixel over all coils) can only be
+ * copied from and to contiguous vectors using CopyTo and CopyFrom.
+ *
+ * A view does not own its data and must not outlive the referenced vector.
+ */
+template <typename TType>
+class GPUVectorView
+{
+ public:
+  /** \brief View of length elements of vector, starting at offset. */
+  GPUVectorView(agile::GPUVector<TType> &vector, unsigned offset,
+                unsigned length, unsigned stride = 1)
+    : ptr(vector.data() + offset), length(length), elementStride(stride)
+  {
+    AGILE_ASSERT(length == 0 || offset + (length - 1) * stride < vector.size(),
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: view exceeds vector"));
+  }
+
+  /** \brief View of the complete vector. */
+  GPUVectorView(agile::GPUVector<TType> &vector)
+    : ptr(vector.data()), length(vector.size()), elementStride(1)
+  {
+  }
+
+  /** \brief View of slice index of a vector of stacked slices. */
+  static GPUVectorView Slice(agile::GPUVector<TType> &vector, unsigned index,
+                             unsigned sliceLength)
+  {
+    return GPUVectorView(vector, index * sliceLength, sliceLength);
+  }
+
+  /** \brief View of slice index of this (contiguous) view. */
+  GPUVectorView Slice(unsigned index, unsigned sliceLength) const
+  {
+    AGILE_ASSERT(IsContiguous() && (index + 1) * sliceLength <= length,
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: invalid slice"));
+    return GPUVectorView(ptr + index * sliceLength, sliceLength, 1);
+  }
+
+  TType *data() const
+  {
+    return ptr;
+  }
+
+  unsigned size() const
+  {
+    return length;
+  }
+
+  unsigned stride() const
+  {
+    return elementStride;
+  }
+
+  bool IsContiguous() const
+  {
+    return elementStride == 1;
+  }
+
+  /** \brief Copy the viewed elements to a contiguous vector. */
+  void CopyTo(agile::GPUVector<TType> &vector) const
+  {
+    AGILE_ASSERT(vector.size() >= length,
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: target vector too small"));
+    Copy(ptr, elementStride, vector.data(), 1);
+  }
+
+  /** \brief Copy the elements of a contiguous vector to the viewed
+   * elements. */
+  void CopyFrom(const agile::GPUVector<TType> &vector) const
+  {
+    AGILE_ASSERT(vector.size() >= length,
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: source vector too small"));
+    Copy(vector.data(), 1, ptr, elementStride);
+  }
+
+  /** \brief Copy the viewed elements to the elements of another view of
+   * the same size. */
+  void CopyTo(const GPUVectorView &view) const
+  {
+    AGILE_ASSERT(view.length == length,
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: views differ in size"));
+    Copy(ptr, elementStride, view.ptr, view.elementStride);
+  }
+
+ private:
+  GPUVectorView(TType *ptr, unsigned length, unsigned stride)
+    : ptr(ptr), length(length), elementStride(stride)
+  {
+  }
+
+  void Copy(const TType *src, unsigned srcStride, TType *dst,
+            unsigned dstStride) const
+  {
+    cudaError_t err = cudaMemcpy2D(
+        dst, dstStride * sizeof(TType), src, srcStride * sizeof(TType),
+        sizeof(TType), length, cudaMemcpyDeviceToDevice);
+    AGILE_ASSERT(err == cudaSuccess,
+                 StandardException::ExceptionMessage(
+                     "GPUVectorView: error during strided copy"));
+  }
+
+  TType *ptr;
+  unsigned length;
+  unsigned elementStride;
+};
+
+#endif  // INCLUDE_GPU_VECTOR_VIEW_H_
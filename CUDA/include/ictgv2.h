@@ -65,6 +65,11 @@ class ICTGV2 : public PDRecon
 
   /** \brief Computation of the primal-dual gap
    *
+   * Needs extra operator and divergence evaluations. Inside the iteration,
+   * the gap of the extrapolated primal and the updated dual variables
+   * (ext_n, y_n+1) is accumulated from quantities of the primal and dual
+   * updates instead, i.e. stopPDGap is checked on this pair. This is only
+   * used with extrapolated duals, or in debug mode to check the by-products.
    */
   RType ComputePDGap(CVector &x1, std::vector<CVector> &x2, CVector &x3,
                      std::vector<CVector> &x4, std::vector<CVector> &y1,
@@ -82,6 +87,12 @@ class ICTGV2 : public PDRecon
 
   void ExportAdditionalResults(const char* outputDir, ResultExportCallback callback);
 
+  /** \brief Maximal normalized deviation of the PD gap accumulated from the
+   * iteration by-products to ComputePDGap at the same iterate, only
+   * evaluated in debug mode.
+   */
+  RType GetPDGapDeviation() const;
+
  private:
   ICTGV2Params params;
   void InitParams();
@@ -95,6 +106,7 @@ class ICTGV2 : public PDRecon
   std::vector<CType> ictgvNormExport;
  
   RType datafidelity;
+  RType pdGapDeviation;
 
   CVector imgTemp;
   CVector zTemp;
@@ -103,6 +115,8 @@ class ICTGV2 : public PDRecon
   std::vector<CVector> div2Temp;
   std::vector<CVector> y2Temp;
   std::vector<CVector> y4Temp;
+  /** \brief Pointwise norms of the PD gap by-products */
+  CVector normTemp;
 
   // primal vectors
   CVector ext1;
@@ -125,6 +139,23 @@ class ICTGV2 : public PDRecon
   std::vector<CVector> y2;
   std::vector<CVector> y3;
   std::vector<CVector> y4;
+
+  /** \brief Initialize the step sizes of all blocks, i.e. the scalar sigma
+   * and tau or the diagonally preconditioned steps */
+  void InitSteps(CVector &b1, unsigned dataSize);
+
+  void ScaleSteps(RType factor);
+
+  // step sizes
+  std::vector<RType> sigmaY1;
+  std::vector<RType> sigmaY2;
+  std::vector<RType> sigmaY3;
+  std::vector<RType> sigmaY4;
+  RType sigmaZ;
+  std::vector<RType> tauX2;
+  RType tauX3;
+  std::vector<RType> tauX4;
+  CVector tauX1;
 };
 
 #endif  // INCLUDE_ICTGV2_H_
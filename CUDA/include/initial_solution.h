@@ -0,0 +1,131 @@
+#ifndef INCLUDE_INITIAL_SOLUTION_H_
+
+#define INCLUDE_INITIAL_SOLUTION_H_
+
+#include "./types.h"
+#include "./base_operator.h"
+#include "./cartesian_operator.h"
+
+/**
+ * \brief Initialization method of the reconstruction
+ *
+ */
+typedef enum InitMethod
+{
+  INIT_U0,
+  INIT_VIEWSHARING,
+  INIT_CGSENSE
+} InitMethod;
+
+/** \brief Parameter struct used for the initial solution. */
+typedef struct InitialSolutionParams
+{
+  InitialSolutionParams()
+    : method(INIT_U0), window(3), cgIt(5), cgTolerance(1E-3)
+  {
+  }
+
+  /** \brief Initialization method */
+  InitMethod method;
+
+  /** \brief Frames of the sliding window (view sharing) */
+  unsigned window;
+
+  /** \brief Maximum number of CG-SENSE iterations */
+  unsigned cgIt;
+
+  /** \brief Relative residual of the normal equations to stop CG-SENSE at */
+  RType cgTolerance;
+
+} InitialSolutionParams;
+
+/**
+ * \brief Initial solution of all frames for the primal-dual reconstruction
+ *
+ * By default every frame is initialized with the time averaged image u0.
+ * Alternatively the frames are initialized by
+ * - view sharing: the k-space data of a sliding window of frames is
+ *combined, normalized by the coil sensitivities and scaled to fit the data
+ *in the least squares sense. For the Cartesian operator each k-space point
+ *is weighted by the inverse number of window frames sampling it, other
+ *operators sum the zero-filled adjoint images \f$K_s^Hd_s\f$.
+ * - CG-SENSE: a few CG iterations on the normal equations \f$K^HKx =
+ *K^Hd\f$, started from u0.
+ *
+ * Both use the reconstruction operator, i.e. all frames are processed
+ * simultaneously.
+ */
+class InitialSolution
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] N number of pixels per frame
+   * \param[in] frames number of frames
+   * \param[in] params initialization parameters
+   * \param[in] mrOp MR operator
+   * */
+  InitialSolution(unsigned N, unsigned frames,
+                  const InitialSolutionParams &params, BaseOperator *mrOp);
+
+  virtual ~InitialSolution();
+
+  /** \brief Compute the initial solution.
+   *
+   * \param[in] kdata k-space data
+   * \param[in] u0 time averaged image, dims: N
+   * \param[in] b1 coil sensitivities, dims: N * coils
+   * \param[out] x initial solution, dims: N * frames
+   * */
+  void Compute(CVector &kdata, CVector &u0, CVector &b1, CVector &x);
+
+  /** \brief Number of CG-SENSE iterations of the last computation */
+  unsigned GetIterations() const;
+
+  /** \brief Relative data residual \f$\|Kx - d\|/\|d\|\f$ of u0 */
+  RType GetInitialResidual() const;
+
+  /** \brief Relative data residual \f$\|Kx - d\|/\|d\|\f$ of the initial
+   * solution */
+  RType GetResidual() const;
+
+ private:
+  void ReplicateU0(CVector &u0, CVector &x);
+
+  void ViewSharing(CVector &kdata, CVector &b1, CVector &x);
+
+  /** \brief Number of frames of the sliding window */
+  unsigned SharingWindow() const;
+
+  /** \brief First frame of the sliding window of frame */
+  unsigned FirstSharedFrame(unsigned frame) const;
+
+  /** \brief Coil combined adjoint images of the density weighted window
+   * k-space, not normalized by the coil sensitivities */
+  void SharedCartesianAdjoint(CartesianOperator *cartOp, CVector &kdata,
+                              CVector &b1, CVector &x);
+
+  void CGSense(CVector &kdata, CVector &b1, CVector &x);
+
+  /** \brief Apply \f$K^HK\f$ */
+  void NormalOperation(CVector &x, CVector &y, CVector &b1);
+
+  /** \brief Scale x by the real factor which fits the data best. */
+  void ScaleToData(CVector &kdata, CVector &b1, CVector &x);
+
+  RType DataResidual(CVector &kdata, CVector &b1, CVector &x);
+
+  unsigned N;
+  unsigned frames;
+  InitialSolutionParams params;
+  BaseOperator *mrOp;
+
+  /** \brief Temporary k-space vector, operators modify their input */
+  CVector kTemp;
+
+  unsigned iterations;
+  RType initialResidual;
+  RType residual;
+};
+
+#endif  // INCLUDE_INITIAL_SOLUTION_H_
@@ -8,6 +8,35 @@
 #include "ismrmrd/xml.h"
 #include "ismrmrd/version.h"
 
+/**
+ * \brief Encoding counters of IsmrmrdHeaderFields
+ */
+typedef struct IsmrmrdEncodingCounters
+{
+  uint16_t kspace_encode_step_1;
+  uint16_t slice;
+  uint16_t phase;
+  uint16_t repetition;
+} IsmrmrdEncodingCounters;
+
+/**
+ * \brief Subset of the ISMRMRD acquisition header required for data
+ * preparation
+ *
+ * Member names match the ISMRMRD HDF5 compound type, which allows reading
+ * the headers without the sample data.
+ */
+typedef struct IsmrmrdHeaderFields
+{
+  uint64_t flags;
+  uint16_t number_of_samples;
+  uint16_t active_channels;
+  uint16_t center_sample;
+  uint16_t encoding_space_ref;
+  uint16_t trajectory_dimensions;
+  IsmrmrdEncodingCounters idx;
+} IsmrmrdHeaderFields;
+
 /**
  * \brief
  *
@@ -27,6 +56,9 @@ class IsmrmrdReader : public RawDataReader
 
   unsigned GetNumberOfAcquisitions() const;
   Acquisition GetAcquisition(unsigned index) const;
+  void GetAcquisitions(unsigned start, unsigned count,
+                       std::vector<Acquisition> &acquisitions) const;
+  void GetAcquisitionHeaders(std::vector<AcquisitionHeader> &headers) const;
 
   bool IsNonUniformData() const;
   bool IsOversampledData() const;
@@ -38,7 +70,21 @@ class IsmrmrdReader : public RawDataReader
   ISMRMRD::Dataset *dataset;
   ISMRMRD::IsmrmrdHeader *hdr;
 
+  // header information cached once per file, since it is needed for every
+  // decoded acquisition
+  bool perfusionData;
+  bool nonUniformData;
+  std::vector<unsigned> encodingCenterRows;
+
   void InitRawDataDimensions();
+
+  bool ReadHeaderFields(std::vector<IsmrmrdHeaderFields> &fields) const;
+
+  void DecodeAcquisitionHeader(const IsmrmrdHeaderFields &fields,
+                               AcquisitionHeader &header) const;
+
+  void DecodeAcquisition(ISMRMRD::Acquisition &ismrmrdAcq,
+                         Acquisition &acq) const;
 };
 
 #endif  // INCLUDE_ISMRMRD_READER_H_
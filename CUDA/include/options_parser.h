@@ -14,6 +14,8 @@
 #include "../include/tv.h"
 #include "../include/tv_temp.h"
 #include "../include/coil_construction.h"
+#include "../include/coil_compression.h"
+#include "../include/initial_solution.h"
 #include "agile/agile.hpp"
 #include "agile/io/file.hpp"
 
@@ -50,6 +52,20 @@ typedef struct GpuNUFFTParams
   DType osf;
 } GpuNUFFTParams;
 
+/**
+ * \brief Multiresolution parameter collection
+ */
+typedef struct MultiresParams
+{
+  MultiresParams() : levels(1), maxIt(100)
+  {
+  }
+  /** \brief Number of resolution levels, 1: full resolution only */
+  unsigned levels;
+  /** \brief Iterations on each coarse level */
+  unsigned maxIt;
+} MultiresParams;
+
 /**
  * \brief Options parser for command line input arguments
  *
@@ -64,6 +80,15 @@ class OptionsParser
 
   bool ParseOptions(int argc, char *argv[]);
 
+  /** \brief Apply a parameter set of the sweep file.
+   *
+   * Solver parameters not contained in the set keep the values of the
+   * configuration file.
+   *
+   * \param[in] index index into parameterSets
+   */
+  void ApplyParameterSet(unsigned index);
+
   TVParams tvParams;
   TVtempParams tvtempParams;
   TGV2Params tgv2Params;
@@ -71,6 +96,8 @@ class OptionsParser
   ICTGV2Params ictgv2Params;
   TGV2_3DParams tgv2_3DParams;
   CoilConstructionParams coilParams;
+  CoilCompressionParams compressionParams;
+  InitialSolutionParams initParams;
 
   std::string kdataFilename;
   std::string maskFilename;
@@ -86,19 +113,38 @@ class OptionsParser
   
   std::string sensitivitiesFilename;
   std::string u0Filename;
+  std::string sensitivityCacheDir;
+  std::string checkpointFilename;
+  unsigned checkpointInterval;
+  std::string resumeFilename;
+  std::string warmStartFilename;
+  std::string sweepFilename;
+  bool sweepWarmStart;
+  /** \brief Parameter sets of the sweep, whitespace separated key=value
+   * entries */
+  std::vector<std::string> parameterSets;
   std::string densityFilename;
   bool nonuniform;
   bool normalize;
   bool extradata;
   GpuNUFFTParams gpuNUFFTParams;
+  MultiresParams multiresParams;
+  /** \brief Temporal basis functions of the subspace reconstruction, 0:
+   * disabled */
+  unsigned subspaceRank;
   AdaptLambdaParams adaptLambdaParams;
   bool rawdata;
   bool forceOSRemoval;
+  /** \brief Normalize non-Cartesian raw data to the sum-of-squares image
+   * instead of the coil combined image, which skips the coil construction */
+  bool sosNormalization;
 
  private:
   po::options_description desc;
   po::options_description conf;
   po::options_description hidden;
+  /** \brief Method specific solver parameters, which can be swept */
+  po::options_description solver;
 
   std::string parameterFile;
 
@@ -109,6 +155,14 @@ class OptionsParser
 
   void AddCoilConstrConfigurationParameters();
 
+  void AddCoilCompressionConfigurationParameters();
+
+  void AddInitConfigurationParameters();
+
+  void AddMultiresConfigurationParameters();
+
+  void AddSubspaceConfigurationParameters();
+
   void AddTVConfigurationParameters();
 
   void AddTVtempConfigurationParameters();
@@ -129,11 +183,38 @@ class OptionsParser
   
   void SetStopPDGap(float stopPDGap);
 
+  void SetDiagonalPreconditioning(bool diagonalPreconditioning);
+
+  void SetPDVariant(PDVariant variant, bool restart);
+
+  void SetAndersonDepth(unsigned andersonDepth);
+
+  void SetCoilSubsetSize(unsigned coilSubsetSize);
+
   void SetAdaptLambdaParams();
+
+  /** \brief Read the sweep file, comma separated values of an entry are
+   * expanded to a grid. */
+  bool ReadParameterSweep();
+
+  void SaveSolverParameters();
+
+  void RestoreSolverParameters();
+
+  TVParams tvParamsBase;
+  TVtempParams tvtempParamsBase;
+  TGV2Params tgv2ParamsBase;
+  ICTVParams ictvParamsBase;
+  ICTGV2Params ictgv2ParamsBase;
+  TGV2_3DParams tgv2_3DParamsBase;
 };
 
 std::istream &operator>>(std::istream &in, Method &method);
 
+std::istream &operator>>(std::istream &in, PDVariant &variant);
+
+std::istream &operator>>(std::istream &in, InitMethod &method);
+
 void validate(boost::any &v, const std::vector<std::string> &values,
               Dimension *target, int c);
 
@@ -3,12 +3,15 @@
 #define INCLUDE_PD_RECON_H_
 
 #include <vector>
+#include <string>
 #include <complex>
 #include <cstdio>
 #include <cstdarg>
 #include "./types.h"
 #include "./utils.h"
 #include "./base_operator.h"
+#include "./anderson_acceleration.h"
+#include "./solver_checkpoint.h"
 #include "agile/calc/fft.hpp"
 #include "agile/gpu_vector.hpp"
 
@@ -30,6 +33,22 @@ typedef struct AdaptLambdaParams
   DType d;
 } AdaptLambdaParams;
 
+/**
+ * \brief Primal-dual iteration variants
+ */
+typedef enum PDVariant
+{
+  /** \brief Fixed extrapolation theta = 1 of the primal variable */
+  PD_STANDARD,
+  /** \brief O(1/k^2) variant exploiting the strongly convex data term */
+  PD_ACCELERATED,
+  /** \brief Step sizes balancing primal and dual residuals */
+  PD_ADAPTIVE,
+  /** \brief Stochastic updates of the k-space dual for random coil
+   * subsets */
+  PD_STOCHASTIC
+} PDVariant;
+
 /** \brief Basic parameter struct used in primal-dual (PD) reconstructions. */
 typedef struct PDParams
 {
@@ -61,6 +80,24 @@ typedef struct PDParams
   /** \brief Ratio between primal and dual step-sizes. */
   RType sigmaTauRatio;
 
+  /** \brief Use diagonally preconditioned (per-block/per-pixel) step sizes
+   * instead of the scalar sigma and tau. */
+  bool diagonalPreconditioning;
+
+  /** \brief Primal-dual iteration variant */
+  PDVariant variant;
+
+  /** \brief Restart the extrapolation and step sizes if the PD gap
+   * increases. */
+  bool restart;
+
+  /** \brief History depth of the Anderson acceleration, 0 disables it. */
+  unsigned andersonDepth;
+
+  /** \brief Number of coils updated per iteration of the stochastic
+   * variant. */
+  unsigned coilSubsetSize;
+
   /** \brief spatio-temporal weight.*/
   RType timeSpaceWeight;
 
@@ -106,7 +143,8 @@ class PDRecon
    */
   void AdaptStepSize(RType nKx, RType nx);
 
-  /** \brief Compute the weights dx, dy, dt based on the timeSpaceWeight */
+  /** \brief Compute the weights dx, dy, dt based on the timeSpaceWeight,
+   * an infinite dt without temporal regularization */
   void ComputeTimeSpaceWeights(RType timeSpaceWeight, RType &ds, RType &dt);
 
   /** \brief Return PDParams reference (abstract method). */
@@ -137,6 +175,40 @@ class PDRecon
   /** \brief Enable PD-Gap calculation every "debugstep" iterations  */
   void SetDebug(bool debug,int debugstep);
 
+  /** \brief Enable or disable the temporal derivatives of the regularizer.
+   *
+   * Disabled, e.g. for the coefficient images of a temporal subspace, the
+   * frames are regularized spatially and independently of each other, i.e.
+   * the timeSpaceWeight has no effect. Not supported with diagonal
+   * preconditioning.
+   */
+  void SetTemporalRegularization(bool temporalRegularization);
+
+  /** \brief Number of iterations performed by the last reconstruction */
+  unsigned GetIterations() const;
+
+  /** \brief Number of accepted Anderson steps of the last
+   * reconstruction */
+  unsigned GetAndersonSteps() const;
+
+  /** \brief Write a checkpoint of the solver state every interval
+   * iterations and when a termination signal is received.
+   *
+   * \param[in] filename checkpoint file, an empty string disables
+   * checkpoints
+   * \param[in] interval iterations between checkpoints, 0: only on
+   * termination
+   */
+  void SetCheckpoint(const std::string &filename, unsigned interval);
+
+  /** \brief Continue the next reconstruction from a checkpoint.
+   *
+   * \param[in] filename checkpoint file
+   * \param[in] warmStart if true, only the primal and dual variables are
+   * restored and the iteration starts from 0
+   */
+  void SetResume(const std::string &filename, bool warmStart = false);
+
  protected:
   /** \brief Image dimension width */
   unsigned int width;
@@ -163,11 +235,248 @@ class PDRecon
   bool debug;
   int debugstep;
 
+  /** \brief Regularize along the frames */
+  bool temporalRegularization;
+
+
+  /** \brief Number of iterations performed by the last reconstruction */
+  unsigned iterations;
 
   /** \brief Log message to console output */
   virtual void Log(const char *format, ...);
 
+  /** \brief Initialize the diagonally preconditioned steps of the data term.
+   *
+   * Following Pock and Chambolle (2011), the primal step of the image is
+   * \f$\tau_j = 1 / (c_j + s_j)\f$, where \f$c_j\f$ is the column sum of
+   * \f$|K|\f$ of the regularization operators and \f$s_j = \sum_c
+   * |b_{c,j}|^2\f$. Since the sampled Fourier transform satisfies \f$F^HMF
+   * \le I\f$, \f$K^H\sigma K \le diag(s)\f$ holds for the dual step
+   * \f$\sigma = 1 / L\f$, where \f$L\f$ is the largest eigenvalue of
+   * \f$S^{-1/2}K^HKS^{-1/2}\f$ estimated by power iteration.
+   *
+   * \param[in] b1 coil sensitivities
+   * \param[in] dataSize size of the k-space data
+   * \param[in] regularizerSum column sum \f$c_j\f$ (constant)
+   * \param[out] tau primal step of the image, dims: image size * frames
+   * \return dual step of the k-space dual variable
+   */
+  RType InitDiagonalDataSteps(CVector &b1, unsigned dataSize,
+                              RType regularizerSum, CVector &tau);
+
+  /** \brief Row and column sums of \f$|\mathcal{E}|\f$ of the symmetric
+   * gradient.
+   *
+   * The off-diagonal components are weighted by \f$\sqrt{2}\f$, i.e. the
+   * sums refer to the metric used in ProximalMap6 and SymmetricDivergence.
+   *
+   * \param[out] rowSums row sums of the 6 components
+   * \param[out] columnSums column sums of the 3 components
+   */
+  static void SymmetricGradientSums(RType dx, RType dy, RType dz,
+                                    std::vector<RType> &rowSums,
+                                    std::vector<RType> &columnSums);
+
+  /** \brief Scale all dual steps by factor and all primal steps by
+   * 1/factor, i.e. sigma * tau is preserved.
+   *
+   * Subclasses scale their block steps and call the base method.
+   */
+  virtual void ScaleSteps(RType factor);
+
+  /** \brief Initialize the step sizes of all blocks from sigma and tau or
+   * the diagonal preconditioning. */
+  virtual void InitSteps(CVector &b1, unsigned dataSize);
+
+  /** \brief Clear the registered primal and dual variables. */
+  void ClearState();
+
+  /** \brief Register a primal variable and its extrapolation. */
+  void AddPrimalState(CVector &x, CVector &ext);
+
+  /** \brief Register a dual variable. */
+  void AddDualState(CVector &y);
+
+  /** \brief Register the dual variable of the data term. */
+  void AddDataDualState(CVector &z);
+
+  /** \brief Register an export history, e.g. of the PD gap, which is
+   * stored in checkpoints. */
+  void AddHistoryState(std::vector<CType> &history);
+
+  /** \brief Initialize the iteration variant for the registered
+   * variables. */
+  void InitVariant();
+
+  /** \brief Start iteration loopCnt.
+   *
+   * The variants are active after the step size adaptation of the first 10
+   * iterations. The accelerated and adaptive variants save the dual
+   * variables y^n.
+   */
+  void BeginIteration(unsigned loopCnt);
+
+  /** \brief Dual extrapolation of the accelerated variant, to be called
+   * between dual and primal update.
+   *
+   * The dual of the data term \f$F^*(z) = \langle z,d\rangle +
+   * \frac{1}{2\lambda}|z|^2\f$ is \f$\gamma = 1/\lambda\f$ strongly
+   * convex. Following Chambolle and Pock (2011, Alg. 2) applied to the dual
+   * problem, \f$\theta = 1/\sqrt{1 + 2\gamma\sigma}\f$, \f$\sigma
+   * \leftarrow \theta\sigma\f$, \f$\tau \leftarrow \tau/\theta\f$ and
+   * the primal update uses \f$\bar{y} = y^{n+1} + \theta(y^{n+1} -
+   * y^n)\f$ instead of an extrapolated primal variable.
+   *
+   * \param[in] dataSigma dual step of the data term used in this iteration
+   */
+  void ExtrapolateDual(RType dataSigma);
+
+  /** \brief Restore y^{n+1} after the primal update of the accelerated
+   * variant. */
+  void RestoreDual();
+
+  /** \brief True, if the primal update of this iteration uses extrapolated
+   * (possibly infeasible) duals, i.e. they do not yield a valid PD gap. */
+  bool DualsExtrapolated();
+
+  /** \brief Dual step of the data term.
+   *
+   * Computes z = (z + sigma (K ext - d)) / (1 + sigma / lambda). In the
+   * stochastic variant, only the k-space data of a random subset of coils
+   * is updated. Following Chambolle et al. (2018, SPDHG), the dual step is
+   * scaled by the sampling probability p and the primal update uses K^H
+   * of the dual extrapolated by 1/p (see DataAdjoint).
+   *
+   * \param[in] ext (extrapolated) image
+   * \param[in,out] z dual variable of the data term
+   * \param zTemp temporary vector, dims: data size
+   * \param[in] data k-space data
+   * \param[in] b1 coil sensitivities
+   * \param[in] sigma dual step of the data term
+   * \return true, if zTemp holds the full residual K ext - d afterwards
+   */
+  bool DataDualStep(CVector &ext, CVector &z, CVector &zTemp, CVector &data,
+                    CVector &b1, RType sigma);
+
+  /** \brief Adjoint of the data term applied to the dual, K^H z.
+   *
+   * In the stochastic variant, K^H z is updated incrementally with the
+   * coil subset of the last DataDualStep and the result is extrapolated.
+   */
+  void DataAdjoint(CVector &z, CVector &image, CVector &b1);
+
+  /** \brief Primal extrapolation ext = ext + theta (ext - x), with ext
+   * holding x^{n+1} and x holding x^n.
+   *
+   * theta is 1, except for the accelerated variant (0). */
+  void Extrapolate(CVector &ext, CVector &x);
+
+  /** \brief Step update of the adaptive variant, to be called after the
+   * primal extrapolation.
+   *
+   * Following Goldstein et al. (2015), the primal residual
+   * \f$|x^{n+1}-x^n|/\tau\f$ and the dual residual
+   * \f$|y^{n+1}-y^n|/\sigma\f$ are balanced by shifting the ratio of
+   * sigma and tau.
+   */
+  void UpdateSteps();
+
+  /** \brief Anderson acceleration of the registered variables, to be
+   * called at the end of each iteration.
+   *
+   * The iteration is a fixed-point map on the primal, extrapolated and dual
+   * variables. It is only stationary for the standard variant and the
+   * history is cleared whenever sigma or tau change.
+   */
+  void AndersonStep(unsigned loopCnt);
+
+  /** \brief Safeguards based on the (normalized) PD gap.
+   *
+   * If the gap increased since the last check, the iteration is restarted
+   * (restart option) and the Anderson acceleration falls back to the
+   * variables of the last check and pauses until the next check.
+   */
+  void CheckPDGap(RType pdGap);
+
+  /** \brief Restore the registered variables, step sizes and histories
+   * from the checkpoint set by SetResume, to be called after InitVariant.
+   *
+   * The iteration continues bit-exactly, except for the Anderson
+   * history, which is cleared.
+   *
+   * \return number of completed iterations, 0 without checkpoint
+   */
+  unsigned ResumeIteration(CVector &b1, unsigned dataSize);
+
+  /** \brief Checkpoint after loopCnt completed iterations, written in the
+   * background.
+   *
+   * \return true, if a termination signal was received. The final
+   * checkpoint has been written and the iteration has to stop.
+   */
+  bool CheckpointIteration(unsigned loopCnt);
+
  private:
+  /** \brief Squared norm of a - b */
+  RType DifferenceNormSquared(CVector &a, CVector &b);
+
+  /** \brief Create the Anderson acceleration for the registered
+   * variables. */
+  void InitAnderson();
+
+  /** \brief Draw the coil subset of the next stochastic iteration. */
+  void SelectCoilSubset();
+
+  /** \brief Copy all registered variables to a flat vector. */
+  void GatherState(CVector &state);
+
+  /** \brief Copy a flat vector to all registered variables. */
+  void ScatterState(CVector &state);
+
+  /** \brief Registered variables followed by the internal state of the
+   * variants, in checkpoint order. */
+  void GetCheckpointVectors(std::vector<CVector *> &vectors);
+
+  /** \brief Copy the solver state to the host. */
+  void GatherCheckpoint(unsigned loopCnt, SolverCheckpointData &data);
+
+  std::vector<CVector *> primalState;
+  std::vector<CVector *> extState;
+  std::vector<CVector *> dualState;
+  std::vector<CVector> dualOld;
+  CVector *dataDual;
+  CVector stateDiff;
+
+  bool variantActive;
+  RType primalTheta;
+  RType dualTheta;
+  RType stepScale;
+  RType adaptiveAlpha;
+  RType lastPDGap;
+
+  AndersonAcceleration *anderson;
+  CVector andersonState;
+  CVector andersonSnapshot;
+  bool andersonPaused;
+  unsigned andersonSteps;
+  RType andersonGap;
+  RType andersonSigma;
+  RType andersonTau;
+
+  bool coilSampling;
+  std::vector<unsigned> coilOrder;
+  std::vector<unsigned> coilSubset;
+  RType samplingProbability;
+  unsigned randomState;
+  CVector zOld;
+  CVector zImage;
+  bool zImageValid;
+
+  std::vector<std::vector<CType> *> historyState;
+  SolverCheckpoint *checkpoint;
+  unsigned checkpointInterval;
+  std::string resumeFilename;
+  bool warmStart;
 
 };
 
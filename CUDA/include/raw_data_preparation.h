@@ -83,37 +83,46 @@ class RawDataPreparation
   bool applyChop;
   bool nonuniformData;
 
-  void InitOSRemoval(unsigned width);
+  void RemoveOS(const std::vector<CType> &oversampledData,
+                std::vector<CType> &data, const Dimension &dims);
 
-  void RemoveOS(std::vector<CType> &oversampledLine,
-                std::vector<CType> &croppedLine, unsigned width,
-                unsigned colOffset);
+  bool SkipAcquisition(const AcquisitionHeader &line);
 
-  void ComputePFZeroFillOffset(const Acquisition &line, unsigned centerCol,
-                               unsigned centerRow, unsigned &colOffset,
-                               unsigned &rowOffset, unsigned &lineStart,
-                               unsigned &lineEnd);
+  void ComputePFZeroFillOffset(const AcquisitionHeader &line,
+                               unsigned centerCol, unsigned centerRow,
+                               unsigned &colOffset, unsigned &rowOffset,
+                               unsigned &lineStart, unsigned &lineEnd);
+
+  /**
+   * \brief Returns the linear index of sample (col, row) after ifftshift of
+   * a width x height frame.
+   */
+  unsigned ChopShiftIndex(unsigned col, unsigned row, unsigned width,
+                          unsigned height);
+
+  /**
+   * \brief Copies count samples to row of a width x height frame, starting
+   * at column col. If chop is set, the chop sign (-1)^(x+y) is applied and
+   * each sample is stored at its ifftshifted position.
+   */
+  void ScatterLine(const CType *samples, unsigned count, unsigned col,
+                   unsigned row, unsigned width, unsigned height, bool chop,
+                   CType *frame);
 
   void SetTrajectoryData(Acquisition &line, std::vector<RType> &mask,
                          std::vector<RType> &w, const Dimension &dims,
-                         unsigned maskPhaseOffset, unsigned lineOffset,
+                         unsigned nRO, unsigned maskPhaseOffset, unsigned row,
                          unsigned colOffset);
 
   void SetData(Acquisition &line, std::vector<CType> &data,
-               const Dimension &dims, unsigned phaseOffset, unsigned lineOffset,
-               unsigned colOffset);
+               const Dimension &dims, unsigned nRO, unsigned phaseOffset,
+               unsigned row, unsigned colOffset, bool chop);
 
   void NormalizeData(std::vector<CType> &data, std::vector<RType> &mask,
                      std::vector<RType> &w, Dimension &dims, CType &datanorm);
 
 
-  // Operators/Vectors used in remove oversampling path
-  agile::FFT<CType> *fftOp;
-  agile::FFT<CType> *croppedFftOp;
   RawDataReader *dataReader;
-  std::vector<CType> fullLine;
-  CVector fullLineGPU;
-  CVector croppedLineGPU;
   Dimension rawDataDims;
 };
 
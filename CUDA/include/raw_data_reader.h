@@ -3,18 +3,21 @@
 #define INCLUDE_RAW_DATA_READER_H_
 
 #include "./options_parser.h"
-#include <map>
+#include <vector>
 
 /**
- * \brief
- *
+ * \brief Meta information of a single acquisition
  *
+ * Available without decoding the sample data, used to determine data
+ * dimensions and offsets before the data is read.
  */
-typedef struct Acquisition
+typedef struct AcquisitionHeader
 {
-  std::map<unsigned, std::vector<CType> /*formatter*/> data;
-  std::vector<RType> traj;
-  std::vector<RType> dens;
+  AcquisitionHeader()
+    : line(0), phase(0), slice(0), readouts(0), centerRow(0), centerColumn(0),
+      hasTrajectory(false), isNoiseMeasurement(false)
+  {
+  }
 
   unsigned line;
   unsigned phase;
@@ -24,12 +27,50 @@ typedef struct Acquisition
   unsigned centerRow;
   unsigned centerColumn;
 
+  bool hasTrajectory;
+  bool isNoiseMeasurement;
+} AcquisitionHeader;
+
+/**
+ * \brief Single acquired k-space line of all coils
+ *
+ * The coil data is stored in one contiguous buffer in coil-major order, i.e.
+ * sample s of coil c is located at data[c * samples + s].
+ */
+typedef struct Acquisition : public AcquisitionHeader
+{
+  Acquisition() : coils(0), samples(0)
+  {
+  }
+
+  std::vector<CType> data;
+  std::vector<RType> traj;
+  std::vector<RType> dens;
+
+  unsigned coils;
+  unsigned samples;
+
   bool hasTrajectoryInformation()
   {
     return traj.size() > 0;
   };
 
-  bool isNoiseMeasurement;
+  void resizeData(unsigned coils, unsigned samples)
+  {
+    this->coils = coils;
+    this->samples = samples;
+    data.resize(coils * samples);
+  };
+
+  CType *coilData(unsigned coil)
+  {
+    return &data[coil * samples];
+  };
+
+  const CType *coilData(unsigned coil) const
+  {
+    return &data[coil * samples];
+  };
 } Acquisition;
 
 /**
@@ -51,6 +92,25 @@ class RawDataReader
   virtual unsigned GetNumberOfAcquisitions() const = 0;
   virtual Acquisition GetAcquisition(unsigned index) const = 0;
 
+  /**
+   * \brief Read the consecutive acquisitions [start, start + count) into
+   * acquisitions.
+   *
+   * The default implementation calls GetAcquisition for each index. Readers
+   * with a cheaper bulk access path should override it.
+   */
+  virtual void GetAcquisitions(unsigned start, unsigned count,
+                               std::vector<Acquisition> &acquisitions) const;
+
+  /**
+   * \brief Read the headers of all acquisitions without their sample data.
+   *
+   * The default implementation decodes every acquisition. Readers which can
+   * access the headers separately should override it.
+   */
+  virtual void GetAcquisitionHeaders(
+      std::vector<AcquisitionHeader> &headers) const;
+
   virtual bool IsNonUniformData() const = 0;
   virtual bool IsOversampledData() const = 0;
 
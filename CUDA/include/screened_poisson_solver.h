@@ -0,0 +1,88 @@
+#ifndef INCLUDE_SCREENED_POISSON_SOLVER_H_
+
+#define INCLUDE_SCREENED_POISSON_SOLVER_H_
+
+#include "cufft.h"
+#include "./types.h"
+
+/**
+ * \brief Batched preconditioned CG solver for screened Poisson problems
+ *
+ * Solves \f$(c_k + \mu\nabla^T\nabla)x_k = y_k\f$ for a batch of images
+ * \f$y_k\f$ (e.g. one per coil) with a spatially varying and non-negative
+ * coefficient \f$c_k\f$, which is either common to all images or given per
+ * image. The batch is solved as one block diagonal system.
+ *
+ * The preconditioner is the inverse of the constant coefficient operator
+ * \f$(\bar{c}_k + \mu\nabla^T\nabla)\f$, where \f$\bar{c}_k\f$ is the
+ * mean of \f$c_k\f$. For periodic boundaries it is diagonalized by the 2D
+ * FFT, i.e. it is exact for constant coefficients. For Neumann boundaries the
+ * periodic symbol is used as approximation.
+ */
+class ScreenedPoissonSolver
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] width image width
+   * \param[in] height image height
+   * \param[in] batch number of images solved simultaneously
+   * \param[in] periodic flag to indicate periodic boundary conditions,
+   *otherwise the gradient of utils::Gradient2D is used
+   * */
+  ScreenedPoissonSolver(unsigned width, unsigned height, unsigned batch,
+                        bool periodic);
+
+  virtual ~ScreenedPoissonSolver();
+
+  /** \brief Solve the screened Poisson problem for all images of the batch.
+   *
+   * \param[in] coefficient spatially varying coefficient \f$c\f$, dims:
+   *width * height (common) or width * height * batch (per image)
+   * \param[in] mu weight of the Laplacian
+   * \param[in] rhs right hand sides, dims: width * height * batch
+   * \param[in,out] x initial guess and solution, dims: width * height * batch
+   * \param[in] tolerance relative residual \f$\|r_k\|/\|y\|\f$ to stop at
+   * \param[in] maxIt maximum number of iterations
+   * */
+  void Solve(CVector &coefficient, RType mu, CVector &rhs, CVector &x,
+             RType tolerance, unsigned maxIt);
+
+  /** \brief Apply the system matrix to all images of the batch. */
+  void ApplyOperator(CVector &coefficient, RType mu, CVector &x, CVector &y);
+
+  bool HasConverged() const;
+
+  unsigned GetIterations() const;
+
+  RType GetRelativeResidual() const;
+
+ private:
+  unsigned width;
+  unsigned height;
+  unsigned batch;
+  bool periodic;
+
+  cufftHandle plan;
+
+  /** \brief Inverse symbol of the constant coefficient operator, including
+   * the FFT normalization */
+  CVector symbol;
+
+  CVector gradientX;
+  CVector gradientY;
+  CVector temp;
+
+  bool converged;
+  unsigned iterations;
+  RType relativeResidual;
+
+  /** \brief Offset of the coefficient of the given image */
+  unsigned CoefficientOffset(CVector &coefficient, unsigned image);
+
+  void InitPreconditioner(CVector &coefficient, RType mu);
+
+  void Precondition(CVector &r, CVector &z);
+};
+
+#endif  // INCLUDE_SCREENED_POISSON_SOLVER_H_
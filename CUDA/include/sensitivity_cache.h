@@ -0,0 +1,94 @@
+#ifndef INCLUDE_SENSITIVITY_CACHE_H_
+
+#define INCLUDE_SENSITIVITY_CACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include "./types.h"
+#include "./coil_construction.h"
+
+/** \brief Header of a sensitivity cache file, followed by the b1 and u0
+ * data. */
+typedef struct SensitivityCacheHeader
+{
+  char magic[8];
+  uint64_t key;
+  uint32_t width;
+  uint32_t height;
+  uint32_t coils;
+  uint32_t u0Size;
+} SensitivityCacheHeader;
+
+/**
+ * \brief On-disk cache of coil sensitivities and initial image
+ *
+ * Coil construction only depends on the (prepared) k-space data, the
+ * mask/trajectory and the coil construction parameters, but not on the
+ * reconstruction method or its parameters. The results b1 and u0 are stored
+ * in the cache directory, named by a 64 bit FNV-1a hash of all inputs which
+ * are added to the key, such that re-runs on the same data reuse them.
+ *
+ * Cache files are read memory-mapped and only accepted if key and dimensions
+ * match.
+ */
+class SensitivityCache
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] directory cache directory, an empty string disables the cache
+   * */
+  SensitivityCache(const std::string &directory);
+
+  virtual ~SensitivityCache();
+
+  bool IsEnabled() const;
+
+  /** \brief Add raw bytes to the key. */
+  void AddToKey(const void *data, size_t bytes);
+
+  /** \brief Add the content of a GPU vector to the key. */
+  void AddToKey(CVector &data);
+
+  /** \brief Add the content of a GPU vector to the key. */
+  void AddToKey(RVector &data);
+
+  /** \brief Add all data dimensions to the key. */
+  void AddToKey(const Dimension &dims);
+
+  /** \brief Add all parameters affecting the coil construction result to
+   * the key. */
+  void AddToKey(const CoilConstructionParams &params);
+
+  /** \brief Add a scalar value to the key. */
+  template <typename T> void AddValueToKey(const T &value)
+  {
+    AddToKey(&value, sizeof(T));
+  }
+
+  uint64_t GetKey() const;
+
+  /** \brief Cache file of the current key. */
+  std::string GetFilename() const;
+
+  /** \brief Load cached b1 and u0 of the current key.
+   *
+   * \param[in] dims data dimensions the cache entry has to match
+   * \param[out] b1 coil sensitivities, dims: width * height * coils
+   * \param[out] u0 initial image, dims: width * height
+   * \return true if a valid cache entry was found
+   * */
+  bool Load(const Dimension &dims, CVector &b1, CVector &u0);
+
+  /** \brief Store b1 and u0 under the current key.
+   *
+   * \return true if the cache entry was written
+   * */
+  bool Store(const Dimension &dims, CVector &b1, CVector &u0);
+
+ private:
+  std::string directory;
+  uint64_t key;
+};
+
+#endif  // INCLUDE_SENSITIVITY_CACHE_H_
@@ -3,9 +3,39 @@
 #define INCLUDE_SIEMENS_VD11_READER_H_
 
 #include <string>
-#include "agile/io/readSiemensVD11.hpp"
+#include <vector>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include "../include/raw_data_reader.h"
 
+/**
+ * \brief Index entry of one measurement data header (MDH) scan
+ *
+ * Stores the byte offset of the scan inside the raw data buffer together
+ * with the loop counters needed to place the acquisition, so the channel
+ * data can be decoded lazily on access.
+ */
+typedef struct VD11ScanInfo
+{
+  size_t offset;
+  unsigned evalInfoMask;
+  unsigned short samples;
+  unsigned short channels;
+  unsigned short line;
+  unsigned short partition;
+  unsigned short slice;
+  unsigned short phase;
+  unsigned short centreColumn;
+  unsigned short centreLine;
+} VD11ScanInfo;
+
+/**
+ * \brief Reader for Siemens VD11 raw data (meas.dat)
+ *
+ * The raw data file is memory mapped and indexed in one sequential scan
+ * over the MDH headers. Channel data is only decoded when an acquisition is
+ * requested, which allows O(1) random access as well as sequential
+ * streaming without holding the decoded data set in memory.
+ */
 class SiemensVD11Reader : public RawDataReader
 {
  public:
@@ -19,6 +49,7 @@ class SiemensVD11Reader : public RawDataReader
 
   unsigned GetNumberOfAcquisitions() const;
   Acquisition GetAcquisition(unsigned index) const;
+  void GetAcquisitionHeaders(std::vector<AcquisitionHeader> &headers) const;
 
   bool IsNonUniformData() const;
   bool IsOversampledData() const;
@@ -28,12 +59,34 @@ class SiemensVD11Reader : public RawDataReader
  protected:
   SiemensVD11Reader(OptionsParser &op, const std::string &rawDataPath);
   std::string rawDataPath;
-  agile::ReadSiemensVD11 rawData;
   Dimension rawDataDims;
 
-  std::list<agile::VD11_Image> rawDataList;
+  /**
+   * \brief Build scan index and raw data dimensions from the passed buffer.
+   *
+   * The buffer has to stay valid as long as acquisitions are read. It may
+   * either contain a complete VD11 file including the raid file header or a
+   * plain sequence of MDH scans.
+   */
+  void IndexRawData(const char *buffer, size_t length);
 
   void InitRawDataDimensions();
+
+ private:
+  boost::iostreams::mapped_file_source mappedFile;
+  const char *rawDataBuffer;
+  size_t rawDataLength;
+  std::vector<VD11ScanInfo> scanIndex;
+
+  /** \brief k-space centre of the first imaging scan */
+  unsigned centerRow;
+  unsigned centerColumn;
+
+  size_t FindFirstScanOffset(const char *buffer, size_t length,
+                             size_t &endOffset) const;
+
+  void SetAcquisitionHeader(const VD11ScanInfo &scan,
+                            AcquisitionHeader &header) const;
 };
 
 #endif  // INCLUDE_SIEMENS_VD11_READER_H_
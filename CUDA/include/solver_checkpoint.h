@@ -0,0 +1,106 @@
+#ifndef INCLUDE_SOLVER_CHECKPOINT_H_
+
+#define INCLUDE_SOLVER_CHECKPOINT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include "./types.h"
+
+/** \brief Header of a solver checkpoint file, followed by the scalars
+ * (double), and the vectors and histories (uint64 length, CType data). */
+typedef struct SolverCheckpointHeader
+{
+  char magic[8];
+  uint32_t iteration;
+  uint32_t scalarCount;
+  uint32_t vectorCount;
+  uint32_t historyCount;
+} SolverCheckpointHeader;
+
+/** \brief Host copy of the solver state. */
+typedef struct SolverCheckpointData
+{
+  SolverCheckpointData() : iteration(0)
+  {
+  }
+
+  /** \brief Number of completed iterations */
+  unsigned iteration;
+  /** \brief Step sizes and state of the iteration variants */
+  std::vector<double> scalars;
+  /** \brief Primal and dual variables */
+  std::vector<std::vector<CType> > vectors;
+  /** \brief Export histories, e.g. the PD gap */
+  std::vector<std::vector<CType> > histories;
+} SolverCheckpointData;
+
+/**
+ * \brief Binary checkpoint of the primal-dual solver state
+ *
+ * Writes go to a temporary file which is renamed afterwards, i.e. an
+ * existing checkpoint is only replaced by a complete one. WriteAsync hands
+ * the host data over to a background thread, such that the iteration
+ * continues while the file is written.
+ *
+ * InstallSignalHandler catches SIGTERM (and SIGINT), the solver polls
+ * TerminationRequested, writes a final checkpoint and stops. The handler
+ * is only active for the first signal, a second one terminates the process.
+ */
+class SolverCheckpoint
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] filename checkpoint file
+   * */
+  SolverCheckpoint(const std::string &filename);
+
+  /** \brief Waits for a pending write. */
+  virtual ~SolverCheckpoint();
+
+  const std::string &GetFilename() const;
+
+  /** \brief Write data synchronously.
+   *
+   * \return true if the checkpoint was written
+   */
+  bool Write(const SolverCheckpointData &data);
+
+  /** \brief Write data in the background, data is swapped out (empty
+   * afterwards). Waits for the previous write first. */
+  void WriteAsync(SolverCheckpointData &data);
+
+  /** \brief Wait for a pending write.
+   *
+   * \return true if the last write succeeded
+   */
+  bool Wait();
+
+  /** \brief Read a checkpoint file.
+   *
+   * \return true if a valid checkpoint was read
+   */
+  static bool Read(const std::string &filename, SolverCheckpointData &data);
+
+  /** \brief Catch the first SIGTERM and SIGINT, see
+   * TerminationRequested. */
+  static void InstallSignalHandler();
+
+  /** \brief True, if a termination signal was received. */
+  static bool TerminationRequested();
+
+ private:
+  void WritePending();
+
+  std::string filename;
+
+  SolverCheckpointData pending;
+  boost::thread writer;
+  boost::mutex mutex;
+  bool lastWriteSucceeded;
+};
+
+#endif  // INCLUDE_SOLVER_CHECKPOINT_H_
@@ -0,0 +1,125 @@
+#ifndef INCLUDE_SUBSPACE_OPERATOR_H_
+
+#define INCLUDE_SUBSPACE_OPERATOR_H_
+
+#include <vector>
+#include <cublas_v2.h>
+#include "./base_operator.h"
+#include "./cartesian_operator.h"
+
+/**
+ * \brief Low-rank temporal subspace representation of an MR operator
+ *
+ * The image series is represented by basisSize coefficient images
+ * \f$c_k\f$ and a temporal basis \f$\Phi\f$ (frames x basisSize, orthonormal
+ * columns), i.e. \f$x_t = \sum_k \Phi_{tk} c_k\f$. The operator maps the
+ * coefficient images to the k-space data of all frames of the wrapped
+ * operator, the adjoint projects onto the basis. Solvers are therefore set up
+ * with basisSize instead of frames, which reduces the primal and dual
+ * variables by frames / basisSize.
+ *
+ * For the Cartesian operator the FFTs are applied to the coefficient images
+ * and combined in k-space, i.e. coils * basisSize instead of coils * frames
+ * FFTs per operation. Other operators work on the expanded image series.
+ */
+class SubspaceOperator : public BaseOperator
+{
+ public:
+  /** \brief Constructor.
+   *
+   * \param[in] mrOp wrapped operator of the full image series
+   * \param[in] width image width
+   * \param[in] height image height
+   * \param[in] coils number of coils
+   * \param[in] frames number of frames of the image series
+   * \param[in] basis column major temporal basis, dims: frames * basisSize
+   * \param[in] basisSize number of basis functions
+   * */
+  SubspaceOperator(BaseOperator *mrOp, unsigned width, unsigned height,
+                   unsigned coils, unsigned frames,
+                   const std::vector<CType> &basis, unsigned basisSize);
+
+  virtual ~SubspaceOperator();
+
+  /** \brief Estimate the temporal basis from an image series by SVD.
+   *
+   * The basis consists of the leading right singular vectors of the Casorati
+   * matrix (pixels x frames), e.g. of a low resolution reconstruction.
+   *
+   * \param[in] x image series, dims: N * frames
+   * \param[in] N number of pixels per frame
+   * \param[in] frames number of frames
+   * \param[in] basisSize number of basis functions
+   * \param[out] basis column major temporal basis, dims: frames * basisSize
+   * \return relative energy of x not captured by the basis
+   * */
+  static RType EstimateBasis(CVector &x, unsigned N, unsigned frames,
+                             unsigned basisSize, std::vector<CType> &basis);
+
+  /** \brief Image series of coefficient images.
+   *
+   * \param[in] coefficients dims: width * height * basisSize
+   * \param[out] x image series, dims: width * height * frames
+   * */
+  void Expand(CVector &coefficients, CVector &x);
+
+  /** \brief Projection of an image series onto the basis.
+   *
+   * \param[in] x image series, dims: width * height * frames
+   * \param[out] coefficients dims: width * height * basisSize
+   * */
+  void Project(CVector &x, CVector &coefficients);
+
+  /** \brief Adjoint operation: coefficient images from k-space data
+   *
+   * \param x_gpu k-space data of all frames
+   * \param sum coefficient images, dims: width * height * basisSize
+   * \param b1_gpu coil sensitivities, dims: width * height * coils
+   * */
+  void ForwardOperation(CVector &x_gpu, CVector &sum, CVector &b1_gpu);
+
+  CVector ForwardOperation(CVector &x_gpu, CVector &b1_gpu);
+
+  /** \brief Operation: k-space data of all frames from coefficient images
+   *
+   * \param x_gpu coefficient images, dims: width * height * basisSize
+   * \param z_gpu k-space data of all frames
+   * \param b1_gpu coil sensitivities, dims: width * height * coils
+   * */
+  void BackwardOperation(CVector &x_gpu, CVector &z_gpu, CVector &b1_gpu);
+
+  CVector BackwardOperation(CVector &x_gpu, CVector &b1_gpu);
+
+  /** \brief Lambda of the wrapped operator */
+  RType AdaptLambda(RType k, RType d);
+
+  unsigned GetBasisSize() const;
+
+ private:
+  void CartesianForward(CVector &x_gpu, CVector &sum, CVector &b1_gpu);
+
+  void CartesianBackward(CVector &x_gpu, CVector &z_gpu, CVector &b1_gpu);
+
+  BaseOperator *mrOp;
+  /** \brief Wrapped operator, if Cartesian */
+  CartesianOperator *cartOp;
+
+  /** \brief Frames of the image series (frames holds the basis size) */
+  unsigned seriesFrames;
+
+  /** \brief Temporal basis, dims: seriesFrames * frames */
+  CVector basis;
+  /** \brief Conjugate temporal basis, used in projections */
+  CVector conjBasis;
+
+  /** \brief Image series or k-space of one coil, dims: width * height *
+   * seriesFrames */
+  CVector series;
+  /** \brief Coefficient images or their k-space of one coil */
+  CVector coefficientTemp;
+  CVector imageTemp;
+
+  cublasHandle_t handle;
+};
+
+#endif  // INCLUDE_SUBSPACE_OPERATOR_H_
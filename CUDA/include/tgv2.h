@@ -85,6 +85,19 @@ class TGV2 : public PDRecon
   std::vector<CVector> div2Temp;
   std::vector<CVector> y1Temp;
   std::vector<CVector> y2Temp;
+
+  /** \brief Initialize the step sizes of all blocks, i.e. the scalar sigma
+   * and tau or the diagonally preconditioned steps */
+  void InitSteps(CVector &b1, unsigned dataSize);
+
+  void ScaleSteps(RType factor);
+
+  // step sizes
+  std::vector<RType> sigmaY1;
+  std::vector<RType> sigmaY2;
+  RType sigmaZ;
+  std::vector<RType> tauX2;
+  CVector tauX1;
 };
 
 #endif  // INCLUDE_TGV2_H_
@@ -74,6 +74,18 @@ class TGV2_3D : public PDRecon
 
   std::vector<CType> pdGapExport;
 
+  /** \brief Initialize the step sizes of all blocks, i.e. the scalar sigma
+   * and tau or the diagonally preconditioned steps */
+  void InitSteps(CVector &b1, unsigned dataSize);
+
+  void ScaleSteps(RType factor);
+
+  // step sizes
+  std::vector<RType> sigmaY1;
+  std::vector<RType> sigmaY2;
+  RType sigmaZ;
+  std::vector<RType> tauX2;
+  CVector tauX1;
 };
 
 #endif  // INCLUDE_TGV2_3D_H_
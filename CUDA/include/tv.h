@@ -82,6 +82,17 @@ class TV : public PDRecon
   CVector imgTemp;
   CVector divTemp;
   CVector zTemp;
+
+  /** \brief Initialize the step sizes of all blocks, i.e. the scalar sigma
+   * and tau or the diagonally preconditioned steps */
+  void InitSteps(CVector &b1, unsigned dataSize);
+
+  void ScaleSteps(RType factor);
+
+  // step sizes
+  std::vector<RType> sigmaY;
+  RType sigmaZ;
+  CVector tauX;
 };
 
 #endif  // INCLUDE_TV_H_
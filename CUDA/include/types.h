@@ -4,6 +4,7 @@
 
 #include <complex>
 #include "agile/gpu_vector.hpp"
+#include "./gpu_vector_view.h"
 
 /** \file Type defs used in AVIONIC reconstruction. */
 
@@ -22,6 +23,12 @@ typedef DType RType;
 /** \brief Real gpu vector type definition */
 typedef agile::GPUVector<RType> RVector;
 
+/** \brief Complex gpu vector view type definition */
+typedef GPUVectorView<CType> CVectorView;
+
+/** \brief Real gpu vector view type definition */
+typedef GPUVectorView<RType> RVectorView;
+
 /**
  * \brief Dimension option struct
  *
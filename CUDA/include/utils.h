@@ -85,6 +85,25 @@ void Gradient2D(CVector &data_gpu, std::vector<CVector> &gradient,
                 unsigned width, unsigned height, DType dx = 1.0,
                 DType dy = 1.0);
 
+/** \brief Compute 2-d gradient for given image data view, e.g. one coil
+ *slice of a stacked vector.
+ *
+ * The view may cover several stacked width*height slices, e.g. all coils.
+ *The differences of all slices are computed in one pass without coupling
+ *between slices.
+ *
+ * \param[in] data 2-d data view, dim width*height*slices, all views have to
+ *be contiguous
+ * \param[in] width
+ * \param[in] height
+ * \param[in] dx Step size in x dim
+ * \param[in] dy Step size in y dim
+ * \param[out] gradient views of the components (dx,dy)
+ * */
+void Gradient2D(const CVectorView &data,
+                const std::vector<CVectorView> &gradient, unsigned width,
+                unsigned height, DType dx = 1.0, DType dy = 1.0);
+
 /** \brief Compute 2-d gradient for given image data vector.
  *
  * \param[in] data_gpu 2-d data vector, dim width*height*frames
@@ -314,6 +333,24 @@ void Divergence2D(std::vector<CVector> &gradient, CVector &divergence,
                   unsigned width, unsigned height, DType dx = 1.0,
                   DType dy = 1.0);
 
+/** \brief Compute 2-d divergence for given gradient views, e.g. one coil
+ *slice of stacked gradient vectors.
+ *
+ * As for Gradient2D, the views may cover several stacked width*height
+ *slices, which are processed in one pass without coupling between slices.
+ *
+ * \param[in] gradient views of the 2-d gradient (dx,dy)
+ * \param[in] width
+ * \param[in] height
+ * \param[in] dx Step size in x dim
+ * \param[in] dy Step size in y dim
+ * \param[out] divergence view of the computed divergence, all views have to
+ *be contiguous
+ * */
+void Divergence2D(const std::vector<CVectorView> &gradient,
+                  const CVectorView &divergence, unsigned width,
+                  unsigned height, DType dx = 1.0, DType dy = 1.0);
+
 /** \brief Compute 2-d divergence with backward differences for given 2-d
  *component vector (i.e. gradient).
  *
@@ -727,6 +764,72 @@ void SetSubVector(CVector &stride, CVector &full, unsigned index,
                   unsigned strideLength);
 
 
+/**
+ * \brief Extract the central region of non-centered k-space data
+ *
+ * Each of the count images is stored row major (height x width) with the
+ * k-space origin at index 0, i.e. after ifftshift. The central lowWidth x
+ * lowHeight region is copied to the same non-centered layout of the smaller
+ * grid.
+ *
+ * \param[in] full k-space data, dims: width * height * count
+ * \param[out] low cropped k-space data, dims: lowWidth * lowHeight * count
+ * \param[in] width
+ * \param[in] height
+ * \param[in] lowWidth even width of cropped grid
+ * \param[in] lowHeight even height of cropped grid
+ * \param[in] count number of images
+ */
+void CropKSpaceCenter(CVector &full, CVector &low, unsigned width,
+                      unsigned height, unsigned lowWidth, unsigned lowHeight,
+                      unsigned count);
+
+/**
+ * \brief Extract the central region of a non-centered k-space mask
+ *
+ * \see CropKSpaceCenter(CVector&, CVector&, unsigned, unsigned, unsigned,
+ * unsigned, unsigned)
+ */
+void CropKSpaceCenter(RVector &full, RVector &low, unsigned width,
+                      unsigned height, unsigned lowWidth, unsigned lowHeight,
+                      unsigned count);
+
+/**
+ * \brief Band-limited interpolation of images by zero-padding in k-space
+ *
+ * Image amplitudes are preserved.
+ *
+ * \param[in] low low resolution images, dims: lowWidth * lowHeight * count
+ * \param[out] full interpolated images, dims: width * height * count
+ * \param[in] lowWidth
+ * \param[in] lowHeight
+ * \param[in] width
+ * \param[in] height
+ * \param[in] count number of images
+ */
+void UpsampleImages(CVector &low, CVector &full, unsigned lowWidth,
+                    unsigned lowHeight, unsigned width, unsigned height,
+                    unsigned count);
+
+/**
+ * \brief Band-limited downsampling of images by cropping the k-space centre
+ *
+ * Image amplitudes are preserved.
+ *
+ * \see UpsampleImages
+ *
+ * \param[in] full images, dims: width * height * count
+ * \param[out] low downsampled images, dims: lowWidth * lowHeight * count
+ * \param[in] width
+ * \param[in] height
+ * \param[in] lowWidth
+ * \param[in] lowHeight
+ * \param[in] count number of images
+ */
+void DownsampleImages(CVector &full, CVector &low, unsigned width,
+                      unsigned height, unsigned lowWidth, unsigned lowHeight,
+                      unsigned count);
+
 /**
  * \brief Get CFL file header information
 */
@@ -0,0 +1,88 @@
+#include "../include/acquisition_stream.h"
+#include <algorithm>
+#include <stdexcept>
+
+AcquisitionStream::AcquisitionStream(const RawDataReader *reader,
+                                     unsigned blockSize,
+                                     unsigned maxQueuedBlocks)
+  : reader(reader), blockSize(std::max(1u, blockSize)),
+    maxQueuedBlocks(std::max(1u, maxQueuedBlocks)),
+    numberOfAcquisitions(reader->GetNumberOfAcquisitions()), finished(false),
+    aborted(false)
+{
+}
+
+AcquisitionStream::~AcquisitionStream()
+{
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    aborted = true;
+  }
+  queueNotFull.notify_all();
+  if (producer.joinable())
+    producer.join();
+}
+
+void AcquisitionStream::Start()
+{
+  producer = boost::thread(&AcquisitionStream::ReadBlocks, this);
+}
+
+unsigned AcquisitionStream::GetNumberOfAcquisitions() const
+{
+  return numberOfAcquisitions;
+}
+
+void AcquisitionStream::ReadBlocks()
+{
+  try
+  {
+    for (unsigned start = 0; start < numberOfAcquisitions; start += blockSize)
+    {
+      std::vector<Acquisition> block;
+      reader->GetAcquisitions(
+          start, std::min(blockSize, numberOfAcquisitions - start), block);
+
+      boost::mutex::scoped_lock lock(mutex);
+      while (queue.size() >= maxQueuedBlocks && !aborted)
+        queueNotFull.wait(lock);
+
+      if (aborted)
+        return;
+
+      // swap into queue to avoid copying the decoded data
+      queue.push_back(std::vector<Acquisition>());
+      queue.back().swap(block);
+      queueNotEmpty.notify_one();
+    }
+  }
+  catch (const std::exception &e)
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    errorMessage = e.what();
+  }
+
+  boost::mutex::scoped_lock lock(mutex);
+  finished = true;
+  queueNotEmpty.notify_one();
+}
+
+bool AcquisitionStream::NextBlock(std::vector<Acquisition> &block)
+{
+  boost::mutex::scoped_lock lock(mutex);
+  while (queue.empty() && !finished)
+    queueNotEmpty.wait(lock);
+
+  if (!queue.empty())
+  {
+    block.swap(queue.front());
+    queue.pop_front();
+    queueNotFull.notify_one();
+    return true;
+  }
+
+  if (!errorMessage.empty())
+    throw std::runtime_error("AcquisitionStream: reading raw data failed: " +
+                             errorMessage);
+  return false;
+}
@@ -0,0 +1,147 @@
+#include "../include/anderson_acceleration.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "agile/agile.hpp"
+
+AndersonAcceleration::AndersonAcceleration(unsigned depth, unsigned size)
+  : depth(depth), size(size), u(size), f(size), fLast(size), gLast(size),
+    gram(depth * depth, 0), rhs(depth, 0), count(0), next(0),
+    hasInput(false), hasLast(false)
+{
+  for (unsigned cnt = 0; cnt < depth; cnt++)
+  {
+    deltaF.push_back(CVector(size));
+    deltaG.push_back(CVector(size));
+  }
+}
+
+AndersonAcceleration::~AndersonAcceleration()
+{
+}
+
+unsigned AndersonAcceleration::GetDepth() const
+{
+  return depth;
+}
+
+unsigned AndersonAcceleration::GetHistorySize() const
+{
+  return count;
+}
+
+void AndersonAcceleration::Reset()
+{
+  count = 0;
+  next = 0;
+  hasInput = false;
+  hasLast = false;
+}
+
+bool AndersonAcceleration::SolveCoefficients(std::vector<RType> &gamma)
+{
+  unsigned n = count;
+  for (unsigned i = 0; i < n; i++)
+    rhs[i] = std::real(agile::getScalarProduct(deltaF[i], f));
+
+  // regularized normal equations, solved by Gaussian elimination
+  RType maxDiag = 0;
+  for (unsigned i = 0; i < n; i++)
+    maxDiag = std::max(maxDiag, gram[i * depth + i]);
+  if (maxDiag <= 0)
+    return false;
+
+  std::vector<double> A(n * n), b(n);
+  for (unsigned i = 0; i < n; i++)
+  {
+    for (unsigned j = 0; j < n; j++)
+      A[i * n + j] = gram[i * depth + j];
+    A[i * n + i] += 1E-8 * maxDiag;
+    b[i] = rhs[i];
+  }
+
+  for (unsigned col = 0; col < n; col++)
+  {
+    unsigned pivot = col;
+    for (unsigned row = col + 1; row < n; row++)
+      if (std::abs(A[row * n + col]) > std::abs(A[pivot * n + col]))
+        pivot = row;
+    if (std::abs(A[pivot * n + col]) < 1E-12 * maxDiag)
+      return false;
+
+    if (pivot != col)
+    {
+      for (unsigned j = 0; j < n; j++)
+        std::swap(A[col * n + j], A[pivot * n + j]);
+      std::swap(b[col], b[pivot]);
+    }
+
+    for (unsigned row = col + 1; row < n; row++)
+    {
+      double factor = A[row * n + col] / A[col * n + col];
+      for (unsigned j = col; j < n; j++)
+        A[row * n + j] -= factor * A[col * n + j];
+      b[row] -= factor * b[col];
+    }
+  }
+
+  gamma.assign(n, 0);
+  for (int row = n - 1; row >= 0; row--)
+  {
+    double sum = b[row];
+    for (unsigned j = row + 1; j < n; j++)
+      sum -= A[row * n + j] * gamma[j];
+    gamma[row] = sum / A[row * n + row];
+    if (!(std::abs(gamma[row]) < 1E6))
+      return false;
+  }
+  return true;
+}
+
+bool AndersonAcceleration::Update(CVector &g)
+{
+  if (g.size() != size)
+    throw std::invalid_argument(
+        "AndersonAcceleration: state does not match history size");
+
+  if (!hasInput)
+  {
+    agile::copy(g, u);
+    hasInput = true;
+    return false;
+  }
+
+  // f_k = T(u_k) - u_k
+  agile::subVector(g, u, f);
+
+  if (hasLast)
+  {
+    agile::subVector(f, fLast, deltaF[next]);
+    agile::subVector(g, gLast, deltaG[next]);
+    if (count < depth)
+      count++;
+
+    for (unsigned j = 0; j < count; j++)
+    {
+      RType value = std::real(agile::getScalarProduct(deltaF[next], deltaF[j]));
+      gram[next * depth + j] = value;
+      gram[j * depth + next] = value;
+    }
+    next = (next + 1) % depth;
+  }
+  agile::copy(f, fLast);
+  agile::copy(g, gLast);
+  hasLast = true;
+
+  bool accelerated = false;
+  std::vector<RType> gamma;
+  if (count > 0 && SolveCoefficients(gamma))
+  {
+    // u_k+1 = T(u_k) - dG gamma
+    for (unsigned cnt = 0; cnt < count; cnt++)
+      agile::subScaledVector(g, gamma[cnt], deltaG[cnt], g);
+    accelerated = true;
+  }
+  agile::copy(g, u);
+  return accelerated;
+}
@@ -1,12 +1,40 @@
 #include "../include/base_operator.h"
+#include <stdexcept>
 
 BaseOperator::BaseOperator(unsigned width, unsigned height, unsigned depth, unsigned coils,
                            unsigned frames)
   : width(width), height(height), depth(depth), coils(coils), frames(frames)
 {
+  SetCoilSubset(std::vector<unsigned>());
 }
 
 BaseOperator::~BaseOperator()
 {
 }
 
+bool BaseOperator::SupportsCoilSubsets() const
+{
+  return false;
+}
+
+void BaseOperator::SetCoilSubset(const std::vector<unsigned> &subset)
+{
+  activeCoils.clear();
+  if (subset.empty())
+  {
+    for (unsigned coil = 0; coil < coils; coil++)
+      activeCoils.push_back(coil);
+    return;
+  }
+
+  if (!SupportsCoilSubsets())
+    throw std::invalid_argument(
+        "BaseOperator: coil subsets not supported by operator");
+
+  for (unsigned cnt = 0; cnt < subset.size(); cnt++)
+  {
+    if (subset[cnt] >= coils)
+      throw std::invalid_argument("BaseOperator: invalid coil index");
+    activeCoils.push_back(subset[cnt]);
+  }
+}
@@ -1,4 +1,5 @@
 #include "../include/cartesian_coil_construction.h"
+#include <algorithm>
 
 CartesianCoilConstruction::CartesianCoilConstruction(unsigned width,
                                                      unsigned height,
@@ -79,3 +80,46 @@ void CartesianCoilConstruction::TimeAveragedReconstruction(CVector &kdata,
   }
 }
 
+
+void CartesianCoilConstruction::PerformLowResCoilConstruction(
+    unsigned width, unsigned height, unsigned coils, unsigned frames,
+    CoilConstructionParams &params, CVector &kdata, RVector &mask, CVector &u,
+    CVector &b1, communicator_type &com, bool verbose)
+{
+  unsigned factor = params.lowResFactor;
+  unsigned lowWidth = 2 * std::max(1u, width / (2 * factor));
+  unsigned lowHeight = 2 * std::max(1u, height / (2 * factor));
+  unsigned N = width * height;
+  unsigned lowN = lowWidth * lowHeight;
+  std::cout << "Low resolution coil construction on " << lowWidth << "x"
+            << lowHeight << " grid." << std::endl;
+
+  CVector lowKdata(lowN * coils * frames);
+  utils::CropKSpaceCenter(kdata, lowKdata, width, height, lowWidth, lowHeight,
+                          coils * frames);
+  RVector lowMask(lowN * frames);
+  utils::CropKSpaceCenter(mask, lowMask, width, height, lowWidth, lowHeight,
+                          frames);
+
+  // keep image amplitudes and correct the chop sign of the cropped grid
+  RType sign = ((width / 2 - lowWidth / 2) + (height / 2 - lowHeight / 2)) %
+                           2 == 0 ? 1.0 : -1.0;
+  agile::scale((CType)(sign * std::sqrt((RType)lowN / (RType)N)), lowKdata,
+               lowKdata);
+
+  CartesianOperator *cartOp =
+      new CartesianOperator(lowWidth, lowHeight, coils, frames, lowMask, false);
+  CartesianCoilConstruction coilConstruction(lowWidth, lowHeight, coils,
+                                             frames, params, cartOp);
+  coilConstruction.SetVerbose(verbose);
+
+  CVector lowU(lowN * coils);
+  lowU.assign(lowU.size(), 0.0);
+  CVector lowB1(lowN * coils);
+  lowB1.assign(lowB1.size(), 1.0);
+  coilConstruction.PerformCoilConstruction(lowKdata, lowU, lowB1, com);
+  delete cartOp;
+
+  utils::UpsampleImages(lowB1, b1, lowWidth, lowHeight, width, height, coils);
+  utils::UpsampleImages(lowU, u, lowWidth, lowHeight, width, height, coils);
+}
@@ -44,6 +44,11 @@ void CartesianOperator::Init()
   fftOp = new agile::FFT<CType>(height, width);
 }
 
+bool CartesianOperator::SupportsCoilSubsets() const
+{
+  return true;
+}
+
 RType CartesianOperator::AdaptLambda(RType k, RType d)
 {
   RType lambda = 0.0;
@@ -75,8 +80,9 @@ void CartesianOperator::ForwardOperation(CVector &x_gpu, CVector &sum,
   {
     unsigned offset = width * height * coils * frame;
 
-    for (unsigned coil = 0; coil < coils; coil++)
+    for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
     {
+      unsigned coil = activeCoils[cnt];
       unsigned int x_offset = offset + coil * width * height;
 
       if (!mask.empty())
@@ -127,8 +133,9 @@ void CartesianOperator::BackwardOperation(CVector &x_gpu, CVector &z_gpu,
   {
     unsigned offset = width * height * frame;
 
-    for (unsigned coil = 0; coil < coils; coil++)
+    for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
     {
+      unsigned coil = activeCoils[cnt];
       // apply b1 map
       agile::lowlevel::multiplyElementwise(
           x_gpu.data() + offset, b1_gpu.data() + coil * width * height,
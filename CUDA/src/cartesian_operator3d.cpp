@@ -44,6 +44,11 @@ void CartesianOperator3D::Init()
 //  cres = cufftPlan3d(&fftplan3d, width, height, depth, CUFFT_C2C);
 }
 
+bool CartesianOperator3D::SupportsCoilSubsets() const
+{
+  return true;
+}
+
 RType CartesianOperator3D::AdaptLambda(RType k, RType d)
 {
   RType lambda = 0.0;
@@ -75,8 +80,9 @@ void CartesianOperator3D::ForwardOperation(CVector &x_gpu, CVector &sum,
   sum.assign(N, 0.0);
 
   // perform forward operation
-  for (unsigned coil = 0; coil < coils; coil++)
+  for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
   {
+    unsigned coil = activeCoils[cnt];
     unsigned int offset = coil * N;
  
     if (!mask.empty())
@@ -145,8 +151,9 @@ void CartesianOperator3D::BackwardOperation(CVector &x_gpu, CVector &z_gpu,
   cres = cufftPlan3d(&fftplan3d, depth, height, width, CUFFT_C2C);
  
   // perform backward operation
-  for (unsigned coil = 0; coil < coils; coil++)
+  for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
   {
+    unsigned coil = activeCoils[cnt];
     unsigned offset = coil * N;
     // apply b1 map
     agile::lowlevel::multiplyElementwise(
@@ -180,9 +187,11 @@ void CartesianOperator3D::BackwardOperation(CVector &x_gpu, CVector &z_gpu,
       z_gpu.data() + offset, mask.data() ,
       z_gpu.data() + offset, N);
     }
-    
+
+    // only the selected coils
+    agile::lowlevel::scale((CType)(1.0 / std::sqrt(N)), z_gpu.data() + offset,
+                           z_gpu.data() + offset, N);
   }
- agile::scale((CType)(1.0 / std::sqrt(N)), z_gpu, z_gpu);
     
 cufftDestroy(fftplan3d);
 }
@@ -0,0 +1,465 @@
+#include "../include/coil_compression.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <cuda_runtime.h>
+#include "agile/agile.hpp"
+#include "agile/calc/fft.hpp"
+
+CoilCompression::CoilCompression(const CoilCompressionParams &params)
+  : params(params), verbose(false), coils(0), virtualCoils(0),
+    compressionError(0)
+{
+}
+
+CoilCompression::~CoilCompression()
+{
+}
+
+bool CoilCompression::IsEnabled(const CoilCompressionParams &params)
+{
+  return params.virtualCoils > 0 || params.energyThreshold < 1.0;
+}
+
+void CoilCompression::SetVerbose(bool verbose)
+{
+  this->verbose = verbose;
+}
+
+unsigned CoilCompression::GetVirtualCoils() const
+{
+  return virtualCoils;
+}
+
+RType CoilCompression::GetCompressionError() const
+{
+  return compressionError;
+}
+
+RType CoilCompression::GetEstimatedSpeedup() const
+{
+  if (virtualCoils == 0)
+    return 1.0;
+  return (RType)coils / (RType)virtualCoils;
+}
+
+void CoilCompression::HermitianEigen(const std::vector<CType> &matrix,
+                                     unsigned n,
+                                     std::vector<RType> &eigenvalues,
+                                     std::vector<CType> &eigenvectors)
+{
+  std::vector<CType> a(matrix);
+  eigenvectors.assign(n * n, 0);
+  for (unsigned i = 0; i < n; i++)
+    eigenvectors[i + i * n] = 1.0;
+
+  for (unsigned sweep = 0; sweep < 50; sweep++)
+  {
+    RType offDiag = 0, diag = 0;
+    for (unsigned q = 0; q < n; q++)
+    {
+      diag += std::norm(a[q + q * n]);
+      for (unsigned p = 0; p < q; p++)
+        offDiag += std::norm(a[p + q * n]);
+    }
+    if (offDiag <= 1E-14 * diag)
+      break;
+
+    for (unsigned p = 0; p < n; p++)
+      for (unsigned q = p + 1; q < n; q++)
+      {
+        RType absApq = std::abs(a[p + q * n]);
+        if (absApq == 0)
+          continue;
+
+        // unitary phase transform, such that a(p,q) becomes real
+        CType phase = a[p + q * n] / absApq;
+        for (unsigned k = 0; k < n; k++)
+        {
+          a[k + q * n] *= std::conj(phase);
+          eigenvectors[k + q * n] *= std::conj(phase);
+        }
+        for (unsigned k = 0; k < n; k++)
+          a[q + k * n] *= phase;
+
+        // real Jacobi rotation annihilating a(p,q)
+        RType theta = (std::real(a[q + q * n]) - std::real(a[p + p * n])) /
+                      (2.0 * absApq);
+        RType t = (theta >= 0 ? 1.0 : -1.0) /
+                  (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+        RType c = 1.0 / std::sqrt(t * t + 1.0);
+        RType s = t * c;
+
+        for (unsigned k = 0; k < n; k++)
+        {
+          CType akp = a[k + p * n];
+          CType akq = a[k + q * n];
+          a[k + p * n] = c * akp - s * akq;
+          a[k + q * n] = s * akp + c * akq;
+
+          CType vkp = eigenvectors[k + p * n];
+          CType vkq = eigenvectors[k + q * n];
+          eigenvectors[k + p * n] = c * vkp - s * vkq;
+          eigenvectors[k + q * n] = s * vkp + c * vkq;
+        }
+        for (unsigned k = 0; k < n; k++)
+        {
+          CType apk = a[p + k * n];
+          CType aqk = a[q + k * n];
+          a[p + k * n] = c * apk - s * aqk;
+          a[q + k * n] = s * apk + c * aqk;
+        }
+      }
+  }
+
+  // sort eigenpairs in descending order
+  std::vector<std::pair<RType, unsigned> > order(n);
+  for (unsigned i = 0; i < n; i++)
+    order[i] = std::make_pair(std::real(a[i + i * n]), i);
+  std::sort(order.begin(), order.end(),
+            std::greater<std::pair<RType, unsigned> >());
+
+  std::vector<CType> sorted(n * n);
+  eigenvalues.resize(n);
+  for (unsigned i = 0; i < n; i++)
+  {
+    eigenvalues[i] = order[i].first;
+    std::copy(eigenvectors.begin() + order[i].second * n,
+              eigenvectors.begin() + (order[i].second + 1) * n,
+              sorted.begin() + i * n);
+  }
+  eigenvectors.swap(sorted);
+}
+
+unsigned CoilCompression::SelectVirtualCoils(
+    const std::vector<RType> &eigenvalues)
+{
+  unsigned n = eigenvalues.size();
+  if (params.virtualCoils > 0)
+    return std::min(params.virtualCoils, n);
+
+  RType total = 0;
+  for (unsigned i = 0; i < n; i++)
+    total += std::max(eigenvalues[i], (RType)0);
+
+  RType retained = 0;
+  for (unsigned i = 0; i < n; i++)
+  {
+    retained += std::max(eigenvalues[i], (RType)0);
+    if (retained >= params.energyThreshold * total)
+      return i + 1;
+  }
+  return n;
+}
+
+RType CoilCompression::DiscardedEnergy(const std::vector<RType> &eigenvalues,
+                                       unsigned nVirtual)
+{
+  RType discarded = 0;
+  for (unsigned i = nVirtual; i < eigenvalues.size(); i++)
+    discarded += std::max(eigenvalues[i], (RType)0);
+  return discarded;
+}
+
+void CoilCompression::Compress(CVector &kdata, Dimension &dims,
+                               bool cartesian)
+{
+  coils = dims.coils;
+
+  cublasHandle_t handle;
+  cublasStatus_t status = cublasCreate(&handle);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during cuBLAS initialization"));
+
+  bool geometric = params.geometric && cartesian &&
+                   kdata.size() == dims.width * dims.height * dims.coils *
+                                       dims.frames;
+  if (params.geometric && !geometric)
+    std::cout << "Geometric coil compression requires Cartesian data, "
+                 "falling back to SVD compression." << std::endl;
+
+  if (geometric)
+    CompressGeometric(kdata, dims, handle);
+  else
+    CompressUniform(kdata, dims, handle);
+
+  cublasDestroy(handle);
+
+  dims.coils = virtualCoils;
+  std::cout << "Coil compression (" << (geometric ? "geometric" : "SVD")
+            << "): " << coils << " -> " << virtualCoils
+            << " virtual coils, relative error: " << compressionError
+            << ", estimated speedup: " << GetEstimatedSpeedup() << std::endl;
+}
+
+void CoilCompression::CompressUniform(CVector &kdata, Dimension &dims,
+                                      cublasHandle_t handle)
+{
+  unsigned samples = kdata.size() / (coils * dims.frames);
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  cublasStatus_t status;
+
+  // channel covariance accumulated over all frames
+  CVector covGPU(coils * coils);
+  covGPU.assign(covGPU.size(), 0);
+  for (unsigned frame = 0; frame < dims.frames; frame++)
+  {
+    cuComplex *frameData =
+        (cuComplex *)kdata.data() + frame * samples * coils;
+    status = cublasCgemm(handle, CUBLAS_OP_C, CUBLAS_OP_N, coils, coils,
+                         samples, &one, frameData, samples, frameData,
+                         samples, &one, (cuComplex *)covGPU.data(), coils);
+    AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during covariance computation"));
+  }
+
+  std::vector<CType> cov;
+  covGPU.copyToHost(cov);
+  std::vector<RType> eigenvalues;
+  std::vector<CType> eigenvectors;
+  HermitianEigen(cov, coils, eigenvalues, eigenvectors);
+
+  virtualCoils = SelectVirtualCoils(eigenvalues);
+  RType total = DiscardedEnergy(eigenvalues, 0);
+  compressionError =
+      total > 0 ? std::sqrt(DiscardedEnergy(eigenvalues, virtualCoils) / total)
+                : 0;
+
+  if (verbose)
+  {
+    std::cout << "Coil covariance eigenvalues:";
+    for (unsigned i = 0; i < coils; i++)
+      std::cout << " " << eigenvalues[i];
+    std::cout << std::endl;
+  }
+
+  // virtual coil v = sum_c conj(u_cv) * coil c
+  std::vector<CType> weights(coils * virtualCoils);
+  for (unsigned i = 0; i < weights.size(); i++)
+    weights[i] = std::conj(eigenvectors[i]);
+  CVector weightsGPU(weights.size());
+  weightsGPU.assignFromHost(weights.begin(), weights.end());
+
+  CVector compressed(samples * virtualCoils * dims.frames);
+  for (unsigned frame = 0; frame < dims.frames; frame++)
+  {
+    status = cublasCgemm(
+        handle, CUBLAS_OP_N, CUBLAS_OP_N, samples, virtualCoils, coils, &one,
+        (cuComplex *)kdata.data() + frame * samples * coils, samples,
+        (cuComplex *)weightsGPU.data(), coils, &zero,
+        (cuComplex *)compressed.data() + frame * samples * virtualCoils,
+        samples);
+    AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during coil compression"));
+  }
+  kdata = compressed;
+}
+
+void CoilCompression::ToHybridSpace(const CType *frame, CVector &kspace,
+                                    CVector &hybrid, unsigned width,
+                                    unsigned height, unsigned nCoils,
+                                    cufftHandle plan, cublasHandle_t handle)
+{
+  // inverse transform along readout, out of place
+  cufftResult cres =
+      cufftExecC2C(plan, (cufftComplex *)frame,
+                   (cufftComplex *)kspace.data(), CUFFT_INVERSE);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during FFT procedure"));
+
+  // transpose (coil, y, x) -> (x, coil, y), such that each readout position
+  // forms a contiguous height x coils matrix
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  cublasStatus_t status = cublasCgeam(
+      handle, CUBLAS_OP_T, CUBLAS_OP_N, height * nCoils, width, &one,
+      (cuComplex *)kspace.data(), width, &zero, (cuComplex *)hybrid.data(),
+      height * nCoils, (cuComplex *)hybrid.data(), height * nCoils);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during hybrid space transpose"));
+}
+
+void CoilCompression::AlignCompressionMatrix(
+    const std::vector<CType> &previous, std::vector<CType> &current)
+{
+  // rotate current virtual coils onto previous ones,
+  // Q = P (P^H P)^(-1/2) with P = current^H previous
+  unsigned nv = virtualCoils;
+  std::vector<CType> p(nv * nv, 0), g(nv * nv, 0);
+  for (unsigned j = 0; j < nv; j++)
+    for (unsigned i = 0; i < nv; i++)
+      for (unsigned c = 0; c < coils; c++)
+        p[i + j * nv] +=
+            std::conj(current[c + i * coils]) * previous[c + j * coils];
+
+  for (unsigned j = 0; j < nv; j++)
+    for (unsigned i = 0; i < nv; i++)
+      for (unsigned k = 0; k < nv; k++)
+        g[i + j * nv] += std::conj(p[k + i * nv]) * p[k + j * nv];
+
+  std::vector<RType> s2;
+  std::vector<CType> b;
+  HermitianEigen(g, nv, s2, b);
+
+  std::vector<CType> gInvSqrt(nv * nv, 0);
+  for (unsigned k = 0; k < nv; k++)
+  {
+    if (s2[k] <= 1E-12 * s2[0])
+      continue;
+    RType scale = 1.0 / std::sqrt(s2[k]);
+    for (unsigned j = 0; j < nv; j++)
+      for (unsigned i = 0; i < nv; i++)
+        gInvSqrt[i + j * nv] +=
+            b[i + k * nv] * scale * std::conj(b[j + k * nv]);
+  }
+
+  std::vector<CType> q(nv * nv, 0);
+  for (unsigned j = 0; j < nv; j++)
+    for (unsigned i = 0; i < nv; i++)
+      for (unsigned k = 0; k < nv; k++)
+        q[i + j * nv] += p[i + k * nv] * gInvSqrt[k + j * nv];
+
+  std::vector<CType> aligned(coils * nv, 0);
+  for (unsigned j = 0; j < nv; j++)
+    for (unsigned c = 0; c < coils; c++)
+      for (unsigned k = 0; k < nv; k++)
+        aligned[c + j * coils] += current[c + k * coils] * q[k + j * nv];
+  current.swap(aligned);
+}
+
+void CoilCompression::CompressGeometric(CVector &kdata, Dimension &dims,
+                                        cublasHandle_t handle)
+{
+  unsigned width = dims.width;
+  unsigned height = dims.height;
+  unsigned N = width * height;
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  cublasStatus_t status;
+  cufftResult cres;
+
+  cufftHandle plan;
+  cres = cufftPlan1d(&plan, width, CUFFT_C2C, height * coils);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage("Error during FFT plan"));
+
+  CVector kspace(N * coils);
+  CVector hybrid(N * coils);
+
+  // channel covariance for each readout position
+  CVector covGPU(width * coils * coils);
+  covGPU.assign(covGPU.size(), 0);
+  for (unsigned frame = 0; frame < dims.frames; frame++)
+  {
+    ToHybridSpace(kdata.data() + frame * N * coils, kspace, hybrid, width,
+                  height, coils, plan, handle);
+    for (unsigned x = 0; x < width; x++)
+    {
+      cuComplex *position = (cuComplex *)hybrid.data() + x * height * coils;
+      status = cublasCgemm(
+          handle, CUBLAS_OP_C, CUBLAS_OP_N, coils, coils, height, &one,
+          position, height, position, height, &one,
+          (cuComplex *)covGPU.data() + x * coils * coils, coils);
+      AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                   StandardException::ExceptionMessage(
+                       "Error during covariance computation"));
+    }
+  }
+
+  std::vector<CType> cov;
+  covGPU.copyToHost(cov);
+
+  // number of virtual coils is selected on the total covariance
+  std::vector<CType> totalCov(coils * coils, 0);
+  for (unsigned x = 0; x < width; x++)
+    for (unsigned i = 0; i < coils * coils; i++)
+      totalCov[i] += cov[i + x * coils * coils];
+
+  std::vector<RType> eigenvalues;
+  std::vector<CType> eigenvectors;
+  HermitianEigen(totalCov, coils, eigenvalues, eigenvectors);
+  virtualCoils = SelectVirtualCoils(eigenvalues);
+
+  RType total = 0, discarded = 0;
+  std::vector<CType> weights(width * coils * virtualCoils);
+  std::vector<CType> previous, current;
+  for (unsigned x = 0; x < width; x++)
+  {
+    std::vector<CType> covX(cov.begin() + x * coils * coils,
+                            cov.begin() + (x + 1) * coils * coils);
+    HermitianEigen(covX, coils, eigenvalues, eigenvectors);
+    total += DiscardedEnergy(eigenvalues, 0);
+    discarded += DiscardedEnergy(eigenvalues, virtualCoils);
+
+    current.assign(eigenvectors.begin(),
+                   eigenvectors.begin() + coils * virtualCoils);
+    if (x > 0)
+      AlignCompressionMatrix(previous, current);
+    previous = current;
+
+    for (unsigned i = 0; i < coils * virtualCoils; i++)
+      weights[i + x * coils * virtualCoils] = std::conj(current[i]);
+  }
+  compressionError = total > 0 ? std::sqrt(discarded / total) : 0;
+
+  CVector weightsGPU(weights.size());
+  weightsGPU.assignFromHost(weights.begin(), weights.end());
+
+  cufftHandle virtualPlan;
+  cres = cufftPlan1d(&virtualPlan, width, CUFFT_C2C, height * virtualCoils);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage("Error during FFT plan"));
+
+  CVector compressedHybrid(N * virtualCoils);
+  CVector compressed(N * virtualCoils * dims.frames);
+  for (unsigned frame = 0; frame < dims.frames; frame++)
+  {
+    ToHybridSpace(kdata.data() + frame * N * coils, kspace, hybrid, width,
+                  height, coils, plan, handle);
+    for (unsigned x = 0; x < width; x++)
+    {
+      status = cublasCgemm(
+          handle, CUBLAS_OP_N, CUBLAS_OP_N, height, virtualCoils, coils, &one,
+          (cuComplex *)hybrid.data() + x * height * coils, height,
+          (cuComplex *)weightsGPU.data() + x * coils * virtualCoils, coils,
+          &zero,
+          (cuComplex *)compressedHybrid.data() + x * height * virtualCoils,
+          height);
+      AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                   StandardException::ExceptionMessage(
+                       "Error during coil compression"));
+    }
+
+    // transpose (x, coil, y) -> (coil, y, x) and return to k-space
+    cuComplex *frameData =
+        (cuComplex *)compressed.data() + frame * N * virtualCoils;
+    status = cublasCgeam(handle, CUBLAS_OP_T, CUBLAS_OP_N, width,
+                         height * virtualCoils, &one,
+                         (cuComplex *)compressedHybrid.data(),
+                         height * virtualCoils, &zero, frameData, width,
+                         frameData, width);
+    AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during hybrid space transpose"));
+
+    cres = cufftExecC2C(virtualPlan, (cufftComplex *)frameData,
+                        (cufftComplex *)frameData, CUFFT_FORWARD);
+    AGILE_ASSERT(cres == CUFFT_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during FFT procedure"));
+  }
+
+  // compensate unnormalized inverse/forward transform pair
+  agile::scale((CType)(1.0 / width), compressed, compressed);
+  kdata = compressed;
+
+  cufftDestroy(plan);
+  cufftDestroy(virtualPlan);
+}
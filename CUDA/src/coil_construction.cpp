@@ -1,5 +1,6 @@
 #include "../include/coil_construction.h"
 #include "../include/cg_forward_operation.h"
+#include <cublas_v2.h>
 
 CoilConstruction::CoilConstruction(unsigned width, unsigned height,
                                    unsigned coils, unsigned frames)
@@ -33,6 +34,7 @@ void CoilConstruction::InitParams()
   params.uTau /= params.uSigmaTauRatio;
   params.uAlpha0 = std::sqrt(2.0);
   params.uAlpha1 = 1.0;
+  params.uWarmNrIt = 0;
 
   params.b1Reg = 2;
   params.b1NrIt = 500;
@@ -42,9 +44,14 @@ void CoilConstruction::InitParams()
   params.b1Tau = std::sqrt(1.0 / 8.0);
   params.b1Sigma *= params.b1SigmaTauRatio;
   params.b1Tau /= params.b1SigmaTauRatio;
+  params.b1BatchSize = 1;
 
   params.b1FinalReg = 0.1;
   params.b1FinalNrIt = 1000;
+
+  params.pcgSolver = false;
+  params.pcgTolerance = 1E-5;
+  params.lowResFactor = 1;
 }
 
 PDParams &CoilConstruction::GetParams()
@@ -72,44 +79,118 @@ unsigned CoilConstruction::FindMaximumSum(CVector &crec)
   return maxInd;
 }
 
+void CoilConstruction::ComputeCoilCorrelation(CVector &crec,
+                                              std::vector<RType> &correlation)
+{
+  unsigned N = width * height;
+  RVector crecAbs(N * coils);
+  agile::absVector(crec, crecAbs);
+
+  cublasHandle_t handle;
+  cublasStatus_t status = cublasCreate(&handle);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during cuBLAS initialization"));
+
+  // |crec|^T |crec|, columns are the coil images
+  RType one = 1.0;
+  RType zero = 0.0;
+  RVector correlationGPU(coils * coils);
+  status = cublasSgemm(handle, CUBLAS_OP_T, CUBLAS_OP_N, coils, coils, N, &one,
+                       crecAbs.data(), N, crecAbs.data(), N, &zero,
+                       correlationGPU.data(), coils);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during correlation computation"));
+  cublasDestroy(handle);
+
+  correlationGPU.copyToHost(correlation);
+}
+
+std::vector<unsigned> CoilConstruction::FindCoilOrder(CVector &crec)
+{
+  std::vector<RType> correlation;
+  ComputeCoilCorrelation(crec, correlation);
+
+  std::vector<unsigned> inds;
+  inds.push_back(FindMaximumSum(crec));
+
+  for (unsigned cnt = 1; cnt < coils; cnt++)
+  {
+    unsigned prevInd = inds[cnt - 1];
+    RType maxSum = -1;
+    unsigned maxInd = -1;
+    for (unsigned b1Cnt = 0; b1Cnt < coils; b1Cnt++)
+    {
+      if (std::find(inds.begin(), inds.end(), b1Cnt) != inds.end())
+        continue;
+
+      RType norm = correlation[b1Cnt + prevInd * coils];
+      if (norm > maxSum)
+      {
+        maxSum = norm;
+        maxInd = b1Cnt;
+      }
+    }
+    inds.push_back(maxInd);
+  }
+  return inds;
+}
+
 void CoilConstruction::UTGV2Recon(CVector &b10, CVector &crec0, CVector &x1,
-                                  std::vector<unsigned> inds)
+                                  std::vector<unsigned> inds, bool warmStart)
 {
   RType nu = params.uReg;
 
   unsigned N = width * height;
 
+  warmStart = warmStart && params.uWarmNrIt > 0 && utgvX2.size() == 2 &&
+              utgvX2[0].size() == N;
+
   // primal
-  std::vector<CVector> x2;
+  std::vector<CVector> &x2 = utgvX2;
   CVector ext1(N), x1_old(N);
   std::vector<CVector> ext2, x2_old;
   // dual
-  std::vector<CVector> y1;
+  std::vector<CVector> &y1 = utgvY1;
   std::vector<CVector> yTemp;
   CVector div1Temp(N);
 
   // init gpu vectors
-  for (unsigned cnt = 0; cnt < 2; cnt++)
+  if (!warmStart)
   {
-    x2.push_back(CVector(N));
-    x2[cnt].assign(N, 0.0);
+    x2.clear();
+    y1.clear();
+    for (unsigned cnt = 0; cnt < 2; cnt++)
+    {
+      x2.push_back(CVector(N));
+      x2[cnt].assign(N, 0.0);
 
+      y1.push_back(CVector(N));
+      y1[cnt].assign(N, 0.0);
+    }
+  }
+  for (unsigned cnt = 0; cnt < 2; cnt++)
+  {
     ext2.push_back(CVector(N));
+    agile::copy(x2[cnt], ext2[cnt]);
     x2_old.push_back(CVector(N));
-
-    y1.push_back(CVector(N));
-    y1[cnt].assign(N, 0.0);
     yTemp.push_back(CVector(N));
   }
   // set initial value of x1
   agile::copy(x1, ext1);
 
-  std::vector<CVector> y2;
+  std::vector<CVector> &y2 = utgvY2;
   std::vector<CVector> y2Temp;
+  if (!warmStart)
+    y2.clear();
   for (int cnt = 0; cnt < 3; cnt++)
   {
-    y2.push_back(CVector(N));
-    y2[cnt].assign(N, 0);
+    if (!warmStart)
+    {
+      y2.push_back(CVector(N));
+      y2[cnt].assign(N, 0);
+    }
     y2Temp.push_back(CVector(N));
   }
 
@@ -117,8 +198,6 @@ void CoilConstruction::UTGV2Recon(CVector &b10, CVector &crec0, CVector &x1,
   CVector Lw(N);
   Lw.assign(N, 0);
 
-  CVector crec(N);
-  CVector b1(N);
   CVector sumB1(N);
   sumB1.assign(N, 0);
   CVector temp(N);
@@ -126,12 +205,14 @@ void CoilConstruction::UTGV2Recon(CVector &b10, CVector &crec0, CVector &x1,
   // Loop over array of indices
   for (unsigned cnt = 0; cnt < inds.size(); cnt++)
   {
-    utils::GetSubVector(b10, b1, inds[cnt], N);
-    utils::GetSubVector(crec0, crec, inds[cnt], N);
-    agile::multiplyConjElementwise(b1, crec, temp);
+    CVectorView b1 = CVectorView::Slice(b10, inds[cnt], N);
+    CVectorView crec = CVectorView::Slice(crec0, inds[cnt], N);
+    agile::lowlevel::multiplyConjElementwise(b1.data(), crec.data(),
+                                             temp.data(), N);
     agile::addVector(Lw, temp, Lw);
 
-    agile::multiplyConjElementwise(b1, b1, temp);
+    agile::lowlevel::multiplyConjElementwise(b1.data(), b1.data(), temp.data(),
+                                             N);
     agile::addVector(sumB1, temp, sumB1);
   }
 
@@ -145,11 +226,11 @@ void CoilConstruction::UTGV2Recon(CVector &b10, CVector &crec0, CVector &x1,
   Ib.assign(N, 1.0);
   agile::divideElementwise(Ib, sumB1, Ib);
 
-  unsigned maxIt = params.uNrIt;
+  unsigned maxIt = warmStart ? params.uWarmNrIt : params.uNrIt;
   unsigned loopCnt = 0;
 
   // loop
-  Log("UTGV2Recon: Starting iteration:\n");
+  Log("UTGV2Recon: Starting %s iteration:\n", warmStart ? "warm" : "cold");
   while (loopCnt < maxIt)
   {
     // dual ascent step
@@ -222,6 +303,14 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
 
   // primal: x1
   x1.assign(N, 0);
+
+  if (params.pcgSolver)
+  {
+    B1ReconPCG(u0, crec, x1, coils, maxIt, mu);
+    NormalizeB1(x1, coils);
+    return;
+  }
+
   CVector ext1(N), x1_old(N);
   agile::copy(x1, ext1);
 
@@ -232,7 +321,7 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
   {
     y1.push_back(CVector(N));
     y1[cnt].assign(N, 0.0);
-    y1Temp.push_back(CVector(width * height));
+    y1Temp.push_back(CVector(N));
   }
 
   CVector div1Temp(N);
@@ -286,39 +375,21 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
   while (loopCnt < maxIt)
   {
     // dual ascent step
-    // p
-    CVector ext1Temp(width * height);
-    for (unsigned cnt = 0; cnt < coils; cnt++)
+    // p, all coil slices at once
+    utils::Gradient2D(ext1, y1Temp, width, height);
+    for (unsigned gradCnt = 0; gradCnt < 2; gradCnt++)
     {
-      unsigned cOff = cnt * width * height;
-      utils::GetSubVector(ext1, ext1Temp, cnt, width * height);
-      utils::Gradient2D(ext1Temp, y1Temp, width, height);
-      for (unsigned gradCnt = 0; gradCnt < 2; gradCnt++)
-      {
-        agile::lowlevel::addScaledVector(
-            y1[gradCnt].data() + cOff, params.b1Sigma, y1Temp[gradCnt].data(),
-            y1[gradCnt].data() + cOff, width * height);
-        // Proximal mapping
-        agile::lowlevel::scale((CType)1.0 /
-                                   ((RType)1.0 + (RType)params.b1Sigma / mu),
-                               y1[gradCnt].data() + cOff,
-                               y1[gradCnt].data() + cOff, width * height);
-      }
+      agile::addScaledVector(y1[gradCnt], params.b1Sigma, y1Temp[gradCnt],
+                             y1[gradCnt]);
+      // Proximal mapping
+      agile::scale((CType)1.0 / ((RType)1.0 + (RType)params.b1Sigma / mu),
+                   y1[gradCnt], y1[gradCnt]);
     }
 
-    for (unsigned cnt = 0; cnt < coils; cnt++)
-    {
-      unsigned cOff = cnt * width * height;
-      utils::GetSubVector(y1[0], y1Temp[0], cnt, width * height);
-      utils::GetSubVector(y1[1], y1Temp[1], cnt, width * height);
-
-      // primal descent
-      // ext1
-      utils::Divergence2D(y1Temp, div1Temp, width, height);
-      agile::lowlevel::addScaledVector(x1.data() + cOff, params.b1Tau,
-                                       div1Temp.data(), ext1.data() + cOff,
-                                       width * height);
-    }
+    // primal descent
+    // ext1
+    utils::Divergence2D(y1, div1Temp, width, height);
+    agile::addScaledVector(x1, params.b1Tau, div1Temp, ext1);
 
     // Proximal mapping
     agile::addScaledVector(ext1, params.b1Tau, Lw, ext1);
@@ -339,6 +410,91 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
   }
   Log("\n");
 
+  NormalizeB1(x1, coils);
+}
+
+void CoilConstruction::B1ReconPCG(CVector &u0, CVector &crec, CVector &x1,
+                                  unsigned coils, unsigned maxIt, RType mu)
+{
+  unsigned N = width * height;
+
+  // renormalize u0
+  CVector u0Normed(N);
+  NormalizeByMaximum(u0, u0Normed);
+
+  // (abs(u0).^2 + mu * grad^T grad) x = conj(u0) * crec
+  CVector coefficient(N);
+  agile::multiplyConjElementwise(u0Normed, u0Normed, coefficient);
+
+  CVector rhs(N * coils);
+  for (unsigned cnt = 0; cnt < coils; cnt++)
+  {
+    unsigned cOff = cnt * N;
+    agile::lowlevel::multiplyConjElementwise(
+        u0Normed.data(), crec.data() + cOff, rhs.data() + cOff, N);
+  }
+
+  ScreenedPoissonSolver solver(width, height, coils, false);
+  solver.Solve(coefficient, mu, rhs, x1, params.pcgTolerance, maxIt);
+  LogSolver("B1Recon", solver);
+}
+
+void CoilConstruction::B1PhaseRecon(CVector &u0, CVector &crec, CVector &x1,
+                                    unsigned count, unsigned maxIt, RType mu)
+{
+  unsigned N = width * height;
+
+  if (!params.pcgSolver)
+  {
+    CVector u0Temp(N), crecTemp(N), x1Temp(N);
+    for (unsigned cnt = 0; cnt < count; cnt++)
+    {
+      utils::GetSubVector(u0, u0Temp, cnt, N);
+      utils::GetSubVector(crec, crecTemp, cnt, N);
+      B1Recon(u0Temp, crecTemp, x1Temp, 1, maxIt, mu);
+      utils::SetSubVector(x1Temp, x1, cnt, N);
+    }
+    return;
+  }
+
+  // per coil (abs(u0).^2 + mu * grad^T grad) x = conj(u0) * crec
+  CVector u0Temp(N), u0Normed(N);
+  CVector coefficient(N * count);
+  CVector rhs(N * count);
+  for (unsigned cnt = 0; cnt < count; cnt++)
+  {
+    unsigned cOff = cnt * N;
+    utils::GetSubVector(u0, u0Temp, cnt, N);
+    NormalizeByMaximum(u0Temp, u0Normed);
+    agile::lowlevel::multiplyConjElementwise(
+        u0Normed.data(), u0Normed.data(), coefficient.data() + cOff, N);
+    agile::lowlevel::multiplyConjElementwise(
+        u0Normed.data(), crec.data() + cOff, rhs.data() + cOff, N);
+  }
+
+  x1.assign(N * count, 0);
+  ScreenedPoissonSolver solver(width, height, count, false);
+  solver.Solve(coefficient, mu, rhs, x1, params.pcgTolerance, maxIt);
+  LogSolver("B1PhaseRecon", solver);
+}
+
+void CoilConstruction::NormalizeByMaximum(CVector &u0, CVector &u0Normed)
+{
+  RVector u0Abs(u0.size());
+  agile::absVector(u0, u0Abs);
+
+  int mxInd;
+  agile::maxElement(u0Abs, &mxInd);
+  RVector maxEl(1);
+  agile::lowlevel::get_content(u0Abs.data(), 1, 1, 0, mxInd - 1, maxEl.data(),
+                               1, 1);
+  std::vector<RType> maxElHost(1);
+  maxEl.copyToHost(maxElHost);
+  agile::scale((RType)1.0 / maxElHost[0], u0, u0Normed);
+}
+
+void CoilConstruction::NormalizeB1(CVector &b1, unsigned coils)
+{
   // Normalize to 1
   CVector x1Norm(width * height);
   x1Norm.assign(width * height, 0);
@@ -346,7 +502,7 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
   for (unsigned cnt = 0; cnt < coils; cnt++)
   {
     unsigned cOff = cnt * width * height;
-    agile::lowlevel::multiplyConjElementwise(x1.data() + cOff, x1.data() + cOff,
+    agile::lowlevel::multiplyConjElementwise(b1.data() + cOff, b1.data() + cOff,
                                              tempNorm.data(), width * height);
     agile::addVector(x1Norm, tempNorm, x1Norm);
   }
@@ -355,11 +511,25 @@ void CoilConstruction::B1Recon(CVector &u0, CVector &crec, CVector &x1,
   for (unsigned cnt = 0; cnt < coils; cnt++)
   {
     unsigned cOff = cnt * width * height;
-    agile::lowlevel::divideElementwise(x1.data() + cOff, x1Norm.data(),
-                                       x1.data() + cOff, width * height);
+    agile::lowlevel::divideElementwise(b1.data() + cOff, x1Norm.data(),
+                                       b1.data() + cOff, width * height);
   }
 }
 
+void CoilConstruction::LogSolver(const char *name,
+                                 ScreenedPoissonSolver &solver)
+{
+  if (solver.HasConverged())
+    Log("%s: PCG converged in ", name);
+  else
+    Log("%s: Error: PCG did not converge in ", name);
+
+  Log("%d iterations\n "
+      "Relative residual: %.4e\n "
+      "----------------------------------------------\n",
+      solver.GetIterations(), solver.GetRelativeResidual());
+}
+
 void CoilConstruction::B1FromUH1(CVector &u, CVector &crec,
                                  communicator_type &com, CVector &b1)
 {
@@ -375,6 +545,31 @@ void CoilConstruction::B1FromUH1(CVector &u, CVector &crec,
   agile::multiplyConjElementwise(u, u, muU);
   agile::scale(params.uH1mu, muU, muU);
 
+  if (params.pcgSolver)
+  {
+    // rhs of all coils
+    CVector y(N * coils);
+    for (unsigned cnt = 0; cnt < coils; cnt++)
+    {
+      unsigned cOff = N * cnt;
+      agile::lowlevel::multiplyConjElementwise(
+          u.data(), crecReal.data() + cOff, y.data() + cOff, N);
+    }
+
+    // solve (muU - Laplacian) b1 = y for all coils at once
+    b1.assign(N * coils, 0);
+    ScreenedPoissonSolver solver(width, height, coils, true);
+    solver.Solve(muU, 1.0, y, b1, params.pcgTolerance, 800);
+    LogSolver("B1FromUH1", solver);
+
+    NormalizeB1(b1, coils);
+
+    // Return abs(b1)
+    agile::multiplyConjElementwise(b1, b1, b1);
+    agile::sqrt(b1, b1);
+    return;
+  }
+
   forward_type forward(com, muU, width, height);
 
   // generate a binary measure
@@ -463,9 +658,10 @@ void CoilConstruction::PerformCoilConstruction(CVector &kdata, CVector &u,
   CVector absb1(width * height * coils);
   B1FromUH1(u0, crec, com, absb1);
 
-  // find absolute sum of each coil and maximum index
+  // greedy coil order from the pairwise coil correlation
+  std::vector<unsigned> order = FindCoilOrder(crec);
   std::vector<unsigned> inds;
-  inds.push_back(FindMaximumSum(crec));
+  inds.push_back(order[0]);
   Log("starting with coil no: %d\n", inds[0]);
 
   unsigned N = width * height;
@@ -480,74 +676,70 @@ void CoilConstruction::PerformCoilConstruction(CVector &kdata, CVector &u,
   UTGV2Recon(b1, crec, uMax, inds);
   utils::SetSubVector(uMax, u, 0, N);
 
+  unsigned batchSize = std::max(params.b1BatchSize, 1u);
+  CVector wSq(N);
+  wSq.assign(N, 0);
   CVector w(N);
-  w.assign(N, 0);
-  CVector temp(N);
-  CVector b1Max(N);
-  CVector crecMax(width * height);
-  RVector crecAbs1(N);
-  RVector crecAbs2(N);
-  CVector x1(N);
-  RType maxSum = std::numeric_limits<RType>::min();
-  unsigned maxInd = -1;
+  CVector uBatch(N * batchSize);
+  CVector crecBatch(N * batchSize);
+  CVector x1(N * batchSize);
 
-  for (unsigned cnt = 1; cnt < coils; cnt++)
+  unsigned weighted = 0;
+  unsigned count = 1;
+  for (unsigned cnt = 1; cnt < coils; cnt += count)
   {
-    utils::GetSubVector(absb1, b1Temp, inds[cnt - 1], N);
-    agile::multiplyConjElementwise(b1Temp, b1Temp, b1Temp);
-    agile::multiplyElementwise(w, w, w);
-    agile::addVector(w, b1Temp, w);
-    agile::sqrt(w, w);
-
-    utils::GetSubVector(crec, crecMax, inds[cnt - 1], N);
-    agile::absVector(crecMax, crecAbs1);
+    count = std::min(batchSize, coils - cnt);
 
-    // Get index of next b1 field
-    maxSum = std::numeric_limits<RType>::min();
-    for (unsigned b1Cnt = 0; b1Cnt < coils; b1Cnt++)
+    // w = sqrt(sum of abs(b1).^2 over all processed coils)
+    for (; weighted < cnt; weighted++)
     {
-      if (std::find(inds.begin(), inds.end(), b1Cnt) == inds.end())
-      {
-        utils::GetSubVector(crec, crecMax, b1Cnt, N);
-        agile::absVector(crecMax, crecAbs2);
-        agile::multiplyElementwise(crecAbs1, crecAbs2, crecAbs2);
-        RType norm = agile::norm1(crecAbs2);
-        if (norm > maxSum)
-        {
-          maxSum = norm;
-          maxInd = b1Cnt;
-        }
-      }
+      CVectorView absb1Coil = CVectorView::Slice(absb1, inds[weighted], N);
+      agile::lowlevel::multiplyConjElementwise(
+          absb1Coil.data(), absb1Coil.data(), b1Temp.data(), N);
+      agile::addVector(wSq, b1Temp, wSq);
     }
-    Log("going for coil no: %d\n", maxInd);
-    inds.push_back(maxInd);
+    agile::sqrt(wSq, w);
 
-    // Get new b1
-    utils::GetSubVector(absb1, b1Max, maxInd, N);
-    utils::GetSubVector(crec, crecMax, maxInd, N);
-    // w * absb1 * u
-    utils::GetSubVector(u, uMax, cnt - 1, N);
-    agile::multiplyElementwise(b1Max, uMax, uMax);
-    agile::multiplyElementwise(uMax, w, uMax);
-    agile::multiplyElementwise(crecMax, w, crecMax);
+    // w * absb1 * u and w * crec of the next coils
+    CVectorView uPrev = CVectorView::Slice(u, cnt - 1, N);
+    for (unsigned batchCnt = 0; batchCnt < count; batchCnt++)
+    {
+      unsigned ind = order[cnt + batchCnt];
+      unsigned bOff = batchCnt * N;
+      Log("going for coil no: %d\n", ind);
+      inds.push_back(ind);
+
+      agile::lowlevel::multiplyElementwise(absb1.data() + ind * N,
+                                           uPrev.data(), uBatch.data() + bOff,
+                                           N);
+      agile::lowlevel::multiplyElementwise(uBatch.data() + bOff, w.data(),
+                                           uBatch.data() + bOff, N);
+      agile::lowlevel::multiplyElementwise(crec.data() + ind * N, w.data(),
+                                           crecBatch.data() + bOff, N);
+    }
 
-    x1.assign(N, 0.0);
-    B1Recon(uMax, crecMax, x1, 1, params.b1NrIt, params.b1Reg);
+    // Get new b1 of all coils of the batch at once
+    B1PhaseRecon(uBatch, crecBatch, x1, count, params.b1NrIt, params.b1Reg);
 
     // Get Phase
-    RVector angleReal(N);
-    CVector angle(N);
+    RVector angleReal(N * count);
+    CVector angle(N * count);
     agile::phaseVector(x1, angleReal);
     agile::scale(CType(0, 1.0), angleReal, angle);
     agile::expVector(angle, angle);
-    utils::GetSubVector(absb1, b1Temp, maxInd, N);
-    agile::multiplyElementwise(b1Temp, angle, x1);
-    utils::SetSubVector(x1, b1, maxInd, N);
-
-    // Get new image
-    utils::GetSubVector(u, uMax, cnt - 1, N);
-    UTGV2Recon(b1, crec, uMax, inds);
-    utils::SetSubVector(uMax, u, cnt, N);
+    for (unsigned batchCnt = 0; batchCnt < count; batchCnt++)
+    {
+      unsigned ind = order[cnt + batchCnt];
+      agile::lowlevel::multiplyElementwise(absb1.data() + ind * N,
+                                           angle.data() + batchCnt * N,
+                                           b1.data() + ind * N, N);
+    }
+
+    // Get new image, warm started from the previous one
+    uPrev.CopyTo(uMax);
+    UTGV2Recon(b1, crec, uMax, inds, true);
+    for (unsigned batchCnt = 0; batchCnt < count; batchCnt++)
+      utils::SetSubVector(uMax, u, cnt + batchCnt, N);
   }
 
   Log("final b1 correction:\n");
@@ -1,9 +1,28 @@
 #include "../include/dicom_reader.h"
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include <stdexcept>
+
+// private group containing the raw data in siemens raw data dicom files
+static const Uint16 CSA_NON_IMAGE_GROUP = 0x7fe1;
+static const char *CSA_NON_IMAGE_CREATOR = "SIEMENS CSA NON-IMAGE";
+
+static DcmTagKey FindRawDataTag(DcmDataset *dataset)
+{
+  // resolve private creator block, defaults to (7fe1,1010)
+  for (Uint16 block = 0x10; block <= 0xff; block++)
+  {
+    OFString creator;
+    if (dataset->findAndGetOFString(DcmTagKey(CSA_NON_IMAGE_GROUP, block),
+                                    creator).good() &&
+        creator == CSA_NON_IMAGE_CREATOR)
+      return DcmTagKey(CSA_NON_IMAGE_GROUP, (block << 8) | 0x10);
+  }
+  return DcmTagKey(CSA_NON_IMAGE_GROUP, 0x1010);
+}
 
 DicomReader::DicomReader(OptionsParser &op)
-  : SiemensVD11Reader(op, utils::GetParentDirectory(op.outputFilename) +
-                              "/meas.dat"),
-    filepath(op.kdataFilename)
+  : SiemensVD11Reader(op, op.kdataFilename), filepath(op.kdataFilename)
 {
 }
 
@@ -33,11 +52,11 @@ DicomFileList DicomReader::GetDicomFileList()
         }
       }
     }
-  }
-  else if (fs::is_regular_file(dir) && dir.extension() == ".dcm")
-  {
-    // in case path points to exactly one dicom file
-    dicomFiles.insert(std::make_pair(dir.filename().c_str(), dir));
+    else if (fs::is_regular_file(dir) && dir.extension() == ".dcm")
+    {
+      // in case path points to exactly one dicom file
+      dicomFiles.insert(std::make_pair(dir.filename().c_str(), dir));
+    }
   }
   else
     std::cerr << "Error loading file/directory: " << dir << " -> not found!"
@@ -46,32 +65,63 @@ DicomFileList DicomReader::GetDicomFileList()
   return dicomFiles;
 }
 
-void DicomReader::GenerateMeasDat(const std::string &rawDataFile)
+void DicomReader::ExtractRawData(std::vector<char> &rawData)
 {
   DicomFileList dicomFiles = GetDicomFileList();
   DicomFileList::iterator dicomIt = dicomFiles.begin();
-  std::ofstream measdat(rawDataFile.c_str());
+
+  // reserve upper bound to avoid reallocations while appending
+  boost::uintmax_t totalSize = 0;
+  for (; dicomIt != dicomFiles.end(); dicomIt++)
+    totalSize += fs::file_size(dicomIt->second);
+  rawData.clear();
+  rawData.reserve(totalSize);
+
+  dicomIt = dicomFiles.begin();
   while (dicomIt != dicomFiles.end())
   {
     std::cout << "Loading file " << dicomIt->second.c_str() << std::endl;
 
-    unsigned long length;
-    Uint8 *pdata = NULL;
+    DcmFileFormat fileFormat;
+    if (fileFormat.loadFile(dicomIt->second.c_str()).bad())
+      throw std::runtime_error("DicomReader: could not load dicom file " +
+                               dicomIt->second.string());
 
-    agile::DICOM dicom;
+    DcmDataset *dataset = fileFormat.getDataset();
+    const Uint8 *pdata = NULL;
+    unsigned long length = 0;
+    if (dataset->findAndGetUint8Array(FindRawDataTag(dataset), pdata, &length)
+            .bad() ||
+        pdata == NULL)
+      throw std::runtime_error("DicomReader: no embedded raw data found in " +
+                               dicomIt->second.string());
 
-    dicom.readdicom(dicomIt->second.c_str(), measdat, length, pdata);
+    rawData.insert(rawData.end(), pdata, pdata + length);
     std::cout << length << " bytes read..." << std::endl;
 
     dicomIt++;
   }
+}
+
+void DicomReader::GenerateMeasDat(const std::string &rawDataFile)
+{
+  std::vector<char> rawData;
+  this->ExtractRawData(rawData);
+  if (rawData.empty())
+    throw std::runtime_error("DicomReader: no raw data found in " + filepath);
+
+  std::ofstream measdat(rawDataFile.c_str(), std::ios::binary);
+  measdat.write(&rawData[0], rawData.size());
   measdat.close();
 }
 
 void DicomReader::LoadRawData()
 {
-  std::cout << "Generate meas dat in:  " << rawDataPath << std::endl;
-  this->GenerateMeasDat(rawDataPath);
-  SiemensVD11Reader::LoadRawData();
-}
+  // raw data is decoded directly from memory, no meas.dat is written
+  std::cout << "Extract raw data from:  " << filepath << std::endl;
+  this->ExtractRawData(embeddedRawData);
+  if (embeddedRawData.empty())
+    throw std::runtime_error("DicomReader: no raw data found in " + filepath);
 
+  this->IndexRawData(&embeddedRawData[0], embeddedRawData.size());
+}
@@ -2,7 +2,7 @@
 
 ICTGV2::ICTGV2(unsigned width, unsigned height, unsigned coils, unsigned frames,
                BaseOperator *mrOp)
-  : PDRecon(width, height, 0, coils, frames, mrOp)
+  : PDRecon(width, height, 0, coils, frames, mrOp), pdGapDeviation(0)
 {
   InitParams();
   InitTempVectors();
@@ -10,7 +10,8 @@ ICTGV2::ICTGV2(unsigned width, unsigned height, unsigned coils, unsigned frames,
 
 ICTGV2::ICTGV2(unsigned width, unsigned height, unsigned coils, unsigned frames,
                ICTGV2Params &params, BaseOperator *mrOp)
-  : PDRecon(width, height, 0, coils, frames, mrOp), params(params)
+  : PDRecon(width, height, 0, coils, frames, mrOp), params(params),
+    pdGapDeviation(0)
 {
   InitLambda(params.adaptLambdaParams.adaptLambda);
   InitTempVectors();
@@ -43,6 +44,11 @@ void ICTGV2::InitParams()
   params.tau = 1.0 / 3.0;
 
   params.sigmaTauRatio = 1.0;
+  params.diagonalPreconditioning = false;
+  params.variant = PD_STANDARD;
+  params.restart = false;
+  params.andersonDepth = 0;
+  params.coilSubsetSize = 0;
 
   params.timeSpaceWeight = 6.5;
   params.dx = 1.0;
@@ -71,6 +77,7 @@ void ICTGV2::InitTempVectors()
   zTemp = CVector(0);  //< resized at runtime
   div1Temp = CVector(N);
   div3Temp = CVector(N);
+  normTemp = CVector(N);
 
   for (unsigned cnt = 0; cnt < 3; cnt++)
   {
@@ -84,6 +91,78 @@ void ICTGV2::InitTempVectors()
   }
 }
 
+void ICTGV2::InitSteps(CVector &b1, unsigned dataSize)
+{
+  if (!params.diagonalPreconditioning)
+  {
+    sigmaY1.assign(3, params.sigma);
+    sigmaY2.assign(6, params.sigma);
+    sigmaY3.assign(3, params.sigma);
+    sigmaY4.assign(6, params.sigma);
+    sigmaZ = params.sigma;
+    tauX2.assign(3, params.tau);
+    tauX3 = params.tau;
+    tauX4.assign(3, params.tau);
+    return;
+  }
+
+  RType h[3] = { params.dx, params.dy, params.dt };
+  RType h2[3] = { params.dx2, params.dy2, params.dt2 };
+  std::vector<RType> rowSums, columnSums, rowSums2, columnSums2;
+  SymmetricGradientSums(params.dx, params.dy, params.dt, rowSums, columnSums);
+  SymmetricGradientSums(params.dx2, params.dy2, params.dt2, rowSums2,
+                        columnSums2);
+
+  RType gradientSum = 0;
+  RType gradientSum2 = 0;
+  sigmaY1.resize(3);
+  sigmaY3.resize(3);
+  tauX2.resize(3);
+  tauX4.resize(3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    gradientSum += 2.0 / h[cnt];
+    gradientSum2 += 2.0 / h2[cnt];
+    // p = grad (x1 - x3) - x2, r = grad x3 - x4
+    sigmaY1[cnt] = 1.0 / (4.0 / h[cnt] + 1.0);
+    sigmaY3[cnt] = 1.0 / (2.0 / h2[cnt] + 1.0);
+    tauX2[cnt] = 1.0 / (columnSums[cnt] + 1.0);
+    tauX4[cnt] = 1.0 / (columnSums2[cnt] + 1.0);
+  }
+  sigmaY2.resize(6);
+  sigmaY4.resize(6);
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+  {
+    sigmaY2[cnt] = 1.0 / rowSums[cnt];
+    sigmaY4[cnt] = 1.0 / rowSums2[cnt];
+  }
+  tauX3 = 1.0 / (gradientSum + gradientSum2);
+
+  tauX1 = CVector(width * height * frames);
+  sigmaZ = InitDiagonalDataSteps(b1, dataSize, gradientSum, tauX1);
+}
+
+void ICTGV2::ScaleSteps(RType factor)
+{
+  PDRecon::ScaleSteps(factor);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    sigmaY1[cnt] *= factor;
+    sigmaY3[cnt] *= factor;
+    tauX2[cnt] /= factor;
+    tauX4[cnt] /= factor;
+  }
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+  {
+    sigmaY2[cnt] *= factor;
+    sigmaY4[cnt] *= factor;
+  }
+  sigmaZ *= factor;
+  tauX3 /= factor;
+  if (params.diagonalPreconditioning)
+    agile::scale((DType)(1.0 / factor), tauX1, tauX1);
+}
+
 PDParams &ICTGV2::GetParams()
 {
   return params;
@@ -327,11 +406,52 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
   ictgvNormExport.push_back(ictgv2Norm);
      
 
-  unsigned loopCnt = 0;
+  InitSteps(b1_gpu, data_gpu.size());
+
+  ClearState();
+  AddPrimalState(x1, ext1);
+  AddPrimalState(x3, ext3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    AddPrimalState(x2[cnt], ext2[cnt]);
+    AddPrimalState(x4[cnt], ext4[cnt]);
+    AddDualState(y1[cnt]);
+    AddDualState(y3[cnt]);
+  }
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+  {
+    AddDualState(y2[cnt]);
+    AddDualState(y4[cnt]);
+  }
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  AddHistoryState(dataFidelityExport);
+  AddHistoryState(ictgvNormExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
+  pdGapDeviation = 0;
   // loop
   Log("Starting iteration\n");
   while ( loopCnt < params.maxIt )
   {
+    BeginIteration(loopCnt);
+
+    // PD gap (export,verbose,stopping) in this iteration
+    bool computeGap =
+        (verbose && (loopCnt < 10 || (loopCnt % 50 == 0))) ||
+        ((debug) && (loopCnt % debugstep == 0)) ||
+        ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) ||
+        ((params.restart || params.andersonDepth > 0) && (loopCnt % 20 == 0));
+
+    // gap of (ext, y_n+1), accumulated from the updates below
+    bool gapByproducts = computeGap && !DualsExtrapolated();
+    RType gapNorm = 0;
+    RType gapGStar = 0;
+    RType gapDataFidelity = 0;
+
+    RType denom = std::min(params.alpha, (RType)1.0 - params.alpha);
+
     // dual ascent step
     // p, r
     agile::subVector(ext1, ext3, imgTemp);
@@ -342,10 +462,19 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::subVector(y2Temp[cnt], ext2[cnt], y2Temp[cnt]);
-      agile::addScaledVector(y1[cnt], params.sigma, y2Temp[cnt], y1[cnt]);
+      agile::addScaledVector(y1[cnt], sigmaY1[cnt], y2Temp[cnt], y1[cnt]);
 
       agile::subVector(y4Temp[cnt], ext4[cnt], y4Temp[cnt]);
-      agile::addScaledVector(y3[cnt], params.sigma, y4Temp[cnt], y3[cnt]);
+      agile::addScaledVector(y3[cnt], sigmaY3[cnt], y4Temp[cnt], y3[cnt]);
+    }
+    if (gapByproducts)
+    {
+      utils::GradientNorm(y2Temp, normTemp);
+      gapNorm += params.alpha1 * (params.alpha / denom) *
+                 agile::norm1(normTemp);
+      utils::GradientNorm(y4Temp, normTemp);
+      gapNorm += params.alpha1 * ((1.0 - params.alpha) / denom) *
+                 agile::norm1(normTemp);
     }
 
     // q, s
@@ -355,15 +484,33 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
                              params.dy2, params.dt2);
     for (unsigned cnt = 0; cnt < 6; cnt++)
     {
-      agile::addScaledVector(y2[cnt], params.sigma, y2Temp[cnt], y2[cnt]);
-      agile::addScaledVector(y4[cnt], params.sigma, y4Temp[cnt], y4[cnt]);
+      agile::addScaledVector(y2[cnt], sigmaY2[cnt], y2Temp[cnt], y2[cnt]);
+      agile::addScaledVector(y4[cnt], sigmaY4[cnt], y4Temp[cnt], y4[cnt]);
+    }
+    if (gapByproducts)
+    {
+      utils::SymmetricGradientNorm(y2Temp, normTemp);
+      gapNorm += params.alpha0 * (params.alpha / denom) *
+                 agile::norm1(normTemp);
+      utils::SymmetricGradientNorm(y4Temp, normTemp);
+      gapNorm += params.alpha0 * ((1.0 - params.alpha) / denom) *
+                 agile::norm1(normTemp);
     }
 
-    mrOp->BackwardOperation(ext1, zTemp, b1_gpu);
-    agile::addScaledVector(z, params.sigma, zTemp, z);
+    // zTemp = K ext - d
+    if (DataDualStep(ext1, z, zTemp, data_gpu, b1_gpu, sigmaZ))
+    {
+      if (gapByproducts)
+      {
+        RType residual = agile::norm2(zTemp);
+        gapDataFidelity = params.lambda / (RType)2.0 * residual;
+        gapGStar += 0.5 * params.lambda * residual * residual;
+      }
+    }
+    else
+      gapByproducts = false;
 
     // Proximal mapping
-    RType denom = std::min(params.alpha, (RType)1.0 - params.alpha);
     RType scale = params.alpha1 * (params.alpha / denom);
     utils::ProximalMap3(y1, 1.0 / scale);
 
@@ -379,16 +526,37 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     scale = params.alpha0 * ((1.0 - params.alpha) / denom);
     utils::ProximalMap6(y4, 1.0 / scale);
 
-    agile::subScaledVector(z, params.sigma, data_gpu, z);
-    agile::scale((float)(1.0 / (1.0 + params.sigma / params.lambda)), z, z);
+    ExtrapolateDual(sigmaZ);
+
+    // F*(z)
+    if (gapByproducts)
+    {
+      gapGStar += std::real(agile::getScalarProduct(data_gpu, z));
+      gapGStar += 1.0 / (2.0 * params.lambda) *
+                  std::real(agile::getScalarProduct(z, z));
+    }
+
+    // reference gap of (ext, y_n+1), temporaries are reinitialized below
+    RType referenceGap = 0;
+    if (debug && gapByproducts)
+      referenceGap = ComputePDGap(ext1, ext2, ext3, ext4, y1, y2, y3, y4, z,
+                                  data_gpu, b1_gpu);
 
     // primal descent
     // ext1
-    mrOp->ForwardOperation(z, imgTemp, b1_gpu);
+    DataAdjoint(z, imgTemp, b1_gpu);
     utils::Divergence(y1, div1Temp, width, height, frames, params.dx, params.dy,
                       params.dt);
     agile::subVector(imgTemp, div1Temp, imgTemp);
-    agile::subScaledVector(x1, params.tau, imgTemp, ext1);
+    if (gapByproducts)
+      gapGStar += agile::norm1(imgTemp);
+    if (params.diagonalPreconditioning)
+    {
+      agile::multiplyElementwise(tauX1, imgTemp, imgTemp);
+      agile::subVector(x1, imgTemp, ext1);
+    }
+    else
+      agile::subScaledVector(x1, params.tau, imgTemp, ext1);
 
     // ext2
     utils::SymmetricDivergence(y2, div2Temp, width, height, frames, params.dx,
@@ -396,14 +564,18 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::addVector(y1[cnt], div2Temp[cnt], div2Temp[cnt]);
-      agile::addScaledVector(x2[cnt], params.tau, div2Temp[cnt], ext2[cnt]);
+      if (gapByproducts)
+        gapGStar += agile::norm1(div2Temp[cnt]);
+      agile::addScaledVector(x2[cnt], tauX2[cnt], div2Temp[cnt], ext2[cnt]);
     }
 
     // ext3
     utils::Divergence(y3, div3Temp, width, height, frames, params.dx2,
                       params.dy2, params.dt2);
     agile::subVector(div1Temp, div3Temp, div3Temp);
-    agile::subScaledVector(x3, params.tau, div3Temp, ext3);
+    if (gapByproducts)
+      gapGStar += agile::norm1(div3Temp);
+    agile::subScaledVector(x3, tauX3, div3Temp, ext3);
 
     // ext4
     utils::SymmetricDivergence(y4, div2Temp, width, height, frames, params.dx2,
@@ -411,8 +583,11 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::addVector(y3[cnt], div2Temp[cnt], div2Temp[cnt]);
-      agile::addScaledVector(x4[cnt], params.tau, div2Temp[cnt], ext4[cnt]);
+      if (gapByproducts)
+        gapGStar += agile::norm1(div2Temp[cnt]);
+      agile::addScaledVector(x4[cnt], tauX4[cnt], div2Temp[cnt], ext4[cnt]);
     }
+    RestoreDual();
 
     // save x_n+1
     agile::copy(ext1, x1_old);
@@ -424,27 +599,25 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     }
 
     // extra gradient
-    agile::scale(2.0f, ext1, ext1);
-    agile::scale(2.0f, ext3, ext3);
-    agile::subVector(ext1, x1, ext1);
-    agile::subVector(ext3, x3, ext3);
+    Extrapolate(ext1, x1);
+    Extrapolate(ext3, x3);
     // x_n = x_n+1
     agile::copy(x1_old, x1);
     agile::copy(x3_old, x3);
 
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
-      agile::scale((DType)2.0, ext2[cnt], ext2[cnt]);
-      agile::subVector(ext2[cnt], x2[cnt], ext2[cnt]);
+      Extrapolate(ext2[cnt], x2[cnt]);
       agile::copy(x2_old[cnt], x2[cnt]);
 
-      agile::scale((DType)2.0, ext4[cnt], ext4[cnt]);
-      agile::subVector(ext4[cnt], x4[cnt], ext4[cnt]);
+      Extrapolate(ext4[cnt], x4[cnt]);
       agile::copy(x4_old[cnt], x4[cnt]);
     }
 
-    // adapt step size
-    if (loopCnt < 10 || (loopCnt % 50 == 0))
+    // adapt step size, preconditioned steps are valid by construction
+    if (!params.diagonalPreconditioning &&
+        (loopCnt < 10 ||
+         (params.variant == PD_STANDARD && loopCnt % 50 == 0)))
     {
       agile::subVector(ext1, x1, div1Temp);
       agile::subVector(ext3, x3, div3Temp);
@@ -455,41 +628,70 @@ void ICTGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
         agile::subVector(ext4[cnt], x4[cnt], y4Temp[cnt]);
       }
       AdaptStepSize(div1Temp, div2Temp, div3Temp, y4Temp, b1_gpu);
+      InitSteps(b1_gpu, data_gpu.size());
     }
+    UpdateSteps();
+    AndersonStep(loopCnt);
 
     // compute PD Gap (export,verbose,stopping)
-    if ( (verbose && (loopCnt < 10 || (loopCnt % 50 == 0)) ) ||
-         ((debug) && (loopCnt % debugstep == 0)) || 
-         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) )
+    if (computeGap)
     {
-      RType pdGap =
-          ComputePDGap(x1, x2, x3, x4, y1, y2, y3, y4, z, data_gpu, b1_gpu);
+      RType pdGap, ictgv2Norm;
+      if (gapByproducts)
+      {
+        pdGap = std::abs(gapGStar + gapNorm);
+        ictgv2Norm = gapNorm;
+        datafidelity = gapDataFidelity;
+        if (debug)
+        {
+          pdGapDeviation =
+              std::max(pdGapDeviation, std::abs(pdGap - referenceGap) / N);
+          Log("Reference Primal-Dual Gap: %.4e\n", referenceGap / N);
+        }
+      }
+      else
+      {
+        pdGap =
+            ComputePDGap(x1, x2, x3, x4, y1, y2, y3, y4, z, data_gpu, b1_gpu);
+        ictgv2Norm =
+              utils::ICTGV2Norm(x1, x2, x3, x4, div2Temp, y2Temp, params.alpha0,
+                                params.alpha1, params.alpha, width, height, params.dx, params.dy,
+                                params.dt, params.dx2, params.dy2, params.dt2);
+        datafidelity = ComputeDataFidelity(x1,data_gpu,b1_gpu);
+      }
       pdGap=pdGap/N;
       pdGapExport.push_back( pdGap );
       Log("Normalized Primal-Dual Gap after %d iterations: %.4e\n", loopCnt, pdGap);     
  
-      RType ictgv2Norm =
-              utils::ICTGV2Norm(x1, x2, x3, x4, div2Temp, y2Temp, params.alpha0,
-                                params.alpha1, params.alpha, width, height, params.dx, params.dy,
-                                params.dt, params.dx2, params.dy2, params.dt2);
       ictgvNormExport.push_back(ictgv2Norm);
-     
-      datafidelity = ComputeDataFidelity(x1,data_gpu,b1_gpu);
       dataFidelityExport.push_back(datafidelity);
 
       Log("Data-Fidelity: %.3e | ICTGV norm: %.3e\n", datafidelity,ictgv2Norm);
 
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
+      CheckPDGap(pdGap);
     }
 
      loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
+RType ICTGV2::GetPDGapDeviation() const
+{
+  return pdGapDeviation;
+}
+
 void ICTGV2::ExportAdditionalResults(const char *outputDir,
                                      ResultExportCallback callback)
 {
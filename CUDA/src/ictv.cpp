@@ -254,7 +254,21 @@ void ICTV::IterativeReconstruction(CVector &data_gpu, CVector &x1,
   // used for proximal mapping
   RType denom = std::min(params.alpha, (RType)1.0 - params.alpha);
  
-  unsigned loopCnt = 0;
+  ClearState();
+  AddPrimalState(x1, ext1);
+  AddPrimalState(x3, ext3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    AddDualState(y1[cnt]);
+    AddDualState(y3[cnt]);
+  }
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  AddHistoryState(dataFidelityExport);
+  AddHistoryState(ictvNormExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
   // loop
   Log("Starting iteration\n");
   while ( loopCnt < params.maxIt )
@@ -357,13 +371,20 @@ void ICTV::IterativeReconstruction(CVector &data_gpu, CVector &x1,
       Log("Data-Fidelity: %.3e | ICTV norm: %.3e\n", datafidelity,ictvNorm);
 
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
     }
 
      loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
@@ -0,0 +1,238 @@
+#include "../include/initial_solution.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "agile/agile.hpp"
+
+InitialSolution::InitialSolution(unsigned N, unsigned frames,
+                                 const InitialSolutionParams &params,
+                                 BaseOperator *mrOp)
+  : N(N), frames(frames), params(params), mrOp(mrOp), iterations(0),
+    initialResidual(0), residual(0)
+{
+}
+
+InitialSolution::~InitialSolution()
+{
+}
+
+unsigned InitialSolution::GetIterations() const
+{
+  return iterations;
+}
+
+RType InitialSolution::GetInitialResidual() const
+{
+  return initialResidual;
+}
+
+RType InitialSolution::GetResidual() const
+{
+  return residual;
+}
+
+void InitialSolution::Compute(CVector &kdata, CVector &u0, CVector &b1,
+                              CVector &x)
+{
+  iterations = 0;
+  if (x.size() != N * frames)
+    x.resize(N * frames, 0.0);
+  ReplicateU0(u0, x);
+
+  if (params.method == INIT_U0)
+    return;
+
+  kTemp.resize(kdata.size(), 0.0);
+  initialResidual = DataResidual(kdata, b1, x);
+
+  if (params.method == INIT_VIEWSHARING)
+    ViewSharing(kdata, b1, x);
+  else
+    CGSense(kdata, b1, x);
+
+  residual = DataResidual(kdata, b1, x);
+}
+
+void InitialSolution::ReplicateU0(CVector &u0, CVector &x)
+{
+  for (unsigned frame = 0; frame < frames; frame++)
+  {
+    utils::SetSubVector(u0, x, frame, N);
+  }
+}
+
+void InitialSolution::ViewSharing(CVector &kdata, CVector &b1, CVector &x)
+{
+  // coil combination weights sum |b1|^2
+  unsigned coils = b1.size() / N;
+  CVector sumB1(N), temp(N);
+  sumB1.assign(N, 1E-6);
+  for (unsigned coil = 0; coil < coils; coil++)
+  {
+    agile::lowlevel::multiplyConjElementwise(b1.data() + coil * N,
+                                             b1.data() + coil * N,
+                                             temp.data(), N);
+    agile::addVector(sumB1, temp, sumB1);
+  }
+
+  CartesianOperator *cartOp = dynamic_cast<CartesianOperator *>(mrOp);
+  if (cartOp != NULL && !cartOp->mask.empty())
+    SharedCartesianAdjoint(cartOp, kdata, b1, x);
+  else
+  {
+    // zero-filled adjoint images of all frames, the density compensation
+    // of the non-Cartesian operators refers to single frames
+    CVector z(N * frames);
+    agile::copy(kdata, kTemp);
+    mrOp->ForwardOperation(kTemp, z, b1);
+
+    x.assign(N * frames, 0.0);
+    for (unsigned frame = 0; frame < frames; frame++)
+    {
+      unsigned first = FirstSharedFrame(frame);
+      for (unsigned shared = first; shared < first + SharingWindow(); shared++)
+        agile::lowlevel::addVector(x.data() + frame * N,
+                                   z.data() + shared * N,
+                                   x.data() + frame * N, N);
+    }
+  }
+
+  for (unsigned frame = 0; frame < frames; frame++)
+    agile::lowlevel::divideElementwise(x.data() + frame * N, sumB1.data(),
+                                       x.data() + frame * N, N);
+
+  ScaleToData(kdata, b1, x);
+}
+
+unsigned InitialSolution::SharingWindow() const
+{
+  return std::max(1u, std::min(params.window, frames));
+}
+
+unsigned InitialSolution::FirstSharedFrame(unsigned frame) const
+{
+  // windows are shifted at the boundaries, i.e. all contain window frames
+  unsigned window = SharingWindow();
+  unsigned first = frame > window / 2 ? frame - window / 2 : 0;
+  return std::min(first, frames - window);
+}
+
+void InitialSolution::SharedCartesianAdjoint(CartesianOperator *cartOp,
+                                             CVector &kdata, CVector &b1,
+                                             CVector &x)
+{
+  unsigned coils = b1.size() / N;
+  unsigned window = SharingWindow();
+
+  // density weights: inverse number of frames of the window sampling each
+  // k-space point
+  std::vector<RType> mask, weights(N * frames, 0.0);
+  cartOp->mask.copyToHost(mask);
+  for (unsigned frame = 0; frame < frames; frame++)
+  {
+    unsigned first = FirstSharedFrame(frame);
+    for (unsigned cnt = 0; cnt < N; cnt++)
+    {
+      RType coverage = 0;
+      for (unsigned shared = first; shared < first + window; shared++)
+        coverage += mask[shared * N + cnt];
+      if (coverage > 0)
+        weights[frame * N + cnt] = 1.0 / coverage;
+    }
+  }
+  RVector weightsGPU(N * frames);
+  weightsGPU.assignFromHost(weights.begin(), weights.end());
+
+  // adjoint of the density weighted k-space of each window
+  CVector kShared(N), kSample(N), image(N);
+  x.assign(N * frames, 0.0);
+  for (unsigned frame = 0; frame < frames; frame++)
+  {
+    unsigned first = FirstSharedFrame(frame);
+    for (unsigned coil = 0; coil < coils; coil++)
+    {
+      kShared.assign(N, 0.0);
+      for (unsigned shared = first; shared < first + window; shared++)
+      {
+        agile::lowlevel::multiplyElementwise(
+            kdata.data() + (shared * coils + coil) * N,
+            cartOp->mask.data() + shared * N, kSample.data(), N);
+        agile::addVector(kShared, kSample, kShared);
+      }
+      agile::lowlevel::multiplyElementwise(kShared.data(),
+                                           weightsGPU.data() + frame * N,
+                                           kShared.data(), N);
+
+      if (cartOp->centered)
+        cartOp->fftOp->CenteredForward(kShared, image, 0, 0);
+      else
+        cartOp->fftOp->Forward(kShared, image, 0, 0);
+
+      agile::lowlevel::multiplyConjElementwise(b1.data() + coil * N,
+                                               image.data(), image.data(), N);
+      agile::lowlevel::addVector(image.data(), x.data() + frame * N,
+                                 x.data() + frame * N, N);
+    }
+  }
+}
+
+void InitialSolution::CGSense(CVector &kdata, CVector &b1, CVector &x)
+{
+  CVector r(N * frames), p(N * frames), Ap(N * frames);
+
+  // r = K^H d - K^H K x
+  agile::copy(kdata, kTemp);
+  mrOp->ForwardOperation(kTemp, r, b1);
+  RType rhsNorm = agile::norm2(r);
+  NormalOperation(x, Ap, b1);
+  agile::subVector(r, Ap, r);
+  agile::copy(r, p);
+
+  RType rr = std::pow(agile::norm2(r), 2);
+  while (iterations < params.cgIt &&
+         std::sqrt(rr) > params.cgTolerance * rhsNorm)
+  {
+    NormalOperation(p, Ap, b1);
+    RType pAp = std::real(agile::getScalarProduct(p, Ap));
+    if (pAp <= 0)
+      break;
+
+    RType alpha = rr / pAp;
+    agile::addScaledVector(x, alpha, p, x);
+    agile::subScaledVector(r, alpha, Ap, r);
+
+    RType rrNew = std::pow(agile::norm2(r), 2);
+    agile::addScaledVector(r, rrNew / rr, p, p);
+    rr = rrNew;
+    iterations++;
+  }
+}
+
+void InitialSolution::NormalOperation(CVector &x, CVector &y, CVector &b1)
+{
+  mrOp->BackwardOperation(x, kTemp, b1);
+  mrOp->ForwardOperation(kTemp, y, b1);
+}
+
+void InitialSolution::ScaleToData(CVector &kdata, CVector &b1, CVector &x)
+{
+  mrOp->BackwardOperation(x, kTemp, b1);
+  RType kxNorm = agile::norm2(kTemp);
+  if (kxNorm <= 0)
+    return;
+
+  RType scale =
+      std::real(agile::getScalarProduct(kTemp, kdata)) / (kxNorm * kxNorm);
+  agile::scale(scale, x, x);
+}
+
+RType InitialSolution::DataResidual(CVector &kdata, CVector &b1, CVector &x)
+{
+  RType dataNorm = agile::norm2(kdata);
+  if (dataNorm <= 0)
+    return 0;
+
+  mrOp->BackwardOperation(x, kTemp, b1);
+  agile::subVector(kTemp, kdata, kTemp);
+  return agile::norm2(kTemp) / dataNorm;
+}
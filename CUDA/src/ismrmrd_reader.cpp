@@ -3,10 +3,12 @@
 #include "ismrmrd/dataset.h"
 #include "ismrmrd/xml.h"
 #include "ismrmrd/version.h"
+#include <hdf5.h>
 #include <algorithm>
 
 IsmrmrdReader::IsmrmrdReader(OptionsParser &op)
-  : RawDataReader(op), filename(op.kdataFilename), dataset(NULL), hdr(NULL)
+  : RawDataReader(op), filename(op.kdataFilename), dataset(NULL), hdr(NULL),
+    perfusionData(false), nonUniformData(false)
 {
 }
 
@@ -42,7 +44,20 @@ void IsmrmrdReader::InitRawDataDimensions()
 
   rawDataDims.frames = hdr->encoding[0].encodingLimits.phase().maximum + 1;
 
-  if (this->IsPerfusionData())
+  perfusionData = this->IsPerfusionData();
+  nonUniformData = this->IsNonUniformData();
+
+  encodingCenterRows.resize(hdr->encoding.size());
+  for (unsigned enc = 0; enc < hdr->encoding.size(); enc++)
+  {
+    if (hdr->encoding[enc].encodingLimits.kspace_encoding_step_1.is_present())
+      encodingCenterRows[enc] =
+          hdr->encoding[enc].encodingLimits.kspace_encoding_step_1().center;
+    else
+      encodingCenterRows[enc] = 0;
+  }
+
+  if (perfusionData)
   {
     rawDataDims.frames =
         hdr->encoding[0].encodingLimits.repetition().maximum + 1;
@@ -130,28 +145,156 @@ bool IsmrmrdReader::IsPerfusionData() const
 
 Acquisition IsmrmrdReader::GetAcquisition(unsigned index) const
 {
+  // TODO check index range
   Acquisition acq;
   ISMRMRD::Acquisition ismrmrdAcq;
   dataset->readAcquisition(index, ismrmrdAcq);
-  assert(rawDataDims.coils == ismrmrdAcq.active_channels());
+  this->DecodeAcquisition(ismrmrdAcq, acq);
+  return acq;
+}
 
-  // TODO check index range
-  // Compute line Offset due to Partial Fourier in Phase direction
-  acq.line = ismrmrdAcq.idx().kspace_encode_step_1;
-  acq.phase = this->IsPerfusionData() ? ismrmrdAcq.idx().repetition
-                                      : ismrmrdAcq.idx().phase;
+void IsmrmrdReader::GetAcquisitions(
+    unsigned start, unsigned count,
+    std::vector<Acquisition> &acquisitions) const
+{
+  // the ISMRMRD dataset only exposes per-index reads, hence the block is
+  // read as one sequential run re-using a single acquisition buffer
+  acquisitions.resize(count);
+  ISMRMRD::Acquisition ismrmrdAcq;
+  for (unsigned cnt = 0; cnt < count; cnt++)
+  {
+    dataset->readAcquisition(start + cnt, ismrmrdAcq);
+    this->DecodeAcquisition(ismrmrdAcq, acquisitions[cnt]);
+  }
+}
+
+bool IsmrmrdReader::ReadHeaderFields(
+    std::vector<IsmrmrdHeaderFields> &fields) const
+{
+  // suppress HDF5 error stack output, failures are handled by the caller
+  H5E_auto2_t errorFunc;
+  void *errorData;
+  H5Eget_auto2(H5E_DEFAULT, &errorFunc, &errorData);
+  H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+  // memory types only contain the required members, HDF5 matches compound
+  // members by name and skips the remaining header fields, the trajectory
+  // and the sample data
+  hid_t idxType = H5Tcreate(H5T_COMPOUND, sizeof(IsmrmrdEncodingCounters));
+  H5Tinsert(idxType, "kspace_encode_step_1",
+            HOFFSET(IsmrmrdEncodingCounters, kspace_encode_step_1),
+            H5T_NATIVE_UINT16);
+  H5Tinsert(idxType, "slice", HOFFSET(IsmrmrdEncodingCounters, slice),
+            H5T_NATIVE_UINT16);
+  H5Tinsert(idxType, "phase", HOFFSET(IsmrmrdEncodingCounters, phase),
+            H5T_NATIVE_UINT16);
+  H5Tinsert(idxType, "repetition",
+            HOFFSET(IsmrmrdEncodingCounters, repetition), H5T_NATIVE_UINT16);
+
+  hid_t headType = H5Tcreate(H5T_COMPOUND, sizeof(IsmrmrdHeaderFields));
+  H5Tinsert(headType, "flags", HOFFSET(IsmrmrdHeaderFields, flags),
+            H5T_NATIVE_UINT64);
+  H5Tinsert(headType, "number_of_samples",
+            HOFFSET(IsmrmrdHeaderFields, number_of_samples), H5T_NATIVE_UINT16);
+  H5Tinsert(headType, "active_channels",
+            HOFFSET(IsmrmrdHeaderFields, active_channels), H5T_NATIVE_UINT16);
+  H5Tinsert(headType, "center_sample",
+            HOFFSET(IsmrmrdHeaderFields, center_sample), H5T_NATIVE_UINT16);
+  H5Tinsert(headType, "encoding_space_ref",
+            HOFFSET(IsmrmrdHeaderFields, encoding_space_ref),
+            H5T_NATIVE_UINT16);
+  H5Tinsert(headType, "trajectory_dimensions",
+            HOFFSET(IsmrmrdHeaderFields, trajectory_dimensions),
+            H5T_NATIVE_UINT16);
+  H5Tinsert(headType, "idx", HOFFSET(IsmrmrdHeaderFields, idx), idxType);
+
+  hid_t acqType = H5Tcreate(H5T_COMPOUND, sizeof(IsmrmrdHeaderFields));
+  H5Tinsert(acqType, "head", 0, headType);
+
+  bool success = false;
+  hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file >= 0)
+  {
+    hid_t data = H5Dopen2(file, "/dataset/data", H5P_DEFAULT);
+    if (data >= 0)
+    {
+      hid_t space = H5Dget_space(data);
+      fields.resize(H5Sget_simple_extent_npoints(space));
+      success = fields.empty() ||
+                H5Dread(data, acqType, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+                        &fields[0]) >= 0;
+      H5Sclose(space);
+      H5Dclose(data);
+    }
+    H5Fclose(file);
+  }
 
-  acq.slice = ismrmrdAcq.idx().slice;
+  H5Tclose(acqType);
+  H5Tclose(headType);
+  H5Tclose(idxType);
+  H5Eset_auto2(H5E_DEFAULT, errorFunc, errorData);
+  return success;
+}
 
-  //  std::cout << "Line/phase: " << acq.line << "," << acq.phase << std::endl;
+void IsmrmrdReader::GetAcquisitionHeaders(
+    std::vector<AcquisitionHeader> &headers) const
+{
+  std::vector<IsmrmrdHeaderFields> fields;
+  if (!this->ReadHeaderFields(fields) ||
+      fields.size() != this->GetNumberOfAcquisitions())
+  {
+    std::cout << "Reading acquisition headers directly failed, decode "
+                 "complete acquisitions." << std::endl;
+    RawDataReader::GetAcquisitionHeaders(headers);
+    return;
+  }
 
-  unsigned encodingRef = ismrmrdAcq.encoding_space_ref();
+  headers.resize(fields.size());
+  for (unsigned cnt = 0; cnt < fields.size(); cnt++)
+    this->DecodeAcquisitionHeader(fields[cnt], headers[cnt]);
+}
+
+void IsmrmrdReader::DecodeAcquisitionHeader(const IsmrmrdHeaderFields &fields,
+                                            AcquisitionHeader &header) const
+{
+  // Compute line Offset due to Partial Fourier in Phase direction
+  header.line = fields.idx.kspace_encode_step_1;
+  header.phase = perfusionData ? fields.idx.repetition : fields.idx.phase;
+  header.slice = fields.idx.slice;
 
   // set encoding meta info
-  acq.readouts = ismrmrdAcq.number_of_samples();
-  acq.centerRow =
-      hdr->encoding[encodingRef].encodingLimits.kspace_encoding_step_1().center;
-  acq.centerColumn = ismrmrdAcq.center_sample();
+  header.readouts = fields.number_of_samples;
+  header.centerRow = encodingCenterRows[fields.encoding_space_ref];
+  header.centerColumn = fields.center_sample;
+
+  header.hasTrajectory = nonUniformData || fields.trajectory_dimensions > 0;
+  header.isNoiseMeasurement = ISMRMRD::ismrmrd_is_flag_set(
+      fields.flags, ISMRMRD::ISMRMRD_ACQ_IS_NOISE_MEASUREMENT) /*||
+      ISMRMRD::ismrmrd_is_flag_set(
+          fields.flags, ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION)*/;
+}
+
+void IsmrmrdReader::DecodeAcquisition(ISMRMRD::Acquisition &ismrmrdAcq,
+                                      Acquisition &acq) const
+{
+  assert(rawDataDims.coils == ismrmrdAcq.active_channels());
+
+  // reset trajectory in case acq is re-used
+  acq.traj.clear();
+  acq.dens.clear();
+
+  IsmrmrdHeaderFields fields;
+  fields.flags = ismrmrdAcq.flags();
+  fields.number_of_samples = ismrmrdAcq.number_of_samples();
+  fields.active_channels = ismrmrdAcq.active_channels();
+  fields.center_sample = ismrmrdAcq.center_sample();
+  fields.encoding_space_ref = ismrmrdAcq.encoding_space_ref();
+  fields.trajectory_dimensions = ismrmrdAcq.trajectory_dimensions();
+  fields.idx.kspace_encode_step_1 = ismrmrdAcq.idx().kspace_encode_step_1;
+  fields.idx.slice = ismrmrdAcq.idx().slice;
+  fields.idx.phase = ismrmrdAcq.idx().phase;
+  fields.idx.repetition = ismrmrdAcq.idx().repetition;
+  this->DecodeAcquisitionHeader(fields, acq);
 
   bool hasTrajectoryInformation = ismrmrdAcq.getNumberOfTrajElements() > 0;
   // if (hasTrajectoryInformation)
@@ -160,70 +303,49 @@ Acquisition IsmrmrdReader::GetAcquisition(unsigned index) const
   // unsigned N = rawDataDims.readouts;
   unsigned N = ismrmrdAcq.number_of_samples();
 
-  if (ismrmrdAcq.isFlagSet(ISMRMRD::ISMRMRD_ACQ_IS_NOISE_MEASUREMENT) /*||
-      ismrmrdAcq.isFlagSet(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION)*/)
-  {
+  if (acq.isNoiseMeasurement)
     std::cout << "NOISE MEASUREMENT! "
               << " lineIdx: " << acq.line << std::endl;
-    acq.isNoiseMeasurement = true;
-  }
-  else
-    acq.isNoiseMeasurement = false;
 
-  for (unsigned coil = 0; coil < rawDataDims.coils; coil++)
-  {
-    unsigned coilOffset = coil * ismrmrdAcq.number_of_samples();
-    std::vector<CType> coilData(ismrmrdAcq.number_of_samples());
-    coilData.assign(coilData.size(), 0);
+  acq.resizeData(rawDataDims.coils, N);
 
-    // check if trajectory data is embedded
-    if (hasTrajectoryInformation)
+  // check if trajectory data is embedded
+  if (hasTrajectoryInformation)
+  {
+    acq.traj.assign(N, 0);
+    acq.dens.assign(N, 0);
+
+    // TODO doesn't seem to work with test data
+    // order in data array is flipped (coils, samples), hence the data is
+    // transposed into the coil-major acquisition buffer
+    const CType *samples = ismrmrdAcq.getDataPtr();
+    for (unsigned pos = 0; pos < N; pos++)
     {
-      if (coil == 0)
-      {
-        acq.traj.resize(N);
-        acq.dens.resize(N);
+      unsigned x = ismrmrdAcq.traj(0, pos);
+      unsigned y = ismrmrdAcq.traj(1, pos);
+      assert(y == acq.line);
 
-        acq.traj.assign(N, 0);
-        acq.dens.assign(N, 0);
-      }
+      for (unsigned coil = 0; coil < rawDataDims.coils; coil++)
+        acq.data[pos + coil * N] = samples[coil + pos * rawDataDims.coils];
 
-      for (unsigned pos = 0; pos < ismrmrdAcq.number_of_samples(); pos++)
-      {
-        unsigned x = ismrmrdAcq.traj(0, pos);
-        unsigned y = ismrmrdAcq.traj(1, pos);
-        assert(y == acq.line);
-        // TODO doesn't seem to work with test data
-        // order in data array is flipped (coils, samples)
-        //
-        // coilData[x] = ismrmrdAcq.data(pos, coil);
-        coilData[pos] = ismrmrdAcq.getDataPtr()[coil + pos * rawDataDims.coils];
-
-        if (coil == 0)
-        {
-          // x
-          acq.traj[pos] = x;
-
-          // density compensation
-          // TODO density information?
-          acq.dens[pos] = 1.0;
-        }
-      }
-    }
-    else
-    {
-      // expect fully acquired line
-      std::copy(ismrmrdAcq.data_begin() + coilOffset,
-                ismrmrdAcq.data_begin() + coilOffset +
-                    ismrmrdAcq.number_of_samples(),
-                coilData.begin());
-    }
+      // x
+      acq.traj[pos] = x;
 
-    acq.data.insert(std::make_pair(coil, coilData));
+      // density compensation
+      // TODO density information?
+      acq.dens[pos] = 1.0;
+    }
+  }
+  else
+  {
+    // expect fully acquired line, data is already stored coil-major
+    std::copy(ismrmrdAcq.data_begin(),
+              ismrmrdAcq.data_begin() + rawDataDims.coils * N,
+              acq.data.begin());
   }
 
   // Set trajectory mask data
-  if (this->IsNonUniformData())
+  if (nonUniformData)
   {
     // std::cout << "Number of samples: " << ismrmrdAcq.number_of_samples()
     //          << std::endl << "Readouts: " << rawDataDims.readouts <<
@@ -250,7 +372,5 @@ Acquisition IsmrmrdReader::GetAcquisition(unsigned index) const
                                      rawDataDims.encodings,
                                      ismrmrdAcq.number_of_samples());
   }
-
-  return acq;
 }
 
@@ -12,6 +12,7 @@
 #include <math.h>
 #include <algorithm> 
 #include "../include/raw_data_preparation.h"
+#include "../include/coil_compression.h"
 #include "../include/cartesian_coil_construction.h"
 #include "../include/noncartesian_coil_construction.h"
 #include "../include/ictgv2.h"
@@ -24,6 +25,10 @@
 #include "../include/cartesian_operator3d.h"
 #include "../include/noncartesian_operator3d.h"
 #include "../include/options_parser.h"
+#include "../include/initial_solution.h"
+#include "../include/subspace_operator.h"
+#include "../include/sensitivity_cache.h"
+#include "../include/solver_checkpoint.h"
 #include "../include/utils.h"
 template <typename TType>
 
@@ -68,13 +73,9 @@ bool LoadGPUVectorFromFile(std::string &filename, TType &data)
 return true;
 }
 
-void GenerateReconOperator(PDRecon **recon, OptionsParser &options,
-                           BaseOperator *mrOp)
+void CreateReconOperator(PDRecon **recon, OptionsParser &options,
+                         Dimension &dims, BaseOperator *mrOp)
 {
-  Dimension dims = options.dims;
-  assert(dims.width == 0 || dims.height == 0 || dims.depth ==0 ||dims.coils == 0 ||
-         dims.frames == 0);
-
   // adapt dims to correspond to image space dimensions
   std::cout << "method set to: ";
   switch (options.method)
@@ -135,6 +136,26 @@ void GenerateReconOperator(PDRecon **recon, OptionsParser &options,
   }
 }
 
+void GenerateReconOperator(PDRecon **recon, OptionsParser &options,
+                           Dimension &dims, BaseOperator *mrOp)
+{
+  assert(dims.width == 0 || dims.height == 0 || dims.depth ==0 ||dims.coils == 0 ||
+         dims.frames == 0);
+
+  CreateReconOperator(recon, options, dims, mrOp);
+
+  if (!options.checkpointFilename.empty())
+  {
+    (*recon)->SetCheckpoint(options.checkpointFilename,
+                            options.checkpointInterval);
+    SolverCheckpoint::InstallSignalHandler();
+  }
+  if (!options.resumeFilename.empty())
+    (*recon)->SetResume(options.resumeFilename);
+  else if (!options.warmStartFilename.empty())
+    (*recon)->SetResume(options.warmStartFilename, true);
+}
+
 void PerformRawdataNormalization(Dimension &dims,OptionsParser &op,
                       CVector &kdata, RVector &mask, RVector &w, CType &datanorm)
 {
@@ -170,10 +191,87 @@ void ExportAdditionalResultsToMatlabBin2(const char *outputDir,
 }
 
 
+void PerformMultiresolutionReconstruction(Dimension &dims,
+                                          OptionsParser &op, CVector &kdata,
+                                          RVector &mask, CVector &b1,
+                                          CVector &x)
+{
+  // the coarse levels run on the k-space centre, the prolongated result of
+  // each level initializes the next finer one
+  CVector coarseX(0);
+  unsigned coarseWidth = 0;
+  unsigned coarseHeight = 0;
+  for (unsigned level = op.multiresParams.levels - 1; level > 0; level--)
+  {
+    unsigned factor = 1u << level;
+    unsigned lowWidth = 2 * std::max(1u, dims.width / (2 * factor));
+    unsigned lowHeight = 2 * std::max(1u, dims.height / (2 * factor));
+    unsigned N = dims.width * dims.height;
+    unsigned lowN = lowWidth * lowHeight;
+    std::cout << "Multiresolution level " << level << " on " << lowWidth
+              << "x" << lowHeight << " grid." << std::endl;
+
+    CVector lowKdata(lowN * dims.coils * dims.frames);
+    utils::CropKSpaceCenter(kdata, lowKdata, dims.width, dims.height,
+                            lowWidth, lowHeight, dims.coils * dims.frames);
+    RVector lowMask(lowN * dims.frames);
+    utils::CropKSpaceCenter(mask, lowMask, dims.width, dims.height, lowWidth,
+                            lowHeight, dims.frames);
+
+    // keep image amplitudes and correct the chop sign of the cropped grid
+    RType sign =
+        ((dims.width / 2 - lowWidth / 2) + (dims.height / 2 - lowHeight / 2)) %
+                    2 == 0 ? 1.0 : -1.0;
+    agile::scale((CType)(sign * std::sqrt((RType)lowN / (RType)N)), lowKdata,
+                 lowKdata);
+
+    CVector lowB1(lowN * dims.coils);
+    utils::DownsampleImages(b1, lowB1, dims.width, dims.height, lowWidth,
+                            lowHeight, dims.coils);
+
+    CVector lowX(lowN * dims.frames);
+    if (coarseX.size() == 0)
+      utils::DownsampleImages(x, lowX, dims.width, dims.height, lowWidth,
+                              lowHeight, dims.frames);
+    else
+      utils::UpsampleImages(coarseX, lowX, coarseWidth, coarseHeight,
+                            lowWidth, lowHeight, dims.frames);
+
+    Dimension lowDims = dims;
+    lowDims.width = lowWidth;
+    lowDims.height = lowHeight;
+    CartesianOperator *cartOp = new CartesianOperator(
+        lowWidth, lowHeight, dims.coils, dims.frames, lowMask, false);
+    PDRecon *recon = NULL;
+    CreateReconOperator(&recon, op, lowDims, cartOp);
+    recon->GetParams().maxIt = op.multiresParams.maxIt;
+    recon->IterativeReconstruction(lowKdata, lowX, lowB1);
+    std::cout << "Iterations: " << recon->GetIterations() << std::endl;
+    delete recon;
+    delete cartOp;
+
+    coarseX.resize(lowX.size(), 0.0);
+    agile::copy(lowX, coarseX);
+    coarseWidth = lowWidth;
+    coarseHeight = lowHeight;
+  }
+
+  utils::UpsampleImages(coarseX, x, coarseWidth, coarseHeight, dims.width,
+                        dims.height, dims.frames);
+}
+
 void PerformCartesianCoilConstruction(Dimension &dims, OptionsParser &op,
                                       CVector &kdata, CVector &u, CVector &b1,
                                       RVector &mask, communicator_type &com)
 {
+  if (op.coilParams.lowResFactor > 1)
+  {
+    CartesianCoilConstruction::PerformLowResCoilConstruction(
+        dims.width, dims.height, dims.coils, dims.frames, op.coilParams, kdata,
+        mask, u, b1, com, op.verbose);
+    return;
+  }
+
   // Create MR Operator
   CartesianOperator *cartOp = new CartesianOperator(
       dims.width, dims.height, dims.coils, dims.frames, mask, false);
@@ -194,6 +292,10 @@ void PerformNonCartesianCoilConstruction(Dimension &dims, OptionsParser &op,
   unsigned spokesPerFrame = dims.encodings;
   unsigned int nTraj = dims.frames * spokesPerFrame * nFE;
 
+  if (op.coilParams.lowResFactor > 1)
+    std::cout << "Low resolution coil construction is only available for "
+                 "Cartesian data." << std::endl;
+
   // TODO check if density data is already generated by RAW data import
   // or if it has to be loaded from file
   if (w.size() == 0)
@@ -241,9 +343,6 @@ void PerformInitalizationGivenB1(Dimension &dims, OptionsParser &op,
       dims.width, dims.height, dims.coils, dims.frames, op.coilParams,
       noncartOp);
 
-  CVector tmp_crec(dims.width * dims.height);
-  tmp_crec.assign(tmp_crec.size(), 0);
-
   CVector tmp_b1(dims.width * dims.height);
   tmp_b1.assign(tmp_b1.size(), 0);
 
@@ -255,9 +354,10 @@ void PerformInitalizationGivenB1(Dimension &dims, OptionsParser &op,
 
   for (unsigned coil = 0; coil < dims.coils; coil++)
    {
-    utils::GetSubVector(crec, tmp_crec, coil, dims.width * dims.height);
-    utils::GetSubVector(b1, tmp_b1, coil, dims.width * dims.height); 
-    agile::multiplyConjElementwise(tmp_b1, tmp_crec, tmp_b1);
+    CVectorView crecCoil = CVectorView::Slice(crec, coil, tmp_b1.size());
+    CVectorView b1Coil = CVectorView::Slice(b1, coil, tmp_b1.size());
+    agile::lowlevel::multiplyConjElementwise(b1Coil.data(), crecCoil.data(),
+                                             tmp_b1.data(), tmp_b1.size());
     agile::addVector(u0, tmp_b1, u0);
   }
   agile::scale((CType) 0.5, u0, u0);
@@ -295,6 +395,132 @@ void PerformRawDataPreparation(Dimension &dims, OptionsParser &op,
     */
 }
 
+void InitSensitivityCacheKey(SensitivityCache &cache, Dimension &dims,
+                             OptionsParser &op, CVector &kdata, RVector &mask,
+                             RVector &w)
+{
+  // all inputs of the coil construction, kdata is already prepared and
+  // compressed
+  cache.AddToKey(kdata);
+  cache.AddToKey(mask);
+  cache.AddToKey(w);
+  cache.AddToKey(dims);
+  cache.AddToKey(op.coilParams);
+  cache.AddValueToKey((unsigned char)op.nonuniform);
+  if (op.nonuniform)
+  {
+    cache.AddValueToKey(op.gpuNUFFTParams.kernelWidth);
+    cache.AddValueToKey(op.gpuNUFFTParams.sectorWidth);
+    cache.AddValueToKey(op.gpuNUFFTParams.osf);
+  }
+}
+
+void PerformCoilCompression(Dimension &dims, OptionsParser &op,
+                            CVector &kdata)
+{
+  std::cout << "Compress " << dims.coils << " coils." << std::endl;
+  agile::GPUTimer timer;
+  timer.start();
+
+  CoilCompression coilCompression(op.compressionParams);
+  coilCompression.SetVerbose(op.verbose);
+  coilCompression.Compress(kdata, dims, !op.nonuniform);
+  op.dims = dims;
+
+  std::cout << "Coil compression time: " << timer.stop() / 1000 << "s"
+            << std::endl;
+}
+
+// ==================================================================================================================
+// write reconstruction to bin, h5 (or dicom) file
+// ==================================================================================================================
+void WriteReconstruction(const std::string &filename, Dimension &dims,
+                         CVector &x)
+{
+  std::string extension_out = utils::GetFileExtension(filename);
+  std::vector<CType> xHost;
+  x.copyToHost(xHost);
+ 
+  // write reconstruction to bin file 
+  if (extension_out.compare(".bin") == 0)
+  {
+    std::cout << "writing output file to: " << filename << std::endl;
+    agile::writeVectorFile(filename.c_str(), xHost); 
+  }
+  // write reconstruction to h5 file 
+  else if (extension_out.compare(".h5") == 0)
+  {
+    std::vector<size_t> dimVec;
+    dimVec.push_back(dims.width);
+    dimVec.push_back(dims.height);
+    dimVec.push_back(dims.frames);
+    utils::WriteH5File(filename, "recon", dimVec, xHost);
+  }
+  // write reconstruction to dicom file 
+  else if (extension_out.compare(".dcm") == 0)   
+  {
+    std::cout << "currently not supported" << std::endl;
+
+/*
+    agile::DICOM dicomfile;
+    std::string filenamewoe = utils::GetFilename(filename);
+    std::ostringstream ss;	 
+    for (unsigned frame = 0; frame < dims.frames; frame++) 
+    {
+      std::vector<float> xoutmag;
+      std::vector<float> xoutphs;
+      for( unsigned i = N*frame; i < N*(frame+1); i++ )
+        {
+        xoutmag.push_back( (float)std::sqrt( pow(real(xHost[i]),2) + pow(std::imag(xHost[i]),2) ) ) ;
+        xoutphs.push_back( (float)std::atan2( real(xHost[i]),std::imag(xHost[i]) ) );
+        }
+      
+      ss << std::setw(3) << std::setfill('0') << frame;
+      // magnitude
+      const std::string str = ss.str();      
+      std::string outputPath1 = boost::lexical_cast<std::string>(outputDir) + "/" + filenamewoe + "_magframe" + ss.str() + ".dcm"; 
+      std::cout << "writing dicom file to: " << outputPath1 << std::endl;   
+      //dicomfile.set_dicominfo(_in_dicomfile.get_dicominfo());  
+      dicomfile.gendicom(outputPath1.c_str(), xoutmag, dims.height, dims.width); 
+ 
+      // phase     
+      std::string outputPath2 = boost::lexical_cast<std::string>(outputDir) + "/" + filenamewoe + "_phsframe" + ss.str() + ".dcm"; 
+      std::cout << "writing dicom file to: " << outputPath2 << std::endl; 
+  
+      //dicomfile.set_dicominfo(_in_dicomfile.get_dicominfo());  
+      dicomfile.gendicom(outputPath2.c_str(), xoutphs, dims.height, dims.width); 
+ 
+      ss.str("");   
+    }
+*/
+  }
+  else
+  {
+     // write reconstruction to binary file
+     agile::writeVectorFile(filename.c_str(), xHost);
+  }
+}
+
+void ComputeInitialSolution(Dimension &dims, OptionsParser &op, unsigned N,
+                            BaseOperator *baseOp, CVector &kdata, CVector &u0,
+                            CVector &b1, CVector &x)
+{
+  unsigned frames = op.method == TGV2_3D ? 1 : dims.frames;
+  InitialSolution init(N, frames, op.initParams, baseOp);
+  init.Compute(kdata, u0, b1, x);
+
+  if (op.initParams.method == INIT_VIEWSHARING)
+    std::cout << "Initial solution: view sharing of "
+              << op.initParams.window << " frames";
+  else if (op.initParams.method == INIT_CGSENSE)
+    std::cout << "Initial solution: " << init.GetIterations()
+              << " CG-SENSE iterations";
+  else
+    return;
+  std::cout << ", relative data residual " << init.GetInitialResidual()
+            << " (u0) -> " << init.GetResidual() << std::endl;
+}
+
 // ==================================================================================================================
 // BEGIN: main
 // ==================================================================================================================
@@ -468,6 +694,18 @@ int main(int argc, char *argv[])
   // end rawdata preparation
   // ==================================================================================================================
 
+  // ==================================================================================================================
+  // coil compression
+  // ==================================================================================================================
+  if (CoilCompression::IsEnabled(op.compressionParams))
+  {
+    if (op.method == TGV2_3D || !op.sensitivitiesFilename.empty())
+      std::cout << "Coil compression skipped (3D reconstruction or "
+                   "sensitivities provided)." << std::endl;
+    else
+      PerformCoilCompression(dims, op, kdata);
+  }
+
   BaseOperator *baseOp = NULL;
 
   // define image space dimension N
@@ -511,20 +749,37 @@ int main(int argc, char *argv[])
                  << std::endl;
        return -1;
     } 
-    std::cout << "Performing Coil Construction!" << std::endl;
-    CVector u(N * dims.coils);
-    u.assign(N * dims.coils, 0.0);
 
-    if (op.nonuniform)
+    SensitivityCache cache(op.sensitivityCacheDir);
+    if (cache.IsEnabled())
+      InitSensitivityCacheKey(cache, dims, op, kdata, mask, w);
+
+    if (cache.Load(dims, b1, u0))
     {
-      PerformNonCartesianCoilConstruction(dims, op, kdata, u, b1, mask, w, com);
+      std::cout << "Coil sensitivities and u0 loaded from cache "
+                << cache.GetFilename() << std::endl;
     }
     else
     {
-      PerformCartesianCoilConstruction(dims, op, kdata, u, b1, mask, com);
-    }
-    utils::GetSubVector(u, u0, dims.coils - 1, N);
+      std::cout << "Performing Coil Construction!" << std::endl;
+      CVector u(N * dims.coils);
+      u.assign(N * dims.coils, 0.0);
+
+      if (op.nonuniform)
+      {
+        PerformNonCartesianCoilConstruction(dims, op, kdata, u, b1, mask, w,
+                                            com);
+      }
+      else
+      {
+        PerformCartesianCoilConstruction(dims, op, kdata, u, b1, mask, com);
+      }
+      utils::GetSubVector(u, u0, dims.coils - 1, N);
 
+      if (cache.Store(dims, b1, u0))
+        std::cout << "Coil sensitivities and u0 stored in cache "
+                  << cache.GetFilename() << std::endl;
+    }
   }
 
   if (op.nonuniform)
@@ -595,119 +850,154 @@ int main(int argc, char *argv[])
   // ==================================================================================================================
   // BEGIN: Perform iterative (TV, TVtemp, TGV2, TGV_3D, ICTV, ICTGV2) reconstruction
   // ==================================================================================================================
-  PDRecon *recon = NULL;
-  GenerateReconOperator(&recon, op, baseOp);
+  CVector xInit(0); // resize at runtime
+  ComputeInitialSolution(dims, op, N, baseOp, kdata, u0, b1, xInit);
+  CVector x(xInit.size());
+  agile::copy(xInit, x);
+ 
+  std::cout << "Initialization time: " << timer.stop() / 1000 << "s"
+            << std::endl;
 
-  CVector x(0); // resize at runtime
-  if (op.method==TGV2_3D)
+  if (op.multiresParams.levels > 1)
   {
-    x.resize(N, 0.0);
-    agile::copy(u0, x);
+    if (op.nonuniform || op.method == TGV2_3D)
+    {
+      std::cout << "Multiresolution skipped (non-Cartesian or 3D "
+                   "reconstruction)." << std::endl;
+    }
+    else
+    {
+      timer.start();
+      PerformMultiresolutionReconstruction(dims, op, kdata, mask, b1, xInit);
+      agile::copy(xInit, x);
+      std::cout << "Multiresolution time: " << timer.stop() / 1000 << "s"
+                << std::endl;
+    }
   }
-  else
+
+  // low-rank temporal subspace: the solvers reconstruct the coefficient
+  // images of a temporal basis estimated from the initial solution. The
+  // coefficient images are no time series, i.e. they are only regularized
+  // spatially and TVtemp is not supported.
+  BaseOperator *reconOp = baseOp;
+  SubspaceOperator *subspaceOp = NULL;
+  Dimension reconDims = op.dims;
+  std::vector<CType> basis;
+  CVector series(0);
+  if (op.subspaceRank > 0)
   {
-    x.resize(N * dims.frames, 0.0);
-    for (unsigned frame = 0; frame < dims.frames; frame++)
+    if (op.method == TGV2_3D || op.method == TVtemp ||
+        op.subspaceRank >= dims.frames)
+    {
+      std::cout << "Subspace reconstruction skipped (3D or temporal TV "
+                   "reconstruction or rank not below frames)." << std::endl;
+    }
+    else
     {
-      utils::SetSubVector(u0, x, frame, N);
+      RType residualEnergy = SubspaceOperator::EstimateBasis(
+          xInit, N, dims.frames, op.subspaceRank, basis);
+      std::cout << "Subspace reconstruction with " << op.subspaceRank
+                << " of " << dims.frames << " temporal basis functions, "
+                << "energy not captured: " << residualEnergy << std::endl;
+
+      subspaceOp = new SubspaceOperator(baseOp, dims.width, dims.height,
+                                        dims.coils, dims.frames, basis,
+                                        op.subspaceRank);
+      reconOp = subspaceOp;
+      reconDims.frames = op.subspaceRank;
+
+      CVector coefficients(N * op.subspaceRank);
+      subspaceOp->Project(xInit, coefficients);
+      series.resize(xInit.size(), 0.0);
+      xInit = coefficients;
+      x = coefficients;
     }
   }
- 
-  std::cout << "Initialization time: " << timer.stop() / 1000 << "s"
-            << std::endl;
-
-  timer.start();
-
-
-  // run reconstruction
-  recon->IterativeReconstruction(kdata, x, b1);
 
   // rescale
   std::vector<CType> datanorm_v;
   datanorm_v.push_back(datanorm);
   ExportAdditionalResultsToMatlabBin2(outputDir.c_str(),"datanorm_factor.bin",datanorm_v);
-  std::cout << "Execution time: " << timer.stop() / 1000 << "s" << std::endl;
 
-  // ==================================================================================================================
-  // END: Perform iterative (TV, TVtemp, TGV2, TGV_3D, ICTV, ICTGV2) reconstruction
-  // ==================================================================================================================
+  // parameter sweep: kdata, b1 and the operator are shared by all sets,
+  // results are written to <output>_sweep<set>
+  bool sweep = !op.parameterSets.empty();
+  unsigned setCount = sweep ? op.parameterSets.size() : 1;
+  std::string sweepName = outputDir + "/" +
+                          utils::GetFilename(op.outputFilename) + "_sweep";
+  std::ofstream sweepLog;
+  if (sweep)
+    sweepLog.open((sweepName + ".txt").c_str());
+
+  for (unsigned set = 0; set < setCount; set++)
+  {
+    std::string outputFilename = op.outputFilename;
+    std::string resultDir = outputDir;
+    if (sweep)
+    {
+      op.ApplyParameterSet(set);
+      resultDir = sweepName + boost::lexical_cast<std::string>(set);
+      outputFilename = resultDir + utils::GetFileExtension(op.outputFilename);
+      std::cout << "Parameter set " << set << ": " << op.parameterSets[set]
+                << std::endl;
 
+      // with warm start the previous result is the initial solution, i.e.
+      // the sets are traversed as continuation path
+      if (set > 0 && !op.sweepWarmStart)
+        agile::copy(xInit, x);
+    }
 
-  // ==================================================================================================================
-  // BEGIN: Define output 
-  // ================================================================================================================== 
-  std::string extension_out = utils::GetFileExtension(op.outputFilename);
-  std::vector<CType> xHost;
-  x.copyToHost(xHost);
- 
-  // write reconstruction to bin file 
-  if (extension_out.compare(".bin") == 0)
-  {
-    std::cout << "writing output file to: " << op.outputFilename << std::endl;
-    agile::writeVectorFile(op.outputFilename.c_str(), xHost); 
-  }
-  // write reconstruction to h5 file 
-  else if (extension_out.compare(".h5") == 0)
-  {
-    std::vector<size_t> dimVec;
-    dimVec.push_back(dims.width);
-    dimVec.push_back(dims.height);
-    dimVec.push_back(dims.frames);
-    utils::WriteH5File(op.outputFilename, "recon", dimVec, xHost);
-  }
-  // write reconstruction to dicom file 
-  else if (extension_out.compare(".dcm") == 0)   
-  {
-    std::cout << "currently not supported" << std::endl;
+    PDRecon *recon = NULL;
+    GenerateReconOperator(&recon, op, reconDims, reconOp);
+    recon->SetTemporalRegularization(subspaceOp == NULL);
 
-/*
-    agile::DICOM dicomfile;
-    std::string filenamewoe = utils::GetFilename(op.outputFilename);
-    std::ostringstream ss;	 
-    for (unsigned frame = 0; frame < dims.frames; frame++) 
+    timer.start();
+
+    // run reconstruction
+    recon->IterativeReconstruction(kdata, x, b1);
+
+    double executionTime = timer.stop() / 1000;
+    std::cout << "Execution time: " << executionTime << "s" << std::endl;
+    std::cout << "Iterations: " << recon->GetIterations() << std::endl;
+    if (recon->GetAndersonSteps() > 0)
+      std::cout << "Anderson steps: " << recon->GetAndersonSteps() << std::endl;
+
+    // image series of the subspace coefficients
+    if (subspaceOp != NULL)
+      subspaceOp->Expand(x, series);
+    WriteReconstruction(outputFilename, dims, subspaceOp != NULL ? series : x);
+
+    // export additional information (pdgap, ictgv-component)
+    if (op.extradata)
     {
-      std::vector<float> xoutmag;
-      std::vector<float> xoutphs;
-      for( unsigned i = N*frame; i < N*(frame+1); i++ )
-        {
-        xoutmag.push_back( (float)std::sqrt( pow(real(xHost[i]),2) + pow(std::imag(xHost[i]),2) ) ) ;
-        xoutphs.push_back( (float)std::atan2( real(xHost[i]),std::imag(xHost[i]) ) );
-        }
-      
-      ss << std::setw(3) << std::setfill('0') << frame;
-      // magnitude
-      const std::string str = ss.str();      
-      std::string outputPath1 = boost::lexical_cast<std::string>(outputDir) + "/" + filenamewoe + "_magframe" + ss.str() + ".dcm"; 
-      std::cout << "writing dicom file to: " << outputPath1 << std::endl;   
-      //dicomfile.set_dicominfo(_in_dicomfile.get_dicominfo());  
-      dicomfile.gendicom(outputPath1.c_str(), xoutmag, dims.height, dims.width); 
- 
-      // phase     
-      std::string outputPath2 = boost::lexical_cast<std::string>(outputDir) + "/" + filenamewoe + "_phsframe" + ss.str() + ".dcm"; 
-      std::cout << "writing dicom file to: " << outputPath2 << std::endl; 
-  
-      //dicomfile.set_dicominfo(_in_dicomfile.get_dicominfo());  
-      dicomfile.gendicom(outputPath2.c_str(), xoutphs, dims.height, dims.width); 
- 
-      ss.str("");   
+      if (sweep)
+        boost::filesystem::create_directories(resultDir);
+      recon->ExportAdditionalResults(resultDir.c_str(),
+                                     &ExportAdditionalResultsToMatlabBin);
+      if (subspaceOp != NULL)
+      {
+        ExportAdditionalResultsToMatlabBin2(resultDir.c_str(),
+                                            "subspace_basis.bin", basis);
+        ExportAdditionalResultsToMatlabBin(resultDir.c_str(),
+                                           "subspace_coefficients.bin", x);
+      }
     }
-*/
-  }
-  else
-  {
-     // write reconstruction to binary file
-     agile::writeVectorFile(op.outputFilename.c_str(), xHost);
-  }
 
-  // export additional information (pdgap, ictgv-component)
-  if (op.extradata)
-    recon->ExportAdditionalResults(outputDir.c_str(),
-                                   &ExportAdditionalResultsToMatlabBin);
+    if (sweep)
+      sweepLog << set << "\t" << op.parameterSets[set] << "\t"
+               << recon->GetIterations() << "\t" << executionTime << "s\t"
+               << outputFilename << std::endl;
+
+    delete recon;
+
+    // a terminated sweep is not continued with the next set
+    if (SolverCheckpoint::TerminationRequested())
+      break;
+  }
+  // ==================================================================================================================
+  // END: Perform iterative (TV, TVtemp, TGV2, TGV_3D, ICTV, ICTGV2) reconstruction
   // ==================================================================================================================
-  // END: Define output 
-  // ================================================================================================================== 
 
-  delete recon;
+  delete subspaceOp;
   delete baseOp;
 }
-
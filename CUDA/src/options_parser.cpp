@@ -1,5 +1,7 @@
 #include "../include/options_parser.h"
 #include <boost/lexical_cast.hpp>
+#include <sstream>
+#include <stdexcept>
 #include "../include/config_dir.h"
 
 std::istream &operator>>(std::istream &in, Method &method)
@@ -39,6 +41,60 @@ std::istream &operator>>(std::istream &in, Method &method)
   return in;
 }
 
+std::istream &operator>>(std::istream &in, PDVariant &variant)
+{
+  std::string token;
+  in >> token;
+  token = boost::to_upper_copy(token);
+
+  if (token == "STANDARD")
+  {
+    variant = PD_STANDARD;
+  }
+  else if (token == "ACCELERATED")
+  {
+    variant = PD_ACCELERATED;
+  }
+  else if (token == "ADAPTIVE")
+  {
+    variant = PD_ADAPTIVE;
+  }
+  else if (token == "STOCHASTIC")
+  {
+    variant = PD_STOCHASTIC;
+  }
+  else
+  {
+    throw std::runtime_error("invalid primal-dual variant selected");
+  }
+  return in;
+}
+
+std::istream &operator>>(std::istream &in, InitMethod &method)
+{
+  std::string token;
+  in >> token;
+  token = boost::to_upper_copy(token);
+
+  if (token == "U0")
+  {
+    method = INIT_U0;
+  }
+  else if (token == "VIEWSHARING")
+  {
+    method = INIT_VIEWSHARING;
+  }
+  else if (token == "CGSENSE")
+  {
+    method = INIT_CGSENSE;
+  }
+  else
+  {
+    throw std::runtime_error("invalid initialization method selected");
+  }
+  return in;
+}
+
 void validate(boost::any &v, const std::vector<std::string> &values,
               Dimension *target, int c)
 {
@@ -66,7 +122,8 @@ void validate(boost::any &v, const std::vector<std::string> &values,
 }
 
 OptionsParser::OptionsParser()
-  : desc("Allowed options"), conf("Configuration"), hidden("Hidden options")
+  : desc("Allowed options"), conf("Configuration"), hidden("Hidden options"),
+    solver("Solver parameters")
 {
     desc.add_options()("help,h", "show help message")("debugstep,g", po::value<int>(&debugstep)->default_value(10),"flag to export PDGap")(
       "verbose,v", po::bool_switch(&verbose)->default_value(false),
@@ -93,10 +150,30 @@ OptionsParser::OptionsParser()
       "sens,s", po::value<std::string>(&sensitivitiesFilename),
       "Coil sensitivity data.")("uzero,u", po::value<std::string>(&u0Filename),
                                 "Initial image u0.")(
+      "sensCache,c", po::value<std::string>(&sensitivityCacheDir),
+      "Directory of the coil sensitivity cache.")(
+      "checkpoint", po::value<std::string>(&checkpointFilename),
+      "Solver checkpoint file, written on SIGTERM.")(
+      "checkpointInterval",
+      po::value<unsigned>(&checkpointInterval)->default_value(0),
+      "iterations between checkpoints (0: only on SIGTERM)")(
+      "resume", po::value<std::string>(&resumeFilename),
+      "continue the reconstruction from a checkpoint")(
+      "warmStart", po::value<std::string>(&warmStartFilename),
+      "initialize primal and dual variables from a checkpoint")(
+      "sweep", po::value<std::string>(&sweepFilename),
+      "parameter sweep file, one parameter set (key=value, ...) per line")(
+      "sweepWarmStart",
+      po::bool_switch(&sweepWarmStart)->default_value(false),
+      "initialize each parameter set with the previous result")(
       "rawdata,r", po::bool_switch(&rawdata)->default_value(false),
       "flag to indicate raw data import")(
       "forceOSRemoval,f", po::bool_switch(&forceOSRemoval)->default_value(false),
       "flag to force OS removal in raw data preparation")(
+      "sosNormalization",
+      po::bool_switch(&sosNormalization)->default_value(false),
+      "flag to normalize non-Cartesian raw data to the sum-of-squares image "
+      "instead of the coil combined image")(
       "tpat,t", po::value<int>(&tpat)->default_value(1),
       "artifical TPAT interleave")(
       "slice,z", po::value<unsigned int>(&slice)->default_value(0),
@@ -107,15 +184,31 @@ OptionsParser::OptionsParser()
       "maxIt,i", po::value<int>()->default_value(500),
       "Maximum number of iterations")(
           "stopPDGap,j", po::value<float>()->default_value(0),
-          "use PDGap as stopping criterion");
+          "use PDGap as stopping criterion")(
+      "diagPrecond", po::value<bool>()->default_value(false),
+      "use diagonally preconditioned primal-dual step sizes")(
+      "pdVariant", po::value<PDVariant>()->default_value(PD_STANDARD),
+      "primal-dual iteration variant (standard, accelerated, adaptive, "
+      "stochastic)")(
+      "pdRestart", po::value<bool>()->default_value(false),
+      "restart extrapolation and step sizes if the PD gap increases")(
+      "andersonDepth", po::value<unsigned>()->default_value(0),
+      "history depth of the Anderson acceleration (0: disabled)")(
+      "coilSubset", po::value<unsigned>()->default_value(0),
+      "coils per iteration of the stochastic variant (0: all coils)");
 
   AddCoilConstrConfigurationParameters();
+  AddCoilCompressionConfigurationParameters();
+  AddInitConfigurationParameters();
+  AddMultiresConfigurationParameters();
+  AddSubspaceConfigurationParameters();
   AddTVConfigurationParameters();
   AddTVtempConfigurationParameters();
   AddTGV2ConfigurationParameters();
   AddTGV2_3DConfigurationParameters();
   AddICTVConfigurationParameters(); 
   AddICTGV2ConfigurationParameters();
+  conf.add(solver);
   AddGPUNUFFTConfigurationParameters();
   AddAdaptLambdaConfigurationParameters();
 
@@ -165,18 +258,66 @@ void OptionsParser::AddCoilConstrConfigurationParameters()
       "coil.uSigmaTauRatio", po::value<RType>(&coilParams.uSigmaTauRatio))(
       "coil.uAlpha0", po::value<RType>(&coilParams.uAlpha0))(
       "coil.uAlpha1", po::value<RType>(&coilParams.uAlpha1))(
+      "coil.uWarmNrIt",
+      po::value<unsigned>(&coilParams.uWarmNrIt)->default_value(0))(
       "coil.b1Reg", po::value<RType>(&coilParams.b1Reg))(
       "coil.b1NrIt", po::value<unsigned>(&coilParams.b1NrIt))(
       "coil.b1Tau", po::value<RType>(&coilParams.b1Tau))(
       "coil.b1Sigma", po::value<RType>(&coilParams.b1Sigma))(
       "coil.b1SigmaTauRatio", po::value<RType>(&coilParams.b1SigmaTauRatio))(
+      "coil.b1BatchSize",
+      po::value<unsigned>(&coilParams.b1BatchSize)->default_value(1))(
       "coil.b1FinalReg", po::value<RType>(&coilParams.b1FinalReg))(
-      "coil.b1FinalNrIt", po::value<unsigned>(&coilParams.b1FinalNrIt));
+      "coil.b1FinalNrIt", po::value<unsigned>(&coilParams.b1FinalNrIt))(
+      "coil.lowResFactor",
+      po::value<unsigned>(&coilParams.lowResFactor)->default_value(1))(
+      "coil.pcgSolver",
+      po::value<bool>(&coilParams.pcgSolver)->default_value(false))(
+      "coil.pcgTolerance",
+      po::value<RType>(&coilParams.pcgTolerance)->default_value(1E-5));
+}
+
+void OptionsParser::AddCoilCompressionConfigurationParameters()
+{
+  conf.add_options()(
+      "compression.virtualCoils",
+      po::value<unsigned>(&compressionParams.virtualCoils)->default_value(0))(
+      "compression.energyThreshold",
+      po::value<RType>(&compressionParams.energyThreshold)
+          ->default_value(1.0))(
+      "compression.geometric",
+      po::value<bool>(&compressionParams.geometric)->default_value(false));
+}
+
+void OptionsParser::AddInitConfigurationParameters()
+{
+  conf.add_options()(
+      "init.method",
+      po::value<InitMethod>(&initParams.method)->default_value(INIT_U0))(
+      "init.window", po::value<unsigned>(&initParams.window)->default_value(3))(
+      "init.cgIt", po::value<unsigned>(&initParams.cgIt)->default_value(5))(
+      "init.cgTolerance",
+      po::value<RType>(&initParams.cgTolerance)->default_value(1E-3));
+}
+
+void OptionsParser::AddMultiresConfigurationParameters()
+{
+  conf.add_options()(
+      "multires.levels",
+      po::value<unsigned>(&multiresParams.levels)->default_value(1))(
+      "multires.maxIt",
+      po::value<unsigned>(&multiresParams.maxIt)->default_value(100));
+}
+
+void OptionsParser::AddSubspaceConfigurationParameters()
+{
+  conf.add_options()("subspace.rank",
+                     po::value<unsigned>(&subspaceRank)->default_value(0));
 }
 
 void OptionsParser::AddTVConfigurationParameters()
 {
-  conf.add_options()("tv.dx", po::value<RType>(&tvParams.dx))(
+  solver.add_options()("tv.dx", po::value<RType>(&tvParams.dx))(
       "tv.dy", po::value<RType>(&tvParams.dy))(
       "tv.dt", po::value<RType>(&tvParams.dt))(
       "tv.sigma", po::value<RType>(&tvParams.sigma))(
@@ -188,7 +329,7 @@ void OptionsParser::AddTVConfigurationParameters()
 
 void OptionsParser::AddTVtempConfigurationParameters()
 {
-  conf.add_options()("tvtemp.dt", po::value<RType>(&tvtempParams.dt))(
+  solver.add_options()("tvtemp.dt", po::value<RType>(&tvtempParams.dt))(
       "tvtemp.sigma", po::value<RType>(&tvtempParams.sigma))(
       "tvtemp.tau", po::value<RType>(&tvtempParams.tau))(
       "tvtemp.sigmaTauRatio", po::value<RType>(&tvtempParams.sigmaTauRatio))(
@@ -197,7 +338,7 @@ void OptionsParser::AddTVtempConfigurationParameters()
 
 void OptionsParser::AddTGV2ConfigurationParameters()
 {
-  conf.add_options()("tgv2.dx", po::value<RType>(&tgv2Params.dx))(
+  solver.add_options()("tgv2.dx", po::value<RType>(&tgv2Params.dx))(
       "tgv2.dy", po::value<RType>(&tgv2Params.dy))(
       "tgv2.dt", po::value<RType>(&tgv2Params.dt))(
       "tgv2.sigma", po::value<RType>(&tgv2Params.sigma))(
@@ -211,7 +352,7 @@ void OptionsParser::AddTGV2ConfigurationParameters()
 
 void OptionsParser::AddTGV2_3DConfigurationParameters()
 {
-  conf.add_options()("tgv2_3D.dx", po::value<RType>(&tgv2_3DParams.dx))(
+  solver.add_options()("tgv2_3D.dx", po::value<RType>(&tgv2_3DParams.dx))(
       "tgv2_3D.dy", po::value<RType>(&tgv2_3DParams.dy))(
       "tgv2_3D.dz", po::value<RType>(&tgv2_3DParams.dz))(
       "tgv2_3D.sigma", po::value<RType>(&tgv2_3DParams.sigma))(
@@ -224,7 +365,7 @@ void OptionsParser::AddTGV2_3DConfigurationParameters()
 
 void OptionsParser::AddICTVConfigurationParameters()
 {
-  conf.add_options()("ictv.dx", po::value<RType>(&ictvParams.dx))(
+  solver.add_options()("ictv.dx", po::value<RType>(&ictvParams.dx))(
       "ictv.dy", po::value<RType>(&ictvParams.dy))(
       "ictv.dt", po::value<RType>(&ictvParams.dt))(
       "ictv.sigma", po::value<RType>(&ictvParams.sigma))(
@@ -243,7 +384,7 @@ void OptionsParser::AddICTVConfigurationParameters()
 }
 void OptionsParser::AddICTGV2ConfigurationParameters()
 {
-  conf.add_options()("ictgv2.dx", po::value<RType>(&ictgv2Params.dx))(
+  solver.add_options()("ictgv2.dx", po::value<RType>(&ictgv2Params.dx))(
       "ictgv2.dy", po::value<RType>(&ictgv2Params.dy))(
       "ictgv2.dt", po::value<RType>(&ictgv2Params.dt))(
       "ictgv2.sigma", po::value<RType>(&ictgv2Params.sigma))(
@@ -301,6 +442,53 @@ void OptionsParser::SetStopPDGap(float stopPDGap)
   ictgv2Params.stopPDGap = stopPDGap;
 }
 
+void OptionsParser::SetDiagonalPreconditioning(bool diagonalPreconditioning)
+{
+  tvParams.diagonalPreconditioning = diagonalPreconditioning;
+  tvtempParams.diagonalPreconditioning = diagonalPreconditioning;
+  tgv2Params.diagonalPreconditioning = diagonalPreconditioning;
+  tgv2_3DParams.diagonalPreconditioning = diagonalPreconditioning;
+  ictvParams.diagonalPreconditioning = diagonalPreconditioning;
+  ictgv2Params.diagonalPreconditioning = diagonalPreconditioning;
+}
+
+void OptionsParser::SetPDVariant(PDVariant variant, bool restart)
+{
+  tvParams.variant = variant;
+  tvtempParams.variant = variant;
+  tgv2Params.variant = variant;
+  tgv2_3DParams.variant = variant;
+  ictvParams.variant = variant;
+  ictgv2Params.variant = variant;
+
+  tvParams.restart = restart;
+  tvtempParams.restart = restart;
+  tgv2Params.restart = restart;
+  tgv2_3DParams.restart = restart;
+  ictvParams.restart = restart;
+  ictgv2Params.restart = restart;
+}
+
+void OptionsParser::SetAndersonDepth(unsigned andersonDepth)
+{
+  tvParams.andersonDepth = andersonDepth;
+  tvtempParams.andersonDepth = andersonDepth;
+  tgv2Params.andersonDepth = andersonDepth;
+  tgv2_3DParams.andersonDepth = andersonDepth;
+  ictvParams.andersonDepth = andersonDepth;
+  ictgv2Params.andersonDepth = andersonDepth;
+}
+
+void OptionsParser::SetCoilSubsetSize(unsigned coilSubsetSize)
+{
+  tvParams.coilSubsetSize = coilSubsetSize;
+  tvtempParams.coilSubsetSize = coilSubsetSize;
+  tgv2Params.coilSubsetSize = coilSubsetSize;
+  tgv2_3DParams.coilSubsetSize = coilSubsetSize;
+  ictvParams.coilSubsetSize = coilSubsetSize;
+  ictgv2Params.coilSubsetSize = coilSubsetSize;
+}
+
 void OptionsParser::SetAdaptLambdaParams()
 {
   tvParams.adaptLambdaParams = adaptLambdaParams;
@@ -362,7 +550,147 @@ bool OptionsParser::ParseOptions(int argc, char *argv[])
   method = vm["method"].as<Method>();
   SetMaxIt(vm["maxIt"].as<int>());
   SetStopPDGap(vm["stopPDGap"].as<float>());
+  SetDiagonalPreconditioning(vm["diagPrecond"].as<bool>());
+  SetPDVariant(vm["pdVariant"].as<PDVariant>(), vm["pdRestart"].as<bool>());
+  SetAndersonDepth(vm["andersonDepth"].as<unsigned>());
+  SetCoilSubsetSize(vm["coilSubset"].as<unsigned>());
+  SaveSolverParameters();
+
+  // the coefficient images have no temporal regularization, the
+  // preconditioned steps require the temporal blocks
+  if (subspaceRank > 0 && vm["diagPrecond"].as<bool>())
+  {
+    std::cerr << "OptionsParser: diagPrecond is not supported in subspace "
+                 "reconstructions." << std::endl;
+    return false;
+  }
+
+  if (!sweepFilename.empty())
+  {
+    // every set starts from scratch (or the previous result) with the
+    // swept lambda
+    std::string conflict;
+    if (!resumeFilename.empty())
+      conflict = "resume";
+    else if (!warmStartFilename.empty())
+      conflict = "warmStart";
+    else if (!checkpointFilename.empty())
+      conflict = "checkpoint";
+    else if (adaptLambdaParams.adaptLambda)
+      conflict = "adaptlambda";
+    if (!conflict.empty())
+    {
+      std::cerr << "OptionsParser: " << conflict
+                << " is not supported in sweep mode." << std::endl;
+      return false;
+    }
+    if (!ReadParameterSweep())
+      return false;
+
+    // invalid entries are rejected before any data is loaded
+    for (unsigned cnt = 0; cnt < parameterSets.size(); cnt++)
+      ApplyParameterSet(cnt);
+    RestoreSolverParameters();
+  }
+
+  return true;
+}
 
+bool OptionsParser::ReadParameterSweep()
+{
+  std::ifstream ifs(sweepFilename.c_str());
+  if (!ifs)
+  {
+    std::cerr << "OptionsParser: sweep file " << sweepFilename
+              << " not found." << std::endl;
+    return false;
+  }
+
+  parameterSets.clear();
+  std::string line;
+  while (std::getline(ifs, line))
+  {
+    line = line.substr(0, line.find('#'));
+    boost::trim(line);
+    if (line.empty())
+      continue;
+
+    std::vector<std::string> entries;
+    boost::split(entries, line, boost::is_any_of(" \t"),
+                 boost::token_compress_on);
+
+    // first entry varies slowest, i.e. the sets follow the line order
+    std::vector<std::string> sets(1);
+    for (unsigned cnt = 0; cnt < entries.size(); cnt++)
+    {
+      std::size_t pos = entries[cnt].find('=');
+      if (pos == std::string::npos || pos == 0 ||
+          pos + 1 == entries[cnt].size())
+      {
+        std::cerr << "OptionsParser: invalid sweep entry " << entries[cnt]
+                  << std::endl;
+        return false;
+      }
+      std::string key = entries[cnt].substr(0, pos);
+      std::string valueList = entries[cnt].substr(pos + 1);
+      std::vector<std::string> values;
+      boost::split(values, valueList, boost::is_any_of(","));
+
+      std::vector<std::string> expanded;
+      for (unsigned set = 0; set < sets.size(); set++)
+        for (unsigned value = 0; value < values.size(); value++)
+          expanded.push_back(sets[set] + (sets[set].empty() ? "" : " ") +
+                             key + "=" + values[value]);
+      sets.swap(expanded);
+    }
+    parameterSets.insert(parameterSets.end(), sets.begin(), sets.end());
+  }
 
+  if (parameterSets.empty())
+  {
+    std::cerr << "OptionsParser: sweep file " << sweepFilename
+              << " contains no parameter set." << std::endl;
+    return false;
+  }
+  std::cout << "Parameter sweep: " << parameterSets.size() << " sets"
+            << std::endl;
   return true;
 }
+
+void OptionsParser::ApplyParameterSet(unsigned index)
+{
+  if (index >= parameterSets.size())
+    throw std::invalid_argument("OptionsParser: invalid parameter set index");
+
+  RestoreSolverParameters();
+
+  std::string entries = parameterSets[index];
+  boost::replace_all(entries, " ", "\n");
+  std::istringstream iss(entries);
+
+  // solver options have no default values, i.e. only the entries of the
+  // set are assigned
+  po::variables_map vm;
+  po::store(po::parse_config_file(iss, solver), vm);
+  po::notify(vm);
+}
+
+void OptionsParser::SaveSolverParameters()
+{
+  tvParamsBase = tvParams;
+  tvtempParamsBase = tvtempParams;
+  tgv2ParamsBase = tgv2Params;
+  tgv2_3DParamsBase = tgv2_3DParams;
+  ictvParamsBase = ictvParams;
+  ictgv2ParamsBase = ictgv2Params;
+}
+
+void OptionsParser::RestoreSolverParameters()
+{
+  tvParams = tvParamsBase;
+  tvtempParams = tvtempParamsBase;
+  tgv2Params = tgv2ParamsBase;
+  tgv2_3DParams = tgv2_3DParamsBase;
+  ictvParams = ictvParamsBase;
+  ictgv2Params = ictgv2ParamsBase;
+}
@@ -1,17 +1,29 @@
 #include "../include/pd_recon.h"
 #include "../include/cartesian_operator.h"
 #include "../include/cartesian_operator3d.h"
+#include "../include/gpu_vector_view.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 
 PDRecon::PDRecon(unsigned width, unsigned height, unsigned depth, unsigned coils,
                  unsigned frames, BaseOperator *mrOp)
   : width(width), height(height), depth(depth), coils(coils), frames(frames), mrOp(mrOp),
-    debug(false), debugstep(1)
+    debug(false), debugstep(1), temporalRegularization(true), iterations(0),
+    variantActive(false), primalTheta(1.0), dualTheta(1.0), stepScale(1.0),
+    adaptiveAlpha(0.5), lastPDGap(0), anderson(NULL), andersonPaused(false),
+    andersonSteps(0), andersonGap(0), andersonSigma(0), andersonTau(0), dataDual(NULL),
+    coilSampling(false), samplingProbability(1.0), randomState(1),
+    zImageValid(false), checkpoint(NULL), checkpointInterval(0),
+    warmStart(false)
 {
 }
 
 PDRecon::~PDRecon()
 {
+  delete anderson;
+  delete checkpoint;
 }
 
 void PDRecon::Log(const char *format, ...)
@@ -36,6 +48,34 @@ void PDRecon::SetDebug(bool debug, int debugstep)
   this->debugstep = debugstep;
 }
 
+void PDRecon::SetTemporalRegularization(bool temporalRegularization)
+{
+  this->temporalRegularization = temporalRegularization;
+}
+
+unsigned PDRecon::GetIterations() const
+{
+  return iterations;
+}
+
+unsigned PDRecon::GetAndersonSteps() const
+{
+  return andersonSteps;
+}
+
+void PDRecon::SetCheckpoint(const std::string &filename, unsigned interval)
+{
+  delete checkpoint;
+  checkpoint = filename.empty() ? NULL : new SolverCheckpoint(filename);
+  checkpointInterval = interval;
+}
+
+void PDRecon::SetResume(const std::string &filename, bool warmStart)
+{
+  resumeFilename = filename;
+  this->warmStart = warmStart;
+}
+
 void PDRecon::AdaptStepSize(RType nKx, RType nx)
 {
   RType tmp = nx / nKx;
@@ -71,6 +111,20 @@ void PDRecon::TestAdjointness(CVector &b1)
 void PDRecon::ComputeTimeSpaceWeights(RType timeSpaceWeight, RType &ds, RType &dt)
 {
 
+  if (!temporalRegularization)
+  {
+    // the diagonal steps of the vanishing temporal blocks are undefined
+    if (GetParams().diagonalPreconditioning)
+      throw std::invalid_argument(
+          "PDRecon: diagonal preconditioning requires temporal "
+          "regularization");
+
+    // temporal differences are scaled by 1 / dt = 0
+    ds = 1.0;
+    dt = std::numeric_limits<RType>::infinity();
+    return;
+  }
+
   std::cout << "timeSpaceWeight : " << timeSpaceWeight << std::endl;
   RType timeSpaceRatio = 1.0 / timeSpaceWeight;
 
@@ -100,3 +154,674 @@ void PDRecon::IterativeReconstruction(CVector &data_gpu, CVector &x,
                                       CVector &b1_gpu)
 {
 }
+
+RType PDRecon::InitDiagonalDataSteps(CVector &b1, unsigned dataSize,
+                                     RType regularizerSum, CVector &tau)
+{
+  unsigned imageSize = tau.size();
+  unsigned pixels = b1.size() / coils;
+
+  // s_j = sum_c |b1_c|^2
+  std::vector<CType> b1Host;
+  b1.copyToHost(b1Host);
+  std::vector<RType> coilSum(pixels, 0);
+  for (unsigned coil = 0; coil < coils; coil++)
+    for (unsigned cnt = 0; cnt < pixels; cnt++)
+      coilSum[cnt] += std::norm(b1Host[coil * pixels + cnt]);
+
+  std::vector<CType> tauHost(imageSize), invSqrtHost(imageSize),
+      startHost(imageSize);
+  for (unsigned cnt = 0; cnt < imageSize; cnt++)
+  {
+    RType s = coilSum[cnt % pixels];
+    tauHost[cnt] = (RType)1.0 / (regularizerSum + s);
+    invSqrtHost[cnt] = s > 0 ? (RType)1.0 / std::sqrt(s) : (RType)0.0;
+    startHost[cnt] = (RType)1.0 + (RType)0.5 * std::sin((RType)cnt);
+  }
+  tau.assignFromHost(tauHost.begin(), tauHost.end());
+
+  // power iteration on S^-1/2 K^H K S^-1/2
+  CVector invSqrt(imageSize), v(imageSize), u(imageSize), k(dataSize);
+  invSqrt.assignFromHost(invSqrtHost.begin(), invSqrtHost.end());
+  v.assignFromHost(startHost.begin(), startHost.end());
+  agile::scale((RType)1.0 / agile::norm2(v), v, v);
+
+  RType L = 0;
+  for (unsigned it = 0; it < 15; it++)
+  {
+    agile::multiplyElementwise(invSqrt, v, u);
+    mrOp->BackwardOperation(u, k, b1);
+    mrOp->ForwardOperation(k, u, b1);
+    agile::multiplyElementwise(invSqrt, u, u);
+
+    L = std::real(agile::getScalarProduct(v, u));
+    RType nu = agile::norm2(u);
+    if (nu <= 0)
+      break;
+    agile::scale((RType)1.0 / nu, u, v);
+  }
+
+  // power iteration underestimates L
+  L *= 1.05;
+  RType sigma = L > 0 ? (RType)1.0 / L : (RType)1.0;
+  Log("Diagonal preconditioning: data operator norm estimate %.4e, "
+      "dual step %.4e\n", L, sigma);
+  return sigma;
+}
+
+void PDRecon::SymmetricGradientSums(RType dx, RType dy, RType dz,
+                                    std::vector<RType> &rowSums,
+                                    std::vector<RType> &columnSums)
+{
+  RType h[3] = { dx, dy, dz };
+  // order of the off-diagonal components (xy, xz, yz)
+  unsigned first[3] = { 0, 0, 1 };
+  unsigned second[3] = { 1, 2, 2 };
+  RType weight = std::sqrt((RType)2.0);
+
+  rowSums.assign(6, 0);
+  columnSums.assign(3, 0);
+  for (unsigned d = 0; d < 3; d++)
+  {
+    rowSums[d] = 2.0 / h[d];
+    columnSums[d] = 2.0 / h[d];
+  }
+
+  // each off-diagonal component is the mean of two backward differences
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    unsigned d = first[cnt];
+    unsigned e = second[cnt];
+    rowSums[cnt + 3] = weight * (1.0 / h[d] + 1.0 / h[e]);
+    columnSums[d] += weight / h[e];
+    columnSums[e] += weight / h[d];
+  }
+}
+
+void PDRecon::ScaleSteps(RType factor)
+{
+  PDParams &params = GetParams();
+  params.sigma *= factor;
+  params.tau /= factor;
+  stepScale *= factor;
+}
+
+void PDRecon::InitSteps(CVector &b1, unsigned dataSize)
+{
+}
+
+void PDRecon::ClearState()
+{
+  primalState.clear();
+  extState.clear();
+  dualState.clear();
+  dualOld.clear();
+  dataDual = NULL;
+  historyState.clear();
+}
+
+void PDRecon::AddPrimalState(CVector &x, CVector &ext)
+{
+  primalState.push_back(&x);
+  extState.push_back(&ext);
+}
+
+void PDRecon::AddDualState(CVector &y)
+{
+  dualState.push_back(&y);
+}
+
+void PDRecon::AddDataDualState(CVector &z)
+{
+  AddDualState(z);
+  dataDual = &z;
+}
+
+void PDRecon::AddHistoryState(std::vector<CType> &history)
+{
+  historyState.push_back(&history);
+}
+
+void PDRecon::InitVariant()
+{
+  PDParams &params = GetParams();
+
+  variantActive = false;
+  primalTheta = 1.0;
+  dualTheta = 1.0;
+  stepScale = 1.0;
+  adaptiveAlpha = 0.5;
+  lastPDGap = 0;
+
+  InitAnderson();
+
+  coilSampling = false;
+  zImageValid = false;
+  if (params.variant == PD_STOCHASTIC)
+  {
+    if (dataDual != NULL && params.coilSubsetSize > 0 &&
+        params.coilSubsetSize < coils && mrOp->SupportsCoilSubsets())
+    {
+      coilSampling = true;
+      samplingProbability = (RType)params.coilSubsetSize / coils;
+      randomState = 1;
+      coilOrder.clear();
+      for (unsigned coil = 0; coil < coils; coil++)
+        coilOrder.push_back(coil);
+      zOld = CVector(dataDual->size());
+      Log("Stochastic iteration with %d of %d coils per iteration\n",
+          params.coilSubsetSize, coils);
+    }
+    else
+      Log("Coil subsets not available, using all coils\n");
+  }
+
+  dualOld.clear();
+  if (params.variant == PD_STANDARD ||
+      (params.variant == PD_STOCHASTIC && !coilSampling))
+    return;
+
+  unsigned maxSize = 0;
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+  {
+    // the data dual of the stochastic variant is handled coil-wise
+    unsigned size = dualState[cnt]->size();
+    if (coilSampling && dualState[cnt] == dataDual)
+      size = 0;
+    dualOld.push_back(CVector(size));
+    maxSize = std::max(maxSize, size);
+  }
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+    maxSize = std::max(maxSize, (unsigned)primalState[cnt]->size());
+  if (params.variant == PD_ADAPTIVE)
+    stateDiff = CVector(maxSize);
+}
+
+void PDRecon::BeginIteration(unsigned loopCnt)
+{
+  PDParams &params = GetParams();
+  variantActive = params.variant != PD_STANDARD &&
+                  (params.variant != PD_STOCHASTIC || coilSampling) &&
+                  loopCnt >= 10;
+  primalTheta = (variantActive && (params.variant == PD_ACCELERATED ||
+                                   params.variant == PD_STOCHASTIC))
+                    ? 0
+                    : 1;
+  if (!variantActive)
+    return;
+
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+    if (dualOld[cnt].size() > 0)
+      agile::copy(*dualState[cnt], dualOld[cnt]);
+}
+
+void PDRecon::ExtrapolateDual(RType dataSigma)
+{
+  PDParams &params = GetParams();
+  if (!variantActive)
+    return;
+
+  if (params.variant == PD_ACCELERATED)
+  {
+    dualTheta = 1.0 / std::sqrt(1.0 + 2.0 * dataSigma / params.lambda);
+    ScaleSteps(dualTheta);
+  }
+  else if (params.variant == PD_STOCHASTIC)
+    dualTheta = 1.0;
+  else
+    return;
+
+  // y = y + theta (y - y_old)
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+  {
+    if (dualOld[cnt].size() == 0)
+      continue;
+    agile::scale((DType)(1.0 + dualTheta), *dualState[cnt], *dualState[cnt]);
+    agile::subScaledVector(*dualState[cnt], dualTheta, dualOld[cnt],
+                           *dualState[cnt]);
+  }
+}
+
+void PDRecon::RestoreDual()
+{
+  PDParams &params = GetParams();
+  if (!variantActive || (params.variant != PD_ACCELERATED &&
+                         params.variant != PD_STOCHASTIC))
+    return;
+
+  // y = (y + theta y_old) / (1 + theta)
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+  {
+    if (dualOld[cnt].size() == 0)
+      continue;
+    agile::addScaledVector(*dualState[cnt], dualTheta, dualOld[cnt],
+                           *dualState[cnt]);
+    agile::scale((DType)(1.0 / (1.0 + dualTheta)), *dualState[cnt],
+                 *dualState[cnt]);
+  }
+}
+
+void PDRecon::SelectCoilSubset()
+{
+  // partial Fisher-Yates shuffle, each coil is drawn with probability p
+  unsigned subsetSize = GetParams().coilSubsetSize;
+  for (unsigned cnt = 0; cnt < subsetSize; cnt++)
+  {
+    randomState = randomState * 1664525u + 1013904223u;
+    unsigned pick = cnt + (randomState >> 8) % (coils - cnt);
+    std::swap(coilOrder[cnt], coilOrder[pick]);
+  }
+  coilSubset.assign(coilOrder.begin(), coilOrder.begin() + subsetSize);
+  std::sort(coilSubset.begin(), coilSubset.end());
+}
+
+bool PDRecon::DualsExtrapolated()
+{
+  PDParams &params = GetParams();
+  return variantActive && (params.variant == PD_ACCELERATED ||
+                           params.variant == PD_STOCHASTIC);
+}
+
+bool PDRecon::DataDualStep(CVector &ext, CVector &z, CVector &zTemp,
+                           CVector &data, CVector &b1, RType sigma)
+{
+  PDParams &params = GetParams();
+  if (!variantActive || !coilSampling)
+  {
+    // keep the residual, it is reused for the PD gap
+    mrOp->BackwardOperation(ext, zTemp, b1);
+    agile::subVector(zTemp, data, zTemp);
+    agile::addScaledVector(z, sigma, zTemp, z);
+    agile::scale((DType)(1.0 / (1.0 + sigma / params.lambda)), z, z);
+    return true;
+  }
+
+  if (!zImageValid)
+  {
+    zImage = mrOp->ForwardOperation(z, b1);
+    zImageValid = true;
+  }
+
+  SelectCoilSubset();
+  mrOp->SetCoilSubset(coilSubset);
+  mrOp->BackwardOperation(ext, zTemp, b1);
+
+  // k-space data is stored frame by frame, coil by coil
+  RType sigmaP = sigma * samplingProbability;
+  unsigned zFrames = std::max(frames, 1u);
+  unsigned sliceSize = z.size() / (coils * zFrames);
+  for (unsigned frame = 0; frame < zFrames; frame++)
+  {
+    for (unsigned cnt = 0; cnt < coilSubset.size(); cnt++)
+    {
+      unsigned offset = (frame * coils + coilSubset[cnt]) * sliceSize;
+      GPUVectorView<CType>(z, offset, sliceSize)
+          .CopyTo(GPUVectorView<CType>(zOld, offset, sliceSize));
+
+      CType *zSlice = z.data() + offset;
+      agile::lowlevel::addScaledVector(zSlice, sigmaP, zTemp.data() + offset,
+                                       zSlice, sliceSize);
+      agile::lowlevel::subScaledVector(zSlice, sigmaP, data.data() + offset,
+                                       zSlice, sliceSize);
+      agile::lowlevel::scale((DType)(1.0 / (1.0 + sigmaP / params.lambda)),
+                             zSlice, zSlice, sliceSize);
+    }
+  }
+  return false;
+}
+
+void PDRecon::DataAdjoint(CVector &z, CVector &image, CVector &b1)
+{
+  if (!variantActive || !coilSampling)
+  {
+    mrOp->ForwardOperation(z, image, b1);
+    return;
+  }
+
+  // zOld = z - z_old on the coil subset
+  unsigned zFrames = std::max(frames, 1u);
+  unsigned sliceSize = z.size() / (coils * zFrames);
+  for (unsigned frame = 0; frame < zFrames; frame++)
+  {
+    for (unsigned cnt = 0; cnt < coilSubset.size(); cnt++)
+    {
+      unsigned offset = (frame * coils + coilSubset[cnt]) * sliceSize;
+      agile::lowlevel::subVector(z.data() + offset, zOld.data() + offset,
+                                 zOld.data() + offset, sliceSize);
+    }
+  }
+  mrOp->ForwardOperation(zOld, image, b1);
+  mrOp->SetCoilSubset(std::vector<unsigned>());
+
+  // K^H z_n+1 = K^H z_n + K_S^H dz, extrapolated by dz / p
+  agile::addVector(zImage, image, zImage);
+  agile::addScaledVector(zImage, (DType)(1.0 / samplingProbability), image,
+                         image);
+}
+
+void PDRecon::Extrapolate(CVector &ext, CVector &x)
+{
+  if (primalTheta == 0)
+    return;
+
+  agile::scale((DType)(1.0 + primalTheta), ext, ext);
+  if (primalTheta == 1)
+    agile::subVector(ext, x, ext);
+  else
+    agile::subScaledVector(ext, primalTheta, x, ext);
+}
+
+RType PDRecon::DifferenceNormSquared(CVector &a, CVector &b)
+{
+  agile::lowlevel::subVector(a.data(), b.data(), stateDiff.data(), a.size());
+  RType norm = agile::lowlevel::norm2(stateDiff.data(), a.size());
+  return norm * norm;
+}
+
+void PDRecon::UpdateSteps()
+{
+  PDParams &params = GetParams();
+  if (!variantActive || params.variant != PD_ADAPTIVE)
+    return;
+
+  RType primalResidual = 0;
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+    primalResidual += DifferenceNormSquared(*extState[cnt], *primalState[cnt]);
+  primalResidual = std::sqrt(primalResidual) / params.tau;
+
+  RType dualResidual = 0;
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+    dualResidual += DifferenceNormSquared(*dualState[cnt], dualOld[cnt]);
+  dualResidual = std::sqrt(dualResidual) / params.sigma;
+
+  const RType delta = 1.5;
+  const RType eta = 0.95;
+  if (primalResidual > delta * dualResidual)
+  {
+    // larger primal steps
+    ScaleSteps(1.0 - adaptiveAlpha);
+    adaptiveAlpha *= eta;
+  }
+  else if (delta * primalResidual < dualResidual)
+  {
+    // larger dual steps
+    ScaleSteps(1.0 / (1.0 - adaptiveAlpha));
+    adaptiveAlpha *= eta;
+  }
+}
+
+void PDRecon::CheckPDGap(RType pdGap)
+{
+  PDParams &params = GetParams();
+  if (params.restart && lastPDGap > 0 && pdGap > lastPDGap)
+  {
+    Log("PD gap increased from %.4e to %.4e, restarting\n", lastPDGap,
+        pdGap);
+    for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+      agile::copy(*primalState[cnt], *extState[cnt]);
+    ScaleSteps(1.0 / stepScale);
+    adaptiveAlpha = 0.5;
+  }
+  lastPDGap = pdGap;
+
+  if (anderson == NULL)
+    return;
+
+  if (!andersonPaused && andersonGap > 0 && pdGap > andersonGap)
+  {
+    // plain iterations from the last check
+    Log("Anderson: PD gap increased from %.4e to %.4e, reverting\n",
+        andersonGap, pdGap);
+    ScatterState(andersonSnapshot);
+    anderson->Reset();
+    andersonPaused = true;
+  }
+  else
+  {
+    GatherState(andersonSnapshot);
+    andersonGap = pdGap;
+    andersonPaused = false;
+  }
+}
+
+void PDRecon::InitAnderson()
+{
+  PDParams &params = GetParams();
+
+  delete anderson;
+  anderson = NULL;
+  andersonPaused = false;
+  andersonSteps = 0;
+  andersonGap = 0;
+
+  if (params.andersonDepth == 0)
+    return;
+  if (params.variant != PD_STANDARD)
+  {
+    Log("Anderson acceleration requires the standard variant, disabled\n");
+    return;
+  }
+
+  unsigned size = 0;
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+    size += primalState[cnt]->size() + extState[cnt]->size();
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+    size += dualState[cnt]->size();
+
+  anderson = new AndersonAcceleration(params.andersonDepth, size);
+  andersonState = CVector(size);
+  andersonSnapshot = CVector(size);
+  andersonSigma = params.sigma;
+  andersonTau = params.tau;
+  Log("Anderson acceleration with depth %d\n", params.andersonDepth);
+}
+
+void PDRecon::GatherState(CVector &state)
+{
+  unsigned offset = 0;
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+  {
+    GPUVectorView<CType>(state, offset, primalState[cnt]->size())
+        .CopyFrom(*primalState[cnt]);
+    offset += primalState[cnt]->size();
+    GPUVectorView<CType>(state, offset, extState[cnt]->size())
+        .CopyFrom(*extState[cnt]);
+    offset += extState[cnt]->size();
+  }
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+  {
+    GPUVectorView<CType>(state, offset, dualState[cnt]->size())
+        .CopyFrom(*dualState[cnt]);
+    offset += dualState[cnt]->size();
+  }
+}
+
+void PDRecon::ScatterState(CVector &state)
+{
+  unsigned offset = 0;
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+  {
+    GPUVectorView<CType>(state, offset, primalState[cnt]->size())
+        .CopyTo(*primalState[cnt]);
+    offset += primalState[cnt]->size();
+    GPUVectorView<CType>(state, offset, extState[cnt]->size())
+        .CopyTo(*extState[cnt]);
+    offset += extState[cnt]->size();
+  }
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+  {
+    GPUVectorView<CType>(state, offset, dualState[cnt]->size())
+        .CopyTo(*dualState[cnt]);
+    offset += dualState[cnt]->size();
+  }
+}
+
+void PDRecon::AndersonStep(unsigned loopCnt)
+{
+  // not during the step size adaptation of the first iterations
+  if (anderson == NULL || loopCnt < 10)
+    return;
+
+  PDParams &params = GetParams();
+  if (params.sigma != andersonSigma || params.tau != andersonTau)
+  {
+    anderson->Reset();
+    andersonSigma = params.sigma;
+    andersonTau = params.tau;
+  }
+  if (andersonPaused)
+    return;
+
+  GatherState(andersonState);
+  if (anderson->Update(andersonState))
+  {
+    ScatterState(andersonState);
+    andersonSteps++;
+  }
+}
+
+void PDRecon::GetCheckpointVectors(std::vector<CVector *> &vectors)
+{
+  vectors.clear();
+  for (unsigned cnt = 0; cnt < primalState.size(); cnt++)
+  {
+    vectors.push_back(primalState[cnt]);
+    vectors.push_back(extState[cnt]);
+  }
+  for (unsigned cnt = 0; cnt < dualState.size(); cnt++)
+    vectors.push_back(dualState[cnt]);
+  vectors.push_back(&zImage);
+  vectors.push_back(&andersonSnapshot);
+}
+
+void PDRecon::GatherCheckpoint(unsigned loopCnt, SolverCheckpointData &data)
+{
+  PDParams &params = GetParams();
+  data.iteration = loopCnt;
+
+  data.scalars.clear();
+  data.scalars.push_back(params.sigma);
+  data.scalars.push_back(params.tau);
+  data.scalars.push_back(stepScale);
+  data.scalars.push_back(adaptiveAlpha);
+  data.scalars.push_back(lastPDGap);
+  data.scalars.push_back(andersonGap);
+  data.scalars.push_back(andersonPaused);
+  data.scalars.push_back(andersonSteps);
+  data.scalars.push_back(randomState);
+  data.scalars.push_back(zImageValid);
+  for (unsigned cnt = 0; cnt < coilOrder.size(); cnt++)
+    data.scalars.push_back(coilOrder[cnt]);
+
+  std::vector<CVector *> vectors;
+  GetCheckpointVectors(vectors);
+  data.vectors.resize(vectors.size());
+  for (unsigned cnt = 0; cnt < vectors.size(); cnt++)
+    vectors[cnt]->copyToHost(data.vectors[cnt]);
+
+  data.histories.resize(historyState.size());
+  for (unsigned cnt = 0; cnt < historyState.size(); cnt++)
+    data.histories[cnt] = *historyState[cnt];
+}
+
+unsigned PDRecon::ResumeIteration(CVector &b1, unsigned dataSize)
+{
+  if (resumeFilename.empty())
+    return 0;
+
+  SolverCheckpointData data;
+  if (!SolverCheckpoint::Read(resumeFilename, data))
+    throw std::runtime_error("PDRecon: checkpoint could not be read");
+
+  std::vector<CVector *> vectors;
+  GetCheckpointVectors(vectors);
+  unsigned stateCount = vectors.size() - 2;
+  if (data.vectors.size() != vectors.size())
+    throw std::invalid_argument(
+        "PDRecon: checkpoint does not match reconstruction method");
+  for (unsigned cnt = 0; cnt < stateCount; cnt++)
+    if (data.vectors[cnt].size() != vectors[cnt]->size())
+      throw std::invalid_argument(
+          "PDRecon: checkpoint does not match data dimensions");
+
+  for (unsigned cnt = 0; cnt < stateCount; cnt++)
+    vectors[cnt]->assignFromHost(data.vectors[cnt].begin(),
+                                 data.vectors[cnt].end());
+  if (warmStart)
+  {
+    Log("Warm start from checkpoint %s\n", resumeFilename.c_str());
+    return 0;
+  }
+
+  PDParams &params = GetParams();
+  const unsigned scalarCount = 10;
+  if (data.scalars.size() != scalarCount + coilOrder.size() ||
+      data.histories.size() != historyState.size())
+    throw std::invalid_argument(
+        "PDRecon: checkpoint does not match iteration variant");
+
+  // block steps follow from sigma and tau, preconditioned steps are
+  // scaled by the variants
+  params.sigma = data.scalars[0];
+  params.tau = data.scalars[1];
+  InitSteps(b1, dataSize);
+  RType scale = data.scalars[2];
+  if (params.diagonalPreconditioning && scale != 1)
+  {
+    ScaleSteps(scale);
+    params.sigma = data.scalars[0];
+    params.tau = data.scalars[1];
+  }
+  stepScale = scale;
+
+  adaptiveAlpha = data.scalars[3];
+  lastPDGap = data.scalars[4];
+  andersonGap = data.scalars[5];
+  andersonPaused = data.scalars[6] != 0;
+  andersonSteps = data.scalars[7];
+  randomState = data.scalars[8];
+  zImageValid = data.scalars[9] != 0;
+  for (unsigned cnt = 0; cnt < coilOrder.size(); cnt++)
+    coilOrder[cnt] = data.scalars[scalarCount + cnt];
+
+  if (zImageValid)
+    zImage.assignFromHost(data.vectors[stateCount].begin(),
+                          data.vectors[stateCount].end());
+  if (anderson != NULL &&
+      data.vectors[stateCount + 1].size() == andersonSnapshot.size())
+    andersonSnapshot.assignFromHost(data.vectors[stateCount + 1].begin(),
+                                    data.vectors[stateCount + 1].end());
+
+  for (unsigned cnt = 0; cnt < historyState.size(); cnt++)
+    *historyState[cnt] = data.histories[cnt];
+
+  Log("Resuming from checkpoint %s after %d iterations\n",
+      resumeFilename.c_str(), data.iteration);
+  return data.iteration;
+}
+
+bool PDRecon::CheckpointIteration(unsigned loopCnt)
+{
+  if (checkpoint == NULL)
+    return false;
+
+  bool terminate = SolverCheckpoint::TerminationRequested();
+  if (!terminate &&
+      (checkpointInterval == 0 || loopCnt % checkpointInterval != 0))
+    return false;
+
+  SolverCheckpointData data;
+  GatherCheckpoint(loopCnt, data);
+  if (!terminate)
+  {
+    checkpoint->WriteAsync(data);
+    return false;
+  }
+
+  checkpoint->Wait();
+  if (checkpoint->Write(data))
+    std::cout << std::endl << "Termination requested, checkpoint written to "
+              << checkpoint->GetFilename() << " after " << loopCnt
+              << " iterations" << std::endl;
+  return true;
+}
@@ -7,13 +7,16 @@
 #include "../include/dicom_reader.h"
 #include "../include/ismrmrd_reader.h"
 #include "../include/siemens_vd11_reader.h"
+#include "../include/acquisition_stream.h"
+#include <cuda_runtime.h>
+#include <cufft.h>
 
 RawDataPreparation::RawDataPreparation(OptionsParser &op, bool completeData,
                                        bool removeReadOutOS, bool normalizeData,
                                        bool applyChop)
   : op(op), completeData(completeData), removeReadOutOS(removeReadOutOS),
     normalizeData(normalizeData), applyChop(applyChop), nonuniformData(false),
-    fftOp(NULL), croppedFftOp(NULL), dataReader(NULL)
+    dataReader(NULL)
 {
   com.allocateGPU();
 }
@@ -24,58 +27,121 @@ RawDataPreparation::RawDataPreparation(bool completeData, bool removeReadOutOS,
                                        bool normalizeData, bool applyChop)
   : op(zeroOptions), completeData(completeData),
     removeReadOutOS(removeReadOutOS), normalizeData(normalizeData),
-    applyChop(applyChop), nonuniformData(false), fftOp(NULL),
-    croppedFftOp(NULL), dataReader(NULL)
+    applyChop(applyChop), nonuniformData(false), dataReader(NULL)
 {
   com.allocateGPU();
 }
 
 RawDataPreparation::~RawDataPreparation()
 {
-  if (fftOp != NULL)
-    delete fftOp;
-  if (croppedFftOp != NULL)
-    delete croppedFftOp;
   if (dataReader != NULL)
     delete dataReader;
 }
 
-void RawDataPreparation::InitOSRemoval(unsigned width)
+void RawDataPreparation::RemoveOS(const std::vector<CType> &oversampledData,
+                                  std::vector<CType> &data,
+                                  const Dimension &dims)
+{
+  // All lines of one frame are processed at once:
+  // batched inverse FFT of length 2W, crop of the first and last quarter of
+  // each line and batched forward FFT of length W
+  unsigned width = dims.width;
+  unsigned fullWidth = 2 * width;
+  unsigned half = width / 2;
+  unsigned rows = dims.encodings * dims.coils;
+
+  cufftResult cres;
+  cufftHandle fullPlan, croppedPlan;
+  cres = cufftPlan1d(&fullPlan, fullWidth, CUFFT_C2C, rows);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage("Error during FFT plan"));
+  cres = cufftPlan1d(&croppedPlan, width, CUFFT_C2C, rows);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage("Error during FFT plan"));
+
+  CVector fullGPU(rows * fullWidth);
+  CVector croppedGPU(rows * width);
+  std::vector<CType> croppedHost(rows * width);
+
+  // both transforms are normalized as in agile::FFT
+  CType scale = (CType)(1.0 / std::sqrt((double)fullWidth * width));
+
+  for (unsigned frame = 0; frame < dims.frames; frame++)
+  {
+    std::vector<CType>::const_iterator frameStart =
+        oversampledData.begin() + frame * rows * fullWidth;
+    fullGPU.assignFromHost(frameStart, frameStart + rows * fullWidth);
+
+    cres = cufftExecC2C(fullPlan, (cufftComplex *)fullGPU.data(),
+                        (cufftComplex *)fullGPU.data(), CUFFT_INVERSE);
+    AGILE_ASSERT(cres == CUFFT_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during FFT procedure"));
+
+    // first and last quarter of all lines
+    croppedGPU.assign(croppedGPU.size(), 0);
+    cudaMemcpy2D(croppedGPU.data(), width * sizeof(CType), fullGPU.data(),
+                 fullWidth * sizeof(CType), half * sizeof(CType), rows,
+                 cudaMemcpyDeviceToDevice);
+    cudaMemcpy2D(croppedGPU.data() + width - half, width * sizeof(CType),
+                 fullGPU.data() + fullWidth - half, fullWidth * sizeof(CType),
+                 half * sizeof(CType), rows, cudaMemcpyDeviceToDevice);
+
+    cres = cufftExecC2C(croppedPlan, (cufftComplex *)croppedGPU.data(),
+                        (cufftComplex *)croppedGPU.data(), CUFFT_FORWARD);
+    AGILE_ASSERT(cres == CUFFT_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during FFT procedure"));
+    agile::scale(scale, croppedGPU, croppedGPU);
+
+    croppedGPU.copyToHost(croppedHost);
+    CType *frameData = &data[frame * rows * width];
+    for (unsigned row = 0; row < rows; row++)
+    {
+      unsigned coil = row / dims.encodings;
+      ScatterLine(&croppedHost[row * width], width, 0, row % dims.encodings,
+                  width, dims.encodings, applyChop,
+                  frameData + coil * width * dims.encodings);
+    }
+  }
+
+  cufftDestroy(fullPlan);
+  cufftDestroy(croppedPlan);
+}
+
+unsigned RawDataPreparation::ChopShiftIndex(unsigned col, unsigned row,
+                                            unsigned width, unsigned height)
+{
+  // position of (col, row) after ifftshift of a width x height frame
+  return (col + width - width / 2) % width +
+         ((row + height - height / 2) % height) * width;
+}
+
+void RawDataPreparation::ScatterLine(const CType *samples, unsigned count,
+                                     unsigned col, unsigned row,
+                                     unsigned width, unsigned height,
+                                     bool chop, CType *frame)
 {
-  fftOp = new agile::FFT<CType>(1, 2 * width);
-  croppedFftOp = new agile::FFT<CType>(1, width);
-  fullLine = std::vector<CType>(2 * width, 0);
-  fullLineGPU = CVector(2 * width);
-  croppedLineGPU = CVector(width);
-  croppedLineGPU.assign(width, 0);
+  if (!chop)
+  {
+    std::copy(samples, samples + count, frame + col + row * width);
+    return;
+  }
+
+  // chop sign (-1)^(x+y) alternates along the line
+  RType sign = ((col + row) % 2 == 0) ? 1.0 : -1.0;
+  for (unsigned cnt = 0; cnt < count; cnt++, sign = -sign)
+    frame[ChopShiftIndex(col + cnt, row, width, height)] = sign * samples[cnt];
 }
 
-void RawDataPreparation::RemoveOS(std::vector<CType> &oversampledLine,
-                                  std::vector<CType> &croppedLine,
-                                  unsigned width, unsigned colOffset)
+bool RawDataPreparation::SkipAcquisition(const AcquisitionHeader &line)
 {
-  // correct with asymmetric echo offset
-  std::copy(oversampledLine.begin(), oversampledLine.end(),
-            fullLine.begin() + colOffset);
-
-  fullLineGPU.assignFromHost(fullLine.begin(), fullLine.end());
-  fftOp->Inverse(fullLineGPU, fullLineGPU);
-
-  // first quater
-  agile::lowlevel::get_content(fullLineGPU.data(), 1, width / 2.0, 0, 0,
-                               croppedLineGPU.data(), 1, width / 2.0);
-  // last quater
-  agile::lowlevel::get_content(
-      fullLineGPU.data(), 1, width / 2.0, 0, (3.0 * 2.0 * width) / 4.0,
-      croppedLineGPU.data() + (unsigned)(width / 2.0), 1, width / 2.0);
-
-  // cropped forward FFT
-  croppedFftOp->Forward(croppedLineGPU, croppedLineGPU);
-  croppedLineGPU.copyToHost(croppedLine);
+  return line.isNoiseMeasurement || (line.slice != op.slice) ||
+         ((line.phase + (line.line % op.tpat)) % op.tpat) != 0;
 }
 
 void RawDataPreparation::ComputePFZeroFillOffset(
-    const Acquisition &line, unsigned centerCol, unsigned centerRow,
+    const AcquisitionHeader &line, unsigned centerCol, unsigned centerRow,
     unsigned &colOffset, unsigned &rowOffset, unsigned &lineStart,
     unsigned &lineEnd)
 {
@@ -206,9 +272,10 @@ void RawDataPreparation::PrepareRawData(const std::string &rawDataPath,
 
 void RawDataPreparation::SetTrajectoryData(
     Acquisition &line, std::vector<RType> &mask, std::vector<RType> &w,
-    const Dimension &dims, unsigned maskPhaseOffset, unsigned lineOffset,
-    unsigned colOffset)
+    const Dimension &dims, unsigned nRO, unsigned maskPhaseOffset,
+    unsigned row, unsigned colOffset)
 {
+  unsigned lineOffset = row * nRO;
   if (nonuniformData)
   {
     unsigned nTraj = dims.readouts * dims.encodings;
@@ -231,58 +298,64 @@ void RawDataPreparation::SetTrajectoryData(
   }
   else
   {
+    // the mask is shifted along with the data in case of chopping
+    RType *frameMask = &mask[maskPhaseOffset];
     if (line.hasTrajectoryInformation())
     {
       // uniform case with provided trajectory data
-      // TODO loop over samples and set mask!
       for (unsigned cnt = 0; cnt < line.traj.size(); cnt++)
       {
-        mask[(unsigned)line.traj[cnt] + lineOffset + maskPhaseOffset] = 1.0;
+        unsigned col = (unsigned)line.traj[cnt];
+        if (applyChop)
+          frameMask[ChopShiftIndex(col, row, nRO, dims.encodings)] = 1.0;
+        else
+          frameMask[col + lineOffset] = 1.0;
       }
     }
     else
     {
-      std::vector<RType> ones(dims.width - (colOffset / 2.0));
-      ones.assign(ones.size(), (RType)1.0);
       // set line in mask in case of cartesian recon
-      std::copy(ones.begin(), ones.end(), mask.begin() + (colOffset / 2.0) +
-                                              lineOffset + maskPhaseOffset);
+      for (unsigned col = colOffset / 2.0; col < dims.width; col++)
+      {
+        if (applyChop)
+          frameMask[ChopShiftIndex(col, row, nRO, dims.encodings)] = 1.0;
+        else
+          frameMask[col + lineOffset] = 1.0;
+      }
     }
   }
 }
 
 void RawDataPreparation::SetData(Acquisition &line, std::vector<CType> &data,
-                                 const Dimension &dims, unsigned phaseOffset,
-                                 unsigned lineOffset, unsigned colOffset)
+                                 const Dimension &dims, unsigned nRO,
+                                 unsigned phaseOffset, unsigned row,
+                                 unsigned colOffset, bool chop)
 {
-  // init mask with corrected width
-  // but without Partial Fourier/Asymmetric Echo offset
+  // each coil line is copied straight from the contiguous acquisition buffer
+  // into its strided position in the k-space array, chop sign and
+  // ifftshift are applied on the fly if requested
   for (unsigned int coil = 0; coil < dims.coils; coil++)
   {
-    unsigned coilOffset = coil * dims.width * dims.encodings;
-    std::vector<CType> chn = line.data[coil];
+    const CType *chn = line.coilData(coil);
 
     if (!nonuniformData && line.hasTrajectoryInformation())
     {
+      CType *coilData = &data[coil * dims.width * dims.encodings + phaseOffset];
       for (unsigned cnt = 0; cnt < line.traj.size(); cnt++)
       {
-        data[(unsigned)line.traj[cnt] + lineOffset + coilOffset + phaseOffset] =
-            chn[cnt];
+        unsigned col = (unsigned)line.traj[cnt];
+        if (chop)
+          coilData[ChopShiftIndex(col, row, nRO, dims.encodings)] =
+              ((col + row) % 2 == 0) ? chn[cnt] : -chn[cnt];
+        else
+          coilData[col + row * nRO] = chn[cnt];
       }
     }
-    else if (removeReadOutOS && !nonuniformData)
-    {
-      std::vector<CType> croppedLine(dims.width);
-      this->RemoveOS(chn, croppedLine, dims.width, colOffset);
-      std::copy(croppedLine.begin(), croppedLine.end(),
-                data.begin() + phaseOffset + coilOffset + lineOffset);
-    }
     else
     {
-      coilOffset = coil * dims.readouts * dims.encodings;
-
-      std::copy(chn.begin(), chn.end(), data.begin() + colOffset + phaseOffset +
-                                            coilOffset + lineOffset);
+      CType *coilData = &data[coil * nRO * dims.encodings + phaseOffset];
+      ScatterLine(chn, line.samples, colOffset, row, nRO, dims.encodings, chop,
+                  coilData);
     }
   }
 }
@@ -459,25 +532,19 @@ void RawDataPreparation::PrepareRawData(std::vector<CType> &data,
       rawDataDims.height = std::ceil(dims.height / 2.0);
       dims.height = rawDataDims.height;
     }
-    this->InitOSRemoval(dims.width);
   }
 
   if (op.verbose)
     std::cout << "Completed data set size: (w,h) = " << dims.width << ","
               << dims.height << std::endl;
 
-  // init data arrays with correct sizes
+  // init data array sizes
   unsigned nEnc, nRO;
   if (nonuniformData)
   {
     nRO = dims.readouts;
     nEnc = dims.encodings;
     std::cout << "Nonuniform data - number of encodings: " << nEnc << std::endl;
-    // mask == trajectory, x and y values of trajectory
-    mask.resize(2 * nRO * nEnc * dims.frames);
-    w.resize(nRO * nEnc * dims.frames);
-    w.assign(w.size(), 0.0);
-    mask.assign(mask.size(), 0.0);
   }
   else
   {
@@ -487,53 +554,37 @@ void RawDataPreparation::PrepareRawData(std::vector<CType> &data,
       nRO = dims.width;
 
     nEnc = dims.encodings;
-    mask.resize(nRO * nEnc * dims.frames);
-    mask.assign(mask.size(), 0.0);
   }
-  data.resize(nRO * nEnc * dims.coils * dims.frames);
-  data.assign(data.size(), 0);
 
-  // loop over all acquired lines and segments
-  if (op.verbose)
-  {
-    std::cout << "Data element count: " << data.size() << std::endl;
-    std::cout << "Number of acquisitions:"
-              << dataReader->GetNumberOfAcquisitions() << std::endl;
-  }
+  // Pre-scan acquisition headers to determine the final data dimensions and
+  // offsets before any sample data is read. Inconsistencies are resolved
+  // here, such that the data arrays are allocated exactly once.
+  std::vector<AcquisitionHeader> headers;
+  dataReader->GetAcquisitionHeaders(headers);
 
-  for (unsigned acqCnt = 0; acqCnt < dataReader->GetNumberOfAcquisitions();
-       acqCnt++)
+  for (unsigned acqCnt = 0; acqCnt < headers.size(); acqCnt++)
   {
-    Acquisition line = dataReader->GetAcquisition(acqCnt);
+    const AcquisitionHeader &header = headers[acqCnt];
 
-    if (line.isNoiseMeasurement || (line.slice != op.slice) ||
-        ((line.phase + (line.line % op.tpat)) % op.tpat) != 0)
+    if (this->SkipAcquisition(header))
       continue;
 
     // Check consistency
     // Check acquisition data dimensions
-    if (line.readouts > dims.readouts)
+    if (header.readouts > dims.readouts)
     {
       std::cout << "Inconsistent data detected. Number of readouts != number "
                    "of samples in acquisition."
-                << " " << line.readouts << " != " << dims.readouts << std::endl;
+                << " " << header.readouts << " != " << dims.readouts
+                << std::endl;
       std::cout << "Trying to adapt raw data dimensions. " << std::endl;
-      dims.readouts = line.readouts;
-      nRO = line.readouts;
-
-      data.resize(nRO * nEnc * dims.coils * dims.frames);
-      // TODO differ between cart and non-cart
-      mask.resize(2 * nRO * nEnc * dims.frames);
-      w.resize(nRO * nEnc * dims.frames);
-
-      data.assign(data.size(), 0.0);
-      w.assign(w.size(), 0.0);
-      mask.assign(mask.size(), 0.0);
+      dims.readouts = header.readouts;
+      nRO = header.readouts;
     }
 
     // Compute possible partial fourier/ asymmetric echo offset
-    if (!line.hasTrajectoryInformation())
-      this->ComputePFZeroFillOffset(line, centerCol, centerRow, colOffset,
+    if (!header.hasTrajectory)
+      this->ComputePFZeroFillOffset(header, centerCol, centerRow, colOffset,
                                     rowOffset, lineStart, lineEnd);
 
     if (rowOffset > 0 && dims.encodings != dims.height)
@@ -550,17 +601,6 @@ void RawDataPreparation::PrepareRawData(std::vector<CType> &data,
 
       std::cout << "Final number of encodings: " << nEnc << std::endl;
       std::cout << "Height: " << dims.height << std::endl;
-
-      data.resize(nRO * nEnc * dims.coils * dims.frames);
-      if (nonuniformData || line.hasTrajectoryInformation())
-        mask.resize(2 * nRO * nEnc * dims.frames);
-      else
-        mask.resize(nRO * nEnc * dims.frames);
-      w.resize(nRO * nEnc * dims.frames);
-
-      data.assign(data.size(), 0.0);
-      w.assign(w.size(), 0.0);
-      mask.assign(mask.size(), 0.0);
     }
 
     if (lineStart > 0 && dims.encodings != dims.height)
@@ -570,35 +610,87 @@ void RawDataPreparation::PrepareRawData(std::vector<CType> &data,
                 << std::endl;
       nEnc = dims.height;
       dims.encodings = dims.height;
+    }
+  }
 
-      data.resize(nRO * nEnc * dims.coils * dims.frames);
-      if (nonuniformData || line.hasTrajectoryInformation())
-        mask.resize(2 * nRO * nEnc * dims.frames);
-      else
-        mask.resize(nRO * nEnc * dims.frames);
-      w.resize(nRO * nEnc * dims.frames);
+  // allocate data arrays with their final sizes
+  if (nonuniformData)
+  {
+    // mask == trajectory, x and y values of trajectory
+    mask.assign(2 * nRO * nEnc * dims.frames, 0.0);
+    w.assign(nRO * nEnc * dims.frames, 0.0);
+  }
+  else
+  {
+    mask.assign(nRO * nEnc * dims.frames, 0.0);
+  }
+  data.assign(nRO * nEnc * dims.coils * dims.frames, 0);
+
+  // oversampled lines are staged with twice the reconstruction width and
+  // cropped in one batched pass after all acquisitions have been read
+  std::vector<CType> oversampledData;
+  unsigned nROFull = 2 * dims.width;
+  if (removeReadOutOS && !nonuniformData)
+    oversampledData.assign(nROFull * nEnc * dims.coils * dims.frames, 0);
+  bool stagedLines = false;
 
-      data.assign(data.size(), 0.0);
-      w.assign(w.size(), 0.0);
-      mask.assign(mask.size(), 0.0);
+  // loop over all acquired lines and segments
+  if (op.verbose)
+  {
+    std::cout << "Data element count: " << data.size() << std::endl;
+    std::cout << "Number of acquisitions:"
+              << dataReader->GetNumberOfAcquisitions() << std::endl;
+  }
+
+  // acquisitions are read and decoded block-wise on a separate thread while
+  // the decoded lines are scattered into data/mask/w here
+  AcquisitionStream stream(dataReader);
+  stream.Start();
+
+  std::vector<Acquisition> block;
+  unsigned blockCnt = 0;
+  for (unsigned acqCnt = 0; acqCnt < stream.GetNumberOfAcquisitions();
+       acqCnt++, blockCnt++)
+  {
+    if (blockCnt == block.size())
+    {
+      if (!stream.NextBlock(block))
+        throw std::runtime_error(
+            "PrepareRawData: raw data stream ended unexpectedly.");
+      blockCnt = 0;
     }
+    Acquisition &line = block[blockCnt];
+
+    if (this->SkipAcquisition(line))
+      continue;
 
-    unsigned maskPhaseOffset, lineOffset, phaseOffset;
     if (line.line >= lineStart && line.line < lineEnd)
     {
-      maskPhaseOffset = line.phase * nRO * nEnc;
+      unsigned row;
       if (lineStart > 0)
-        lineOffset = (line.line - lineStart) * nRO;
+        row = line.line - lineStart;
       else
-        lineOffset = (rowOffset + line.line - lineStart) * nRO;
+        row = rowOffset + line.line - lineStart;
 
-      phaseOffset = line.phase * nRO * nEnc * dims.coils;
+      unsigned maskPhaseOffset = line.phase * nRO * nEnc;
+      unsigned phaseOffset = line.phase * nRO * nEnc * dims.coils;
 
       // do not pass colOffset as last parameter since in case of OS removal
       // no padding is performed
-      SetTrajectoryData(line, mask, w, dims, maskPhaseOffset, lineOffset,
+      SetTrajectoryData(line, mask, w, dims, nRO, maskPhaseOffset, row,
                         removeReadOutOS ? 0 : colOffset);
-      SetData(line, data, dims, phaseOffset, lineOffset, colOffset);
+
+      // staged lines are chopped after the oversampling removal
+      if (!oversampledData.empty() && !line.hasTrajectoryInformation())
+      {
+        SetData(line, oversampledData, dims, nROFull,
+                line.phase * nROFull * nEnc * dims.coils, row, colOffset,
+                false);
+        stagedLines = true;
+      }
+      else
+        SetData(line, data, dims, nRO, phaseOffset, row, colOffset,
+                applyChop);
     }
     else if (op.verbose)
       std::cout << "DEBUG: Skip line no. " << line.line << " (out of range)"
@@ -608,14 +700,17 @@ void RawDataPreparation::PrepareRawData(std::vector<CType> &data,
       std::cout << acqCnt << " acquisitions read." << std::endl;
   }  // loop over acquisitions
 
-  if (this->normalizeData)
+  if (stagedLines)
   {
-    this->NormalizeData(data, mask, w, dims, datanorm);
+    if (op.verbose)
+      std::cout << "Remove readout oversampling of all lines." << std::endl;
+    this->RemoveOS(oversampledData, data, dims);
   }
 
-  if (this->applyChop)
+  // chop and ifftshift have already been applied during the scatter above
+  if (this->normalizeData)
   {
-    this->ChopData(data, mask, dims);
+    this->NormalizeData(data, mask, w, dims, datanorm);
   }
 }
 
@@ -646,38 +741,27 @@ void RawDataPreparation::PrepareDicomData(const std::string &dicomDataPath,
   this->PrepareRawData(data, mask, w, dims, datanorm);
 }
 
-struct isLargerThan
-{
-  isLargerThan(const RType &maximum) : maximum(maximum)
-  {
-  }
-  RType maximum;
-  bool operator()(const RType &el)
-  {
-    return el >= maximum;
-  }
-};
-
 RType RawDataPreparation::FindNormalizationFactor(std::vector<RType> &data)
 {
-  std::vector<RType>::iterator maxElement;
-  maxElement = std::max_element(data.begin(), data.end());
+  if (data.empty())
+    throw std::runtime_error("FindNormalizationFactor: Input array empty!");
 
-  std::vector<RType>::iterator largest90Percent =
-      std::find_if(data.begin(), data.end(), isLargerThan(*maxElement));
+  std::vector<RType>::const_iterator maxElement =
+      std::max_element(data.begin(), data.end());
+  RType threshold = *maxElement * 0.9;
 
+  // Collect all elements larger than 90 percent of maximum in one pass,
+  // starting at the first maximum as the datanorm has always been defined
   std::vector<RType> largestElements;
-
-  // Find all elements larger than 90 percent of maximum
-  while (largest90Percent != data.end())
+  for (std::vector<RType>::const_iterator it = maxElement; it != data.end();
+       ++it)
   {
-    largestElements.push_back(*largest90Percent);
-    largest90Percent = std::find_if(++largest90Percent, data.end(),
-                                    isLargerThan(*maxElement * 0.9));
+    if (*it >= threshold)
+      largestElements.push_back(*it);
   }
 
   // Find median of resulting values
-  if (largestElements.size() > 0)
+  if (largestElements.size() > 0 && *maxElement > 0)
     return utils::Median(largestElements);
   else
     throw std::runtime_error("NormalizeNonCartData: No valid normalization "
@@ -694,6 +778,13 @@ void RawDataPreparation::NormalizeNonCartData(std::vector<CType> &data, const Di
   CVector kdata(data.size());
   kdata.assignFromHost(data.begin(), data.end());
 
+  if (op.sosNormalization)
+  {
+    this->NormalizeNonCartData(kdata, dims, coilConstruction, datanorm);
+    kdata.copyToHost(data);
+    return;
+  }
+
   CVector u(dims.width * dims.height * dims.coils);
   CVector u0(dims.width * dims.height);
   u0.assign(u0.size(), 0);
@@ -733,49 +824,20 @@ void RawDataPreparation::NormalizeNonCartData(std::vector<CType> &data, const Di
   kdata.copyToHost(data);
 }
 
-// GPU overload
 void RawDataPreparation::NormalizeNonCartData(CVector &data, const Dimension &dims,
                                               NoncartesianCoilConstruction *coilConstruction, CType &datanorm)
 {
   std::cout << "Normalize noncart data: witdh:" << dims.width
             << " height:  " << dims.height << std::endl;
 
-  CVector u(dims.width * dims.height * dims.coils);
+  // the time averaged gridding already yields the sum-of-squares image,
+  // no coil sensitivities are required to find the normalization factor
   CVector u0(dims.width * dims.height);
   u0.assign(u0.size(), 0);
 
-  CVector b1(dims.width * dims.height * dims.coils);
   CVector crec(dims.width * dims.height * dims.coils);
   crec.assign(crec.size(), 0);
-
-  //coilConstruction->PerformCoilConstruction(data, u, b1, com);
-   coilConstruction->TimeAveragedReconstruction(data, u0, crec, false);
-
-  /*  u0.assign(u0.size(), 0);
-  CVector crecTemp(dims.width * dims.height);
-  CVector b1Temp(dims.width * dims.height);
-  for (unsigned coil = 0; coil < dims.coils; coil++)
-  {
-    utils::GetSubVector(crec, crecTemp, coil, dims.width * dims.height);
-    utils::GetSubVector(b1, b1Temp, coil, dims.width * dims.height);
-    agile::multiplyConjElementwise(b1Temp, crecTemp, crecTemp);
-    agile::addVector(u0, crecTemp, u0);
-  }
-  */
-   
-  u0.assign(u0.size(), 0);
-  CVector crecTemp(dims.width * dims.height);
-  RVector crecTempAbs(dims.width * dims.height);
-
-  for (unsigned coil = 0; coil < dims.coils; coil++)
-  {
-    utils::GetSubVector(crec, crecTemp, coil, dims.width * dims.height);
-    agile::absVector(crecTemp,crecTempAbs);
-    agile::multiplyElementwise(crecTempAbs,crecTempAbs,crecTempAbs);
-   // agile::multiplyConjElementwise(crecTemp, crecTemp, crecTemp);
-    agile::addVector(u0, crecTempAbs, u0);
-  }
-  agile::sqrt(u0, u0);
+  coilConstruction->TimeAveragedReconstruction(data, u0, crec, false);
 
   RVector u0Abs(u0.size());
   agile::absVector(u0, u0Abs);
@@ -870,24 +932,22 @@ void RawDataPreparation::ChopData(std::vector<CType> &data,
   maskGPU.assignFromHost(mask.begin(), mask.end());
 
   unsigned N = dims.width * dims.height;
-  RVector frameMask(N);
-  CVector coilData(N);
 
   for (unsigned frame = 0; frame < dims.frames; frame++)
   {
     // shift mask
-    utils::GetSubVector(maskGPU, frameMask, frame, N);
+    RVectorView frameMask = RVectorView::Slice(maskGPU, frame, N);
     agile::lowlevel::ifftshift(frameMask.data(), dims.height, dims.width);
-    utils::SetSubVector(frameMask, maskGPU, frame, N);
 
     unsigned frameOffset = frame * dims.coils;
     // apply chop matrix and shift
     for (unsigned coil = 0; coil < dims.coils; coil++)
     {
-      utils::GetSubVector(dataGPU, coilData, coil + frameOffset, N);
-      agile::multiplyElementwise(coilData, chopGPU, coilData);
+      CVectorView coilData =
+          CVectorView::Slice(dataGPU, coil + frameOffset, N);
+      agile::lowlevel::multiplyElementwise(coilData.data(), chopGPU.data(),
+                                           coilData.data(), N);
       agile::lowlevel::ifftshift(coilData.data(), dims.height, dims.width);
-      utils::SetSubVector(coilData, dataGPU, coil + frameOffset, N);
     }
   }
 
@@ -8,6 +8,23 @@ RawDataReader::~RawDataReader()
 {
 }
 
+void RawDataReader::GetAcquisitions(
+    unsigned start, unsigned count,
+    std::vector<Acquisition> &acquisitions) const
+{
+  acquisitions.resize(count);
+  for (unsigned cnt = 0; cnt < count; cnt++)
+    acquisitions[cnt] = this->GetAcquisition(start + cnt);
+}
+
+void RawDataReader::GetAcquisitionHeaders(
+    std::vector<AcquisitionHeader> &headers) const
+{
+  headers.resize(this->GetNumberOfAcquisitions());
+  for (unsigned cnt = 0; cnt < headers.size(); cnt++)
+    headers[cnt] = this->GetAcquisition(cnt);
+}
+
 void RawDataReader::GenerateRadialTrajectory(unsigned lineIdx,
                                              std::vector<RType> &traj,
                                              std::vector<RType> &dens,
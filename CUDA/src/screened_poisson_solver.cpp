@@ -0,0 +1,191 @@
+#include "../include/screened_poisson_solver.h"
+#include <cmath>
+#include <vector>
+#include "agile/agile.hpp"
+
+ScreenedPoissonSolver::ScreenedPoissonSolver(unsigned width, unsigned height,
+                                             unsigned batch, bool periodic)
+  : width(width), height(height), batch(batch), periodic(periodic),
+    symbol(width * height * batch), gradientX(width * height * batch),
+    gradientY(width * height * batch), temp(width * height * batch),
+    converged(false),
+    iterations(0), relativeResidual(0)
+{
+  int n[2] = { (int)height, (int)width };
+  int N = width * height;
+  cufftResult cres = cufftPlanMany(&plan, 2, n, NULL, 1, N, NULL, 1, N,
+                                   CUFFT_C2C, batch);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage("Error during FFT plan"));
+}
+
+ScreenedPoissonSolver::~ScreenedPoissonSolver()
+{
+  cufftDestroy(plan);
+}
+
+bool ScreenedPoissonSolver::HasConverged() const
+{
+  return converged;
+}
+
+unsigned ScreenedPoissonSolver::GetIterations() const
+{
+  return iterations;
+}
+
+RType ScreenedPoissonSolver::GetRelativeResidual() const
+{
+  return relativeResidual;
+}
+
+unsigned ScreenedPoissonSolver::CoefficientOffset(CVector &coefficient,
+                                                  unsigned image)
+{
+  if (coefficient.size() == width * height * batch)
+    return image * width * height;
+  return 0;
+}
+
+void ScreenedPoissonSolver::ApplyOperator(CVector &coefficient, RType mu,
+                                          CVector &x, CVector &y)
+{
+  unsigned N = width * height;
+
+  // grad^T grad x = -div(grad x), all images in one pass
+  agile::lowlevel::diff3(1, width, height, x.data(), gradientX.data(),
+                         N * batch, periodic);
+  agile::lowlevel::diff3(2, width, height, x.data(), gradientY.data(),
+                         N * batch, periodic);
+  agile::lowlevel::diff3trans(1, width, height, gradientX.data(), temp.data(),
+                              N * batch, periodic);
+  agile::lowlevel::diff3trans(2, width, height, gradientY.data(),
+                              gradientX.data(), N * batch, periodic);
+  agile::addVector(temp, gradientX, temp);
+
+  if (coefficient.size() == N * batch)
+  {
+    agile::multiplyElementwise(coefficient, x, y);
+  }
+  else
+  {
+    for (unsigned cnt = 0; cnt < batch; cnt++)
+      agile::lowlevel::multiplyElementwise(coefficient.data(),
+                                           x.data() + cnt * N,
+                                           y.data() + cnt * N, N);
+  }
+  agile::addScaledVector(y, mu, temp, y);
+}
+
+void ScreenedPoissonSolver::InitPreconditioner(CVector &coefficient, RType mu)
+{
+  unsigned N = width * height;
+
+  // eigenvalues of the periodic negative 5-point Laplacian
+  std::vector<RType> laplacian(N);
+  for (unsigned row = 0; row < height; row++)
+  {
+    RType sy = std::sin(M_PI * row / height);
+    for (unsigned col = 0; col < width; col++)
+    {
+      RType sx = std::sin(M_PI * col / width);
+      laplacian[col + row * width] = 4.0 * (sx * sx + sy * sy);
+    }
+  }
+
+  std::vector<CType> symbolHost(N * batch);
+  for (unsigned cnt = 0; cnt < batch; cnt++)
+  {
+    RType meanCoefficient =
+        agile::lowlevel::norm1(
+            coefficient.data() + CoefficientOffset(coefficient, cnt), N) /
+        (RType)N;
+
+    for (unsigned ind = 0; ind < N; ind++)
+    {
+      RType lambda = meanCoefficient + mu * laplacian[ind];
+
+      // constant mode of a pure Poisson problem, keep it unchanged
+      if (lambda <= 0)
+        lambda = 1.0;
+      symbolHost[cnt * N + ind] = (RType)1.0 / (lambda * N);
+    }
+  }
+  symbol.assignFromHost(symbolHost.begin(), symbolHost.end());
+}
+
+void ScreenedPoissonSolver::Precondition(CVector &r, CVector &z)
+{
+  unsigned N = width * height;
+  cufftResult cres = cufftExecC2C(plan, (cufftComplex *)r.data(),
+                                  (cufftComplex *)z.data(), CUFFT_FORWARD);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during FFT procedure"));
+
+  for (unsigned cnt = 0; cnt < batch; cnt++)
+  {
+    agile::lowlevel::multiplyElementwise(symbol.data() + cnt * N,
+                                         z.data() + cnt * N,
+                                         z.data() + cnt * N, N);
+  }
+
+  cres = cufftExecC2C(plan, (cufftComplex *)z.data(), (cufftComplex *)z.data(),
+                      CUFFT_INVERSE);
+  AGILE_ASSERT(cres == CUFFT_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during FFT procedure"));
+}
+
+void ScreenedPoissonSolver::Solve(CVector &coefficient, RType mu, CVector &rhs,
+                                  CVector &x, RType tolerance, unsigned maxIt)
+{
+  unsigned N = width * height * batch;
+  InitPreconditioner(coefficient, mu);
+
+  CVector r(N), z(N), p(N), Ap(N);
+
+  converged = false;
+  iterations = 0;
+  relativeResidual = 0;
+
+  RType rhsNorm = agile::norm2(rhs);
+  if (rhsNorm == 0)
+  {
+    x.assign(N, 0);
+    converged = true;
+    return;
+  }
+
+  // r = y - Ax
+  ApplyOperator(coefficient, mu, x, Ap);
+  agile::subVector(rhs, Ap, r);
+  relativeResidual = agile::norm2(r) / rhsNorm;
+
+  Precondition(r, z);
+  agile::copy(z, p);
+  RType rz = std::real(agile::getScalarProduct(r, z));
+
+  while (iterations < maxIt && relativeResidual > tolerance)
+  {
+    ApplyOperator(coefficient, mu, p, Ap);
+    RType alpha = rz / std::real(agile::getScalarProduct(p, Ap));
+
+    agile::addScaledVector(x, alpha, p, x);
+    agile::addScaledVector(r, -alpha, Ap, r);
+    iterations++;
+
+    relativeResidual = agile::norm2(r) / rhsNorm;
+    if (relativeResidual <= tolerance)
+      break;
+
+    Precondition(r, z);
+    RType rzNew = std::real(agile::getScalarProduct(r, z));
+    RType beta = rzNew / rz;
+    rz = rzNew;
+
+    // p = z + beta * p
+    agile::addScaledVector(z, beta, p, p);
+  }
+  converged = relativeResidual <= tolerance;
+}
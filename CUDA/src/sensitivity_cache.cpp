@@ -0,0 +1,231 @@
+#include "../include/sensitivity_cache.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace
+{
+const char cacheMagic[8] = { 'A', 'V', 'B', '1', 'U', '0', 'v', '1' };
+
+// 64 bit FNV-1a
+const uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t fnvPrime = 1099511628211ULL;
+}
+
+SensitivityCache::SensitivityCache(const std::string &directory)
+  : directory(directory), key(fnvOffsetBasis)
+{
+}
+
+SensitivityCache::~SensitivityCache()
+{
+}
+
+bool SensitivityCache::IsEnabled() const
+{
+  return !directory.empty();
+}
+
+void SensitivityCache::AddToKey(const void *data, size_t bytes)
+{
+  const unsigned char *ptr = static_cast<const unsigned char *>(data);
+  for (size_t cnt = 0; cnt < bytes; cnt++)
+  {
+    key ^= ptr[cnt];
+    key *= fnvPrime;
+  }
+}
+
+void SensitivityCache::AddToKey(CVector &data)
+{
+  std::vector<CType> dataHost;
+  data.copyToHost(dataHost);
+  AddValueToKey((uint64_t)dataHost.size());
+  if (!dataHost.empty())
+    AddToKey(&dataHost[0], dataHost.size() * sizeof(CType));
+}
+
+void SensitivityCache::AddToKey(RVector &data)
+{
+  std::vector<RType> dataHost;
+  data.copyToHost(dataHost);
+  AddValueToKey((uint64_t)dataHost.size());
+  if (!dataHost.empty())
+    AddToKey(&dataHost[0], dataHost.size() * sizeof(RType));
+}
+
+void SensitivityCache::AddToKey(const Dimension &dims)
+{
+  AddValueToKey(dims.width);
+  AddValueToKey(dims.height);
+  AddValueToKey(dims.depth);
+  AddValueToKey(dims.readouts);
+  AddValueToKey(dims.encodings);
+  AddValueToKey(dims.encodings2);
+  AddValueToKey(dims.coils);
+  AddValueToKey(dims.frames);
+}
+
+void SensitivityCache::AddToKey(const CoilConstructionParams &params)
+{
+  // field by field, struct padding is undefined
+  AddValueToKey(params.maxIt);
+  AddValueToKey(params.dx);
+  AddValueToKey(params.dy);
+  AddValueToKey(params.dz);
+  AddValueToKey(params.dt);
+  AddValueToKey(params.stopPDGap);
+  AddValueToKey(params.sigma);
+  AddValueToKey(params.tau);
+
+  AddValueToKey(params.uH1mu);
+  AddValueToKey(params.uReg);
+  AddValueToKey(params.uNrIt);
+  AddValueToKey(params.uTau);
+  AddValueToKey(params.uSigma);
+  AddValueToKey(params.uSigmaTauRatio);
+  AddValueToKey(params.uAlpha0);
+  AddValueToKey(params.uAlpha1);
+  AddValueToKey(params.uWarmNrIt);
+  AddValueToKey(params.b1Reg);
+  AddValueToKey(params.b1NrIt);
+  AddValueToKey(params.b1Tau);
+  AddValueToKey(params.b1Sigma);
+  AddValueToKey(params.b1SigmaTauRatio);
+  AddValueToKey(params.b1BatchSize);
+  AddValueToKey(params.b1FinalReg);
+  AddValueToKey(params.b1FinalNrIt);
+  AddValueToKey((unsigned char)params.pcgSolver);
+  AddValueToKey(params.pcgTolerance);
+  AddValueToKey(params.lowResFactor);
+}
+
+uint64_t SensitivityCache::GetKey() const
+{
+  return key;
+}
+
+std::string SensitivityCache::GetFilename() const
+{
+  std::stringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".b1cache";
+  return (boost::filesystem::path(directory) / name.str()).string();
+}
+
+bool SensitivityCache::Load(const Dimension &dims, CVector &b1, CVector &u0)
+{
+  if (!IsEnabled())
+    return false;
+
+  std::string filename = GetFilename();
+  if (!boost::filesystem::exists(filename))
+    return false;
+
+  unsigned N = dims.width * dims.height;
+  size_t expectedSize = sizeof(SensitivityCacheHeader) +
+                        (size_t)N * (dims.coils + 1) * sizeof(CType);
+
+  try
+  {
+    boost::iostreams::mapped_file_source file(filename);
+    if (file.size() != expectedSize)
+    {
+      std::cerr << "Sensitivity cache: " << filename
+                << " has invalid size, ignored." << std::endl;
+      return false;
+    }
+
+    SensitivityCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+        header.key != key || header.width != dims.width ||
+        header.height != dims.height || header.coils != dims.coils ||
+        header.u0Size != N)
+    {
+      std::cerr << "Sensitivity cache: " << filename
+                << " does not match data dimensions, ignored." << std::endl;
+      return false;
+    }
+
+    const CType *data =
+        reinterpret_cast<const CType *>(file.data() + sizeof(header));
+    b1.assignFromHost(data, data + N * dims.coils);
+    u0.assignFromHost(data + N * dims.coils, data + N * (dims.coils + 1));
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Sensitivity cache: " << filename
+              << " could not be read: " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool SensitivityCache::Store(const Dimension &dims, CVector &b1, CVector &u0)
+{
+  if (!IsEnabled())
+    return false;
+
+  unsigned N = dims.width * dims.height;
+  if (b1.size() != N * dims.coils || u0.size() != N)
+    throw std::invalid_argument(
+        "SensitivityCache: b1/u0 do not match data dimensions");
+
+  SensitivityCacheHeader header;
+  std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.key = key;
+  header.width = dims.width;
+  header.height = dims.height;
+  header.coils = dims.coils;
+  header.u0Size = N;
+
+  std::vector<CType> b1Host, u0Host;
+  b1.copyToHost(b1Host);
+  u0.copyToHost(u0Host);
+
+  std::string filename = GetFilename();
+  std::string tmpFilename;
+  try
+  {
+    boost::filesystem::create_directories(directory);
+
+    // one temporary file per writer, concurrent runs storing the same key
+    // must not write to the same file
+    tmpFilename =
+        boost::filesystem::unique_path(filename + ".%%%%-%%%%-%%%%.tmp")
+            .string();
+
+    std::ofstream file(tmpFilename.c_str(), std::ios_base::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(&b1Host[0]),
+               b1Host.size() * sizeof(CType));
+    file.write(reinterpret_cast<const char *>(&u0Host[0]),
+               u0Host.size() * sizeof(CType));
+    file.close();
+    if (!file)
+    {
+      boost::filesystem::remove(tmpFilename);
+      return false;
+    }
+
+    // concurrent runs never see partially written entries
+    boost::filesystem::rename(tmpFilename, filename);
+  }
+  catch (const boost::filesystem::filesystem_error &e)
+  {
+    std::cerr << "Sensitivity cache: " << e.what() << std::endl;
+    if (!tmpFilename.empty())
+    {
+      boost::system::error_code ec;
+      boost::filesystem::remove(tmpFilename, ec);
+    }
+    return false;
+  }
+  return true;
+}
@@ -1,13 +1,52 @@
 #include "../include/siemens_vd11_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// VD11 raw data layout
+// raid file header: hdSize, count, followed by 64 entries of 152 bytes
+static const size_t VD11_RAID_HEADER_SIZE = 8;
+static const size_t VD11_RAID_ENTRY_SIZE = 152;
+static const unsigned VD11_RAID_MAX_ENTRIES = 64;
+// scan header (MDH) and channel header sizes
+static const size_t VD11_SCAN_HEADER_SIZE = 192;
+static const size_t VD11_CHANNEL_HEADER_SIZE = 32;
+static const unsigned VD11_DMA_LENGTH_MASK = 0x01FFFFFF;
+
+// evaluation info mask bits
+static const unsigned MDH_ACQEND = 1u << 0;
+static const unsigned MDH_RTFEEDBACK = 1u << 1;
+static const unsigned MDH_HPFEEDBACK = 1u << 2;
+static const unsigned MDH_SYNCDATA = 1u << 5;
+static const unsigned MDH_REFPHASESTABSCAN = 1u << 14;
+static const unsigned MDH_PHASESTABSCAN = 1u << 15;
+static const unsigned MDH_PHASCOR = 1u << 21;
+static const unsigned MDH_REFLECT = 1u << 24;
+static const unsigned MDH_NOISEADJSCAN = 1u << 25;
+
+// scans which do not contain imaging data
+static const unsigned MDH_SKIP_MASK = MDH_RTFEEDBACK | MDH_HPFEEDBACK |
+                                      MDH_SYNCDATA | MDH_REFPHASESTABSCAN |
+                                      MDH_PHASESTABSCAN | MDH_PHASCOR;
+
+template <typename T>
+static T ReadValue(const char *buffer, size_t offset)
+{
+  T value;
+  std::memcpy(&value, buffer + offset, sizeof(T));
+  return value;
+}
 
 SiemensVD11Reader::SiemensVD11Reader(OptionsParser &op)
-  : RawDataReader(op), rawDataPath(op.kdataFilename)
+  : RawDataReader(op), rawDataPath(op.kdataFilename), rawDataBuffer(NULL),
+    rawDataLength(0), centerRow(0), centerColumn(0)
 {
 }
 
 SiemensVD11Reader::SiemensVD11Reader(OptionsParser &op,
                                      const std::string &rawDataPath)
-  : RawDataReader(op), rawDataPath(rawDataPath)
+  : RawDataReader(op), rawDataPath(rawDataPath), rawDataBuffer(NULL),
+    rawDataLength(0), centerRow(0), centerColumn(0)
 {
 }
 
@@ -15,24 +54,129 @@ SiemensVD11Reader::~SiemensVD11Reader()
 {
 }
 
-//TODO: check for 3d dimensions (right now just rows2)
+size_t SiemensVD11Reader::FindFirstScanOffset(const char *buffer,
+                                              size_t length,
+                                              size_t &endOffset) const
+{
+  endOffset = length;
+  if (length < VD11_RAID_HEADER_SIZE + VD11_RAID_ENTRY_SIZE)
+    return 0;
+
+  unsigned hdSize = ReadValue<unsigned>(buffer, 0);
+  unsigned count = ReadValue<unsigned>(buffer, 4);
+
+  // plain sequence of scans, e.g. raw data embedded in dicom files
+  if (hdSize != 0 || count == 0 || count > VD11_RAID_MAX_ENTRIES)
+    return 0;
+
+  // use last measurement of multi-raid file, which contains the imaging data
+  size_t entry = VD11_RAID_HEADER_SIZE + (count - 1) * VD11_RAID_ENTRY_SIZE;
+  unsigned long long measOffset =
+      ReadValue<unsigned long long>(buffer, entry + 8);
+  unsigned long long measLength =
+      ReadValue<unsigned long long>(buffer, entry + 16);
+
+  if (measOffset + sizeof(unsigned) > length)
+    throw std::runtime_error("SiemensVD11Reader: invalid measurement offset "
+                             "in raid file header.");
+
+  endOffset = std::min<unsigned long long>(length, measOffset + measLength);
+
+  // skip measurement protocol header
+  return measOffset + ReadValue<unsigned>(buffer, measOffset);
+}
+
+void SiemensVD11Reader::IndexRawData(const char *buffer, size_t length)
+{
+  rawDataBuffer = buffer;
+  rawDataLength = length;
+  scanIndex.clear();
+
+  size_t endOffset;
+  size_t offset = FindFirstScanOffset(buffer, length, endOffset);
+
+  while (offset + VD11_SCAN_HEADER_SIZE <= endOffset)
+  {
+    VD11ScanInfo scan;
+    scan.offset = offset;
+    scan.evalInfoMask = ReadValue<unsigned>(buffer, offset + 40);
+
+    if (scan.evalInfoMask & MDH_ACQEND)
+      break;
+
+    size_t scanLength =
+        ReadValue<unsigned>(buffer, offset) & VD11_DMA_LENGTH_MASK;
+
+    if (!(scan.evalInfoMask & MDH_SYNCDATA))
+    {
+      scan.samples = ReadValue<unsigned short>(buffer, offset + 48);
+      scan.channels = ReadValue<unsigned short>(buffer, offset + 50);
+      // loop counters
+      scan.line = ReadValue<unsigned short>(buffer, offset + 52);
+      scan.slice = ReadValue<unsigned short>(buffer, offset + 56);
+      scan.partition = ReadValue<unsigned short>(buffer, offset + 58);
+      scan.phase = ReadValue<unsigned short>(buffer, offset + 62);
+      scan.centreColumn = ReadValue<unsigned short>(buffer, offset + 84);
+      scan.centreLine = ReadValue<unsigned short>(buffer, offset + 96);
+
+      // the DMA length is not reliable for imaging scans
+      scanLength = VD11_SCAN_HEADER_SIZE +
+                   scan.channels * (VD11_CHANNEL_HEADER_SIZE +
+                                    scan.samples * sizeof(CType));
+
+      if (offset + scanLength > endOffset)
+      {
+        std::cerr << "SiemensVD11Reader: truncated scan at offset " << offset
+                  << " ignored." << std::endl;
+        break;
+      }
+
+      if (!(scan.evalInfoMask & MDH_SKIP_MASK) && scan.channels > 0)
+        scanIndex.push_back(scan);
+    }
+
+    if (scanLength == 0)
+      throw std::runtime_error("SiemensVD11Reader: invalid scan length.");
+    offset += scanLength;
+  }
+
+  if (scanIndex.empty())
+    throw std::runtime_error("SiemensVD11Reader: no imaging scans found in "
+                             "raw data.");
+
+  InitRawDataDimensions();
+}
+
+//TODO: check for 3d dimensions (right now just partitions)
 void SiemensVD11Reader::InitRawDataDimensions()
 {
-  unsigned int rows, cols, rows2, coils;
-  unsigned short int acq, sli, par, echo, pha, rep, set, seg;
+  unsigned rows = 0, cols = 0, rows2 = 0, pha = 0;
+  unsigned coils = scanIndex.front().channels;
+  bool firstImagingScan = true;
 
-  rawData.getRawdata_info(rows, cols, coils, acq, sli, par, echo, pha, rep, set,
-                          seg);
+  for (unsigned cnt = 0; cnt < scanIndex.size(); cnt++)
+  {
+    const VD11ScanInfo &scan = scanIndex[cnt];
+    if (scan.evalInfoMask & MDH_NOISEADJSCAN)
+      continue;
 
-  std::cout << "Rows: " << rows << ", Columns: " << cols << ", Coils: " << coils
-            << std::endl;
+    // k-space centre of the imaging scans, noise scans carry no centre
+    if (firstImagingScan)
+    {
+      centerRow = scan.centreLine;
+      centerColumn = scan.centreColumn;
+      firstImagingScan = false;
+    }
+    rows = std::max(rows, scan.line + 1u);
+    cols = std::max(cols, (unsigned)scan.samples);
+    rows2 = std::max(rows2, scan.partition + 1u);
+    pha = std::max(pha, (unsigned)scan.phase);
+  }
 
-  std::cout << "Acquisition: " << acq << ", Slice:" << sli
-            << ", Partition:" << par << std::endl;
-  std::cout << "Echo: " << echo << ", Phase:" << pha << ", Repetition:" << rep
-            << std::endl;
-  std::cout << "Set: " << set << ", Segment:" << seg << ", Repetition:" << rep
+  std::cout << "Rows: " << rows << ", Columns: " << cols << ", Coils: " << coils
             << std::endl;
+  std::cout << "Partitions: " << rows2 << ", Phases: " << pha + 1
+            << ", Scans: " << scanIndex.size() << std::endl;
 
   // TODO check Phase value and fix it
   rawDataDims = Dimension(cols, rows, rows2, cols, rows, rows2, coils, pha + 1);
@@ -41,13 +185,13 @@ void SiemensVD11Reader::InitRawDataDimensions()
 void SiemensVD11Reader::LoadRawData()
 {
   std::cout << "Load RawData: " << rawDataPath << std::endl;
-  rawData = agile::ReadSiemensVD11(rawDataPath);
-  int error = rawData.readfile(true);
-  std::cout << "ReadFile Ret.Code:" << error << std::endl;
+  mappedFile.open(rawDataPath);
+  if (!mappedFile.is_open())
+    throw std::runtime_error("SiemensVD11Reader: could not open raw data " +
+                             rawDataPath);
 
-  InitRawDataDimensions();
+  IndexRawData(mappedFile.data(), mappedFile.size());
 
-  rawDataList = rawData.getRawdataList();
   std::cout << "RawDataDims: width " << rawDataDims.width << " height"
             << rawDataDims.height << std::endl;
 }
@@ -59,19 +203,17 @@ Dimension SiemensVD11Reader::GetRawDataDimensions() const
 
 unsigned SiemensVD11Reader::GetCenterRow() const
 {
-  agile::VD11_Image img;
-  return img.getUshConsistentKSpaceCentreLineNo();
+  return centerRow;
 }
 
 unsigned SiemensVD11Reader::GetCenterColumn() const
 {
-  agile::VD11_Image img;
-  return img.getUshConsistentKSpaceCentreColumn();
+  return centerColumn;
 }
 
 unsigned SiemensVD11Reader::GetNumberOfAcquisitions() const
 {
-  return rawDataList.size();
+  return scanIndex.size();
 }
 
 bool SiemensVD11Reader::IsNonUniformData() const
@@ -86,30 +228,57 @@ bool SiemensVD11Reader::IsOversampledData() const
   return true;
 }
 
+void SiemensVD11Reader::SetAcquisitionHeader(const VD11ScanInfo &scan,
+                                             AcquisitionHeader &header) const
+{
+  header.line = scan.line;
+  header.phase = scan.phase;
+  header.slice = scan.slice;
+  header.centerColumn = scan.centreColumn;
+  header.centerRow = scan.centreLine;
+  header.readouts = rawDataDims.readouts;
+  header.hasTrajectory = this->IsNonUniformData();
+  header.isNoiseMeasurement = (scan.evalInfoMask & MDH_NOISEADJSCAN) != 0;
+}
+
+void SiemensVD11Reader::GetAcquisitionHeaders(
+    std::vector<AcquisitionHeader> &headers) const
+{
+  // headers are available from the scan index
+  headers.resize(scanIndex.size());
+  for (unsigned cnt = 0; cnt < scanIndex.size(); cnt++)
+    this->SetAcquisitionHeader(scanIndex[cnt], headers[cnt]);
+}
 
 Acquisition SiemensVD11Reader::GetAcquisition(unsigned index) const
 {
-  // TODO check index range
-  std::list<agile::VD11_Image>::const_iterator it = rawDataList.begin();
-  std::advance(it, index);
-  agile::VD11_Image img = *it;
+  if (index >= scanIndex.size())
+    throw std::out_of_range("SiemensVD11Reader: acquisition index out of "
+                            "range.");
+
+  const VD11ScanInfo &scan = scanIndex[index];
   Acquisition acq;
-  acq.line = img.get_ushLine();
-  acq.phase = img.getUshPhase();
-  acq.centerColumn = img.ushKSpaceCentreColumn;
-  acq.centerRow = img.ushKSpaceCentreLineNo;
-  acq.readouts = rawDataDims.readouts;
-
-  // Set coil data
-  for (unsigned cnt = 0; cnt < rawDataDims.coils; cnt++)
+  this->SetAcquisitionHeader(scan, acq);
+
+  // Set coil data, decoded directly from the mapped buffer
+  acq.resizeData(scan.channels, scan.samples);
+  size_t channelLength =
+      VD11_CHANNEL_HEADER_SIZE + scan.samples * sizeof(CType);
+  for (unsigned cnt = 0; cnt < scan.channels; cnt++)
   {
-    acq.data.insert(std::make_pair(cnt, img.get_channeldata(cnt)));
+    const char *channelData = rawDataBuffer + scan.offset +
+                              VD11_SCAN_HEADER_SIZE + cnt * channelLength +
+                              VD11_CHANNEL_HEADER_SIZE;
+    std::memcpy(acq.coilData(cnt), channelData, scan.samples * sizeof(CType));
+
+    if (scan.evalInfoMask & MDH_REFLECT)
+      std::reverse(acq.coilData(cnt), acq.coilData(cnt) + scan.samples);
   }
 
   // Set trajectory mask data
   if (this->IsNonUniformData())
-    this->GenerateRadialTrajectory(acq.line, acq.traj, acq.dens, rawDataDims.encodings, rawDataDims.readouts);
+    this->GenerateRadialTrajectory(acq.line, acq.traj, acq.dens,
+                                   rawDataDims.encodings, rawDataDims.readouts);
 
   return acq;
 }
-
@@ -0,0 +1,160 @@
+#include "../include/solver_checkpoint.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+const char checkpointMagic[8] = { 'A', 'V', 'C', 'K', 'P', 'T', 'v', '1' };
+
+volatile std::sig_atomic_t terminationRequested = 0;
+
+extern "C" void HandleTermination(int sig)
+{
+  // a second signal terminates immediately, e.g. outside the iteration
+  terminationRequested = 1;
+  std::signal(sig, SIG_DFL);
+}
+
+void WriteVector(std::ofstream &file, const std::vector<CType> &data)
+{
+  uint64_t length = data.size();
+  file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  if (length > 0)
+    file.write(reinterpret_cast<const char *>(&data[0]),
+               length * sizeof(CType));
+}
+
+bool ReadVector(std::ifstream &file, std::vector<CType> &data)
+{
+  uint64_t length = 0;
+  if (!file.read(reinterpret_cast<char *>(&length), sizeof(length)))
+    return false;
+  data.resize(length);
+  if (length > 0)
+    file.read(reinterpret_cast<char *>(&data[0]), length * sizeof(CType));
+  return (bool)file;
+}
+}
+
+SolverCheckpoint::SolverCheckpoint(const std::string &filename)
+  : filename(filename), lastWriteSucceeded(true)
+{
+}
+
+SolverCheckpoint::~SolverCheckpoint()
+{
+  Wait();
+}
+
+const std::string &SolverCheckpoint::GetFilename() const
+{
+  return filename;
+}
+
+bool SolverCheckpoint::Write(const SolverCheckpointData &data)
+{
+  SolverCheckpointHeader header;
+  std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+  header.iteration = data.iteration;
+  header.scalarCount = data.scalars.size();
+  header.vectorCount = data.vectors.size();
+  header.historyCount = data.histories.size();
+
+  std::string tmpFilename = filename + ".tmp";
+  std::ofstream file(tmpFilename.c_str(), std::ios_base::binary);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!data.scalars.empty())
+    file.write(reinterpret_cast<const char *>(&data.scalars[0]),
+               data.scalars.size() * sizeof(double));
+  for (unsigned cnt = 0; cnt < data.vectors.size(); cnt++)
+    WriteVector(file, data.vectors[cnt]);
+  for (unsigned cnt = 0; cnt < data.histories.size(); cnt++)
+    WriteVector(file, data.histories[cnt]);
+  file.close();
+
+  // an existing checkpoint is only replaced by a complete one
+  if (!file || std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+  {
+    std::remove(tmpFilename.c_str());
+    std::cerr << "Checkpoint: " << filename << " could not be written."
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SolverCheckpoint::WriteAsync(SolverCheckpointData &data)
+{
+  Wait();
+  pending = SolverCheckpointData();
+  pending.iteration = data.iteration;
+  pending.scalars.swap(data.scalars);
+  pending.vectors.swap(data.vectors);
+  pending.histories.swap(data.histories);
+  writer = boost::thread(&SolverCheckpoint::WritePending, this);
+}
+
+void SolverCheckpoint::WritePending()
+{
+  bool success = Write(pending);
+  boost::mutex::scoped_lock lock(mutex);
+  lastWriteSucceeded = success;
+}
+
+bool SolverCheckpoint::Wait()
+{
+  if (writer.joinable())
+    writer.join();
+  boost::mutex::scoped_lock lock(mutex);
+  return lastWriteSucceeded;
+}
+
+bool SolverCheckpoint::Read(const std::string &filename,
+                            SolverCheckpointData &data)
+{
+  std::ifstream file(filename.c_str(), std::ios_base::binary);
+  if (!file)
+    return false;
+
+  SolverCheckpointHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0)
+  {
+    std::cerr << "Checkpoint: " << filename << " is no valid checkpoint."
+              << std::endl;
+    return false;
+  }
+
+  data.iteration = header.iteration;
+  data.scalars.resize(header.scalarCount);
+  if (header.scalarCount > 0)
+    file.read(reinterpret_cast<char *>(&data.scalars[0]),
+              header.scalarCount * sizeof(double));
+  data.vectors.resize(header.vectorCount);
+  for (unsigned cnt = 0; cnt < header.vectorCount && file; cnt++)
+    ReadVector(file, data.vectors[cnt]);
+  data.histories.resize(header.historyCount);
+  for (unsigned cnt = 0; cnt < header.historyCount && file; cnt++)
+    ReadVector(file, data.histories[cnt]);
+
+  if (!file)
+  {
+    std::cerr << "Checkpoint: " << filename << " is truncated." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void SolverCheckpoint::InstallSignalHandler()
+{
+  std::signal(SIGTERM, HandleTermination);
+  std::signal(SIGINT, HandleTermination);
+}
+
+bool SolverCheckpoint::TerminationRequested()
+{
+  return terminationRequested != 0;
+}
@@ -0,0 +1,262 @@
+#include "../include/subspace_operator.h"
+#include <algorithm>
+#include <stdexcept>
+#include "agile/agile.hpp"
+#include "../include/coil_compression.h"
+
+SubspaceOperator::SubspaceOperator(BaseOperator *mrOp, unsigned width,
+                                   unsigned height, unsigned coils,
+                                   unsigned frames,
+                                   const std::vector<CType> &basis,
+                                   unsigned basisSize)
+  : BaseOperator(width, height, 0, coils, basisSize), mrOp(mrOp),
+    cartOp(dynamic_cast<CartesianOperator *>(mrOp)), seriesFrames(frames),
+    series(cartOp == NULL ? width * height * frames : 0),
+    coefficientTemp(width * height * basisSize), imageTemp(width * height)
+{
+  if (basisSize == 0 || basis.size() != frames * basisSize)
+    throw std::invalid_argument(
+        "SubspaceOperator: basis does not match the number of frames");
+
+  std::vector<CType> conjugate(basis.size());
+  for (unsigned cnt = 0; cnt < basis.size(); cnt++)
+    conjugate[cnt] = std::conj(basis[cnt]);
+  this->basis.assignFromHost(basis.begin(), basis.end());
+  conjBasis.assignFromHost(conjugate.begin(), conjugate.end());
+
+  cublasStatus_t status = cublasCreate(&handle);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during cuBLAS initialization"));
+}
+
+SubspaceOperator::~SubspaceOperator()
+{
+  cublasDestroy(handle);
+}
+
+unsigned SubspaceOperator::GetBasisSize() const
+{
+  return frames;
+}
+
+RType SubspaceOperator::EstimateBasis(CVector &x, unsigned N, unsigned frames,
+                                      unsigned basisSize,
+                                      std::vector<CType> &basis)
+{
+  if (basisSize == 0 || basisSize > frames)
+    throw std::invalid_argument("SubspaceOperator: invalid basis size");
+
+  cublasHandle_t handle;
+  cublasStatus_t status = cublasCreate(&handle);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during cuBLAS initialization"));
+
+  // temporal correlation X^H X of the Casorati matrix
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  CVector gramGPU(frames * frames);
+  status = cublasCgemm(handle, CUBLAS_OP_C, CUBLAS_OP_N, frames, frames, N,
+                       &one, (cuComplex *)x.data(), N, (cuComplex *)x.data(),
+                       N, &zero, (cuComplex *)gramGPU.data(), frames);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during temporal correlation computation"));
+  cublasDestroy(handle);
+
+  std::vector<CType> gram;
+  gramGPU.copyToHost(gram);
+  std::vector<RType> eigenvalues;
+  std::vector<CType> eigenvectors;
+  CoilCompression::HermitianEigen(gram, frames, eigenvalues, eigenvectors);
+
+  // x_t = sum_k conj(v_tk) * (X v_k), i.e. the basis is the conjugate of the
+  // leading eigenvectors
+  basis.resize(frames * basisSize);
+  for (unsigned cnt = 0; cnt < basis.size(); cnt++)
+    basis[cnt] = std::conj(eigenvectors[cnt]);
+
+  RType total = 0, captured = 0;
+  for (unsigned cnt = 0; cnt < frames; cnt++)
+  {
+    total += std::max(eigenvalues[cnt], (RType)0);
+    if (cnt < basisSize)
+      captured += std::max(eigenvalues[cnt], (RType)0);
+  }
+  return total > 0 ? (total - captured) / total : 0;
+}
+
+void SubspaceOperator::Expand(CVector &coefficients, CVector &x)
+{
+  unsigned N = width * height;
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  cublasStatus_t status = cublasCgemm(
+      handle, CUBLAS_OP_N, CUBLAS_OP_T, N, seriesFrames, frames, &one,
+      (cuComplex *)coefficients.data(), N, (cuComplex *)basis.data(),
+      seriesFrames, &zero, (cuComplex *)x.data(), N);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during subspace expansion"));
+}
+
+void SubspaceOperator::Project(CVector &x, CVector &coefficients)
+{
+  unsigned N = width * height;
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  cublasStatus_t status = cublasCgemm(
+      handle, CUBLAS_OP_N, CUBLAS_OP_N, N, frames, seriesFrames, &one,
+      (cuComplex *)x.data(), N, (cuComplex *)conjBasis.data(), seriesFrames,
+      &zero, (cuComplex *)coefficients.data(), N);
+  AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+               StandardException::ExceptionMessage(
+                   "Error during subspace projection"));
+}
+
+RType SubspaceOperator::AdaptLambda(RType k, RType d)
+{
+  return mrOp->AdaptLambda(k, d);
+}
+
+void SubspaceOperator::ForwardOperation(CVector &x_gpu, CVector &sum,
+                                        CVector &b1_gpu)
+{
+  if (cartOp != NULL)
+  {
+    CartesianForward(x_gpu, sum, b1_gpu);
+    return;
+  }
+  mrOp->ForwardOperation(x_gpu, series, b1_gpu);
+  Project(series, sum);
+}
+
+CVector SubspaceOperator::ForwardOperation(CVector &x_gpu, CVector &b1_gpu)
+{
+  CVector sum_gpu(width * height * frames);
+  ForwardOperation(x_gpu, sum_gpu, b1_gpu);
+  return sum_gpu;
+}
+
+void SubspaceOperator::BackwardOperation(CVector &x_gpu, CVector &z_gpu,
+                                         CVector &b1_gpu)
+{
+  if (cartOp != NULL)
+  {
+    CartesianBackward(x_gpu, z_gpu, b1_gpu);
+    return;
+  }
+  Expand(x_gpu, series);
+  mrOp->BackwardOperation(series, z_gpu, b1_gpu);
+}
+
+CVector SubspaceOperator::BackwardOperation(CVector &x_gpu, CVector &b1_gpu)
+{
+  CVector z_gpu(width * height * coils * seriesFrames);
+  BackwardOperation(x_gpu, z_gpu, b1_gpu);
+  return z_gpu;
+}
+
+void SubspaceOperator::CartesianForward(CVector &x_gpu, CVector &sum,
+                                        CVector &b1_gpu)
+{
+  unsigned N = width * height;
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  RVector &mask = cartOp->mask;
+
+  sum.assign(N * frames, 0.0);
+  for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
+  {
+    unsigned coil = activeCoils[cnt];
+
+    // masked in place like in the Cartesian operator
+    if (!mask.empty())
+    {
+      for (unsigned frame = 0; frame < seriesFrames; frame++)
+      {
+        unsigned offset = (frame * coils + coil) * N;
+        agile::lowlevel::multiplyElementwise(x_gpu.data() + offset,
+                                             mask.data() + frame * N,
+                                             x_gpu.data() + offset, N);
+      }
+    }
+
+    // k-space of the coefficient images, frames of one coil are strided
+    cublasStatus_t status = cublasCgemm(
+        handle, CUBLAS_OP_N, CUBLAS_OP_N, N, frames, seriesFrames, &one,
+        (cuComplex *)x_gpu.data() + coil * N, coils * N,
+        (cuComplex *)conjBasis.data(), seriesFrames, &zero,
+        (cuComplex *)coefficientTemp.data(), N);
+    AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during subspace projection"));
+
+    for (unsigned coefficient = 0; coefficient < frames; coefficient++)
+    {
+      if (cartOp->centered)
+        cartOp->fftOp->CenteredForward(coefficientTemp, imageTemp,
+                                       coefficient * N, 0);
+      else
+        cartOp->fftOp->Forward(coefficientTemp, imageTemp, coefficient * N,
+                               0);
+
+      // apply adjoint b1 map
+      agile::lowlevel::multiplyConjElementwise(b1_gpu.data() + coil * N,
+                                               imageTemp.data(),
+                                               imageTemp.data(), N);
+      agile::lowlevel::addVector(imageTemp.data(),
+                                 sum.data() + coefficient * N,
+                                 sum.data() + coefficient * N, N);
+    }
+  }
+}
+
+void SubspaceOperator::CartesianBackward(CVector &x_gpu, CVector &z_gpu,
+                                         CVector &b1_gpu)
+{
+  unsigned N = width * height;
+  cuComplex one = make_cuComplex(1.0, 0.0);
+  cuComplex zero = make_cuComplex(0.0, 0.0);
+  RVector &mask = cartOp->mask;
+
+  for (unsigned cnt = 0; cnt < activeCoils.size(); cnt++)
+  {
+    unsigned coil = activeCoils[cnt];
+    for (unsigned coefficient = 0; coefficient < frames; coefficient++)
+    {
+      // apply b1 map
+      agile::lowlevel::multiplyElementwise(x_gpu.data() + coefficient * N,
+                                           b1_gpu.data() + coil * N,
+                                           imageTemp.data(), N);
+      if (cartOp->centered)
+        cartOp->fftOp->CenteredInverse(imageTemp, coefficientTemp, 0,
+                                       coefficient * N);
+      else
+        cartOp->fftOp->Inverse(imageTemp, coefficientTemp, 0,
+                               coefficient * N);
+    }
+
+    // combine the k-space of the coefficients to the frames of the coil
+    cublasStatus_t status = cublasCgemm(
+        handle, CUBLAS_OP_N, CUBLAS_OP_T, N, seriesFrames, frames, &one,
+        (cuComplex *)coefficientTemp.data(), N, (cuComplex *)basis.data(),
+        seriesFrames, &zero, (cuComplex *)z_gpu.data() + coil * N,
+        coils * N);
+    AGILE_ASSERT(status == CUBLAS_STATUS_SUCCESS,
+                 StandardException::ExceptionMessage(
+                     "Error during subspace expansion"));
+
+    if (!mask.empty())
+    {
+      for (unsigned frame = 0; frame < seriesFrames; frame++)
+      {
+        unsigned offset = (frame * coils + coil) * N;
+        agile::lowlevel::multiplyElementwise(z_gpu.data() + offset,
+                                             mask.data() + frame * N,
+                                             z_gpu.data() + offset, N);
+      }
+    }
+  }
+}
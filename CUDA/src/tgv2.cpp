@@ -43,6 +43,11 @@ void TGV2::InitParams()
   params.tau = 1.0 / 3.0;
 
   params.sigmaTauRatio = 1.0;
+  params.diagonalPreconditioning = false;
+  params.variant = PD_STANDARD;
+  params.restart = false;
+  params.andersonDepth = 0;
+  params.coilSubsetSize = 0;
   params.timeSpaceWeight = 5.0;
 
   params.dx = 1.0;
@@ -76,6 +81,54 @@ void TGV2::InitTempVectors()
   }
 }
 
+void TGV2::InitSteps(CVector &b1, unsigned dataSize)
+{
+  if (!params.diagonalPreconditioning)
+  {
+    sigmaY1.assign(3, params.sigma);
+    sigmaY2.assign(6, params.sigma);
+    sigmaZ = params.sigma;
+    tauX2.assign(3, params.tau);
+    return;
+  }
+
+  RType h[3] = { params.dx, params.dy, params.dt };
+  std::vector<RType> rowSums, columnSums;
+  SymmetricGradientSums(params.dx, params.dy, params.dt, rowSums, columnSums);
+
+  RType gradientSum = 0;
+  sigmaY1.resize(3);
+  tauX2.resize(3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    gradientSum += 2.0 / h[cnt];
+    // p = grad x1 - x2
+    sigmaY1[cnt] = 1.0 / (2.0 / h[cnt] + 1.0);
+    tauX2[cnt] = 1.0 / (columnSums[cnt] + 1.0);
+  }
+  sigmaY2.resize(6);
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    sigmaY2[cnt] = 1.0 / rowSums[cnt];
+
+  tauX1 = CVector(width * height * frames);
+  sigmaZ = InitDiagonalDataSteps(b1, dataSize, gradientSum, tauX1);
+}
+
+void TGV2::ScaleSteps(RType factor)
+{
+  PDRecon::ScaleSteps(factor);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    sigmaY1[cnt] *= factor;
+    tauX2[cnt] /= factor;
+  }
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    sigmaY2[cnt] *= factor;
+  sigmaZ *= factor;
+  if (params.diagonalPreconditioning)
+    agile::scale((DType)(1.0 / factor), tauX1, tauX1);
+}
+
 PDParams &TGV2::GetParams()
 {
   return params;
@@ -222,11 +275,27 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
   zTemp.resize(data_gpu.size(), 0.0);
   z.assign(N * coils, 0.0);
 
-  unsigned loopCnt = 0;
+  InitSteps(b1_gpu, data_gpu.size());
+
+  ClearState();
+  AddPrimalState(x1, ext1);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    AddPrimalState(x2[cnt], ext2[cnt]);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    AddDualState(y1[cnt]);
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    AddDualState(y2[cnt]);
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
   // loop
   Log("Starting iteration\n");
   while ( loopCnt < params.maxIt )
   {
+    BeginIteration(loopCnt);
+
     // dual ascent step
     // p
     utils::Gradient(ext1, y1Temp, width, height, params.dx, params.dy,
@@ -234,7 +303,7 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::subVector(y1Temp[cnt], ext2[cnt], y1Temp[cnt]);
-      agile::addScaledVector(y1[cnt], params.sigma, y1Temp[cnt], y1[cnt]);
+      agile::addScaledVector(y1[cnt], sigmaY1[cnt], y1Temp[cnt], y1[cnt]);
     }
 
     // q
@@ -242,26 +311,30 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
                              params.dt);
     for (unsigned cnt = 0; cnt < 6; cnt++)
     {
-      agile::addScaledVector(y2[cnt], params.sigma, y2Temp[cnt], y2[cnt]);
+      agile::addScaledVector(y2[cnt], sigmaY2[cnt], y2Temp[cnt], y2[cnt]);
     }
 
-    mrOp->BackwardOperation(ext1, zTemp, b1_gpu);
-    agile::addScaledVector(z, params.sigma, zTemp, z);
+    DataDualStep(ext1, z, zTemp, data_gpu, b1_gpu, sigmaZ);
 
     // Proximal mapping
     utils::ProximalMap3(y1, (DType)1.0 / params.alpha1);
     utils::ProximalMap6(y2, (DType)1.0 / params.alpha0);
 
-    agile::subScaledVector(z, params.sigma, data_gpu, z);
-    agile::scale((float)(1.0 / (1.0 + params.sigma / params.lambda)), z, z);
+    ExtrapolateDual(sigmaZ);
 
     // primal descent
     // ext1
-    mrOp->ForwardOperation(z, imgTemp, b1_gpu);
+    DataAdjoint(z, imgTemp, b1_gpu);
     utils::Divergence(y1, div1Temp, width, height, frames, params.dx, params.dy,
                       params.dt);
     agile::subVector(imgTemp, div1Temp, div1Temp);
-    agile::subScaledVector(x1, params.tau, div1Temp, ext1);
+    if (params.diagonalPreconditioning)
+    {
+      agile::multiplyElementwise(tauX1, div1Temp, div1Temp);
+      agile::subVector(x1, div1Temp, ext1);
+    }
+    else
+      agile::subScaledVector(x1, params.tau, div1Temp, ext1);
 
     // ext2
     utils::SymmetricDivergence(y2, div2Temp, width, height, frames, params.dx,
@@ -269,8 +342,9 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::addVector(y1[cnt], div2Temp[cnt], div2Temp[cnt]);
-      agile::addScaledVector(x2[cnt], params.tau, div2Temp[cnt], ext2[cnt]);
+      agile::addScaledVector(x2[cnt], tauX2[cnt], div2Temp[cnt], ext2[cnt]);
     }
+    RestoreDual();
 
     // save x_n+1
     agile::copy(ext1, x1_old);
@@ -278,20 +352,20 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
       agile::copy(ext2[cnt], x2_old[cnt]);
 
     // extra gradient
-    agile::scale(2.0f, ext1, ext1);
-    agile::subVector(ext1, x1, ext1);
+    Extrapolate(ext1, x1);
     // x_n = x_n+1
     agile::copy(x1_old, x1);
 
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
-      agile::scale((DType)2.0, ext2[cnt], ext2[cnt]);
-      agile::subVector(ext2[cnt], x2[cnt], ext2[cnt]);
+      Extrapolate(ext2[cnt], x2[cnt]);
       agile::copy(x2_old[cnt], x2[cnt]);
     }
 
-    // adapt step size
-    if (loopCnt < 10 || (loopCnt % 50 == 0))
+    // adapt step size, preconditioned steps are valid by construction
+    if (!params.diagonalPreconditioning &&
+        (loopCnt < 10 ||
+         (params.variant == PD_STANDARD && loopCnt % 50 == 0)))
     {
       agile::subVector(ext1, x1, div1Temp);
       for (unsigned cnt = 0; cnt < 3; cnt++)
@@ -299,19 +373,28 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
         agile::subVector(ext2[cnt], x2[cnt], div2Temp[cnt]);
       }
       AdaptStepSize(div1Temp, div2Temp, b1_gpu);
+      InitSteps(b1_gpu, data_gpu.size());
     }
+    UpdateSteps();
+    AndersonStep(loopCnt);
     
     // compute PD Gap (export,verbose,stopping)
     if ( (verbose && (loopCnt < 10 || (loopCnt % 50 == 0)) ) ||
          ((debug) && (loopCnt % debugstep == 0)) || 
-         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) )
+         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) ||
+         ((params.restart || params.andersonDepth > 0) &&
+          (loopCnt % 20 == 0)) )
     {
       RType pdGap =
             ComputePDGap(x1, x2, y1, y2, z, data_gpu, b1_gpu);
       pdGap=pdGap/N;
       
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
+      CheckPDGap(pdGap);
 
       pdGapExport.push_back( pdGap );
       Log("Normalized Primal-Dual Gap after %d iterations: %.4e\n", loopCnt, pdGap);     
@@ -320,7 +403,11 @@ void TGV2::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
@@ -70,6 +70,11 @@ void TGV2_3D::InitParams()
   params.tau = 1.0 / 3.0;
 
   params.sigmaTauRatio = 1.0;
+  params.diagonalPreconditioning = false;
+  params.variant = PD_STANDARD;
+  params.restart = false;
+  params.andersonDepth = 0;
+  params.coilSubsetSize = 0;
 
   params.dx = 1.0;
   params.dy = 1.0;
@@ -82,6 +87,54 @@ void TGV2_3D::InitParams()
   InitLambda(true);
 }
 
+void TGV2_3D::InitSteps(CVector &b1, unsigned dataSize)
+{
+  if (!params.diagonalPreconditioning)
+  {
+    sigmaY1.assign(3, params.sigma);
+    sigmaY2.assign(6, params.sigma);
+    sigmaZ = params.sigma;
+    tauX2.assign(3, params.tau);
+    return;
+  }
+
+  RType h[3] = { params.dx, params.dy, params.dz };
+  std::vector<RType> rowSums, columnSums;
+  SymmetricGradientSums(params.dx, params.dy, params.dz, rowSums, columnSums);
+
+  RType gradientSum = 0;
+  sigmaY1.resize(3);
+  tauX2.resize(3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    gradientSum += 2.0 / h[cnt];
+    // p = grad x1 - x2
+    sigmaY1[cnt] = 1.0 / (2.0 / h[cnt] + 1.0);
+    tauX2[cnt] = 1.0 / (columnSums[cnt] + 1.0);
+  }
+  sigmaY2.resize(6);
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    sigmaY2[cnt] = 1.0 / rowSums[cnt];
+
+  tauX1 = CVector(width * height * depth);
+  sigmaZ = InitDiagonalDataSteps(b1, dataSize, gradientSum, tauX1);
+}
+
+void TGV2_3D::ScaleSteps(RType factor)
+{
+  PDRecon::ScaleSteps(factor);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    sigmaY1[cnt] *= factor;
+    tauX2[cnt] /= factor;
+  }
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    sigmaY2[cnt] *= factor;
+  sigmaZ *= factor;
+  if (params.diagonalPreconditioning)
+    agile::scale((DType)(1.0 / factor), tauX1, tauX1);
+}
+
 PDParams &TGV2_3D::GetParams()
 {
   return params;
@@ -254,11 +307,27 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
   for (unsigned cnt = 0; cnt < 3; cnt++)
     div2Temp.push_back(CVector(N));
 
-  unsigned loopCnt = 0; 
+  InitSteps(b1_gpu, data_gpu.size());
+
+  ClearState();
+  AddPrimalState(x1, ext1);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    AddPrimalState(x2[cnt], ext2[cnt]);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    AddDualState(y1[cnt]);
+  for (unsigned cnt = 0; cnt < 6; cnt++)
+    AddDualState(y2[cnt]);
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
   // loop
   Log("Starting iteration\n");
   while (loopCnt < params.maxIt)
   {
+    BeginIteration(loopCnt);
+
     // dual ascent step
     // p
     utils::Gradient(ext1, y1Temp, width, height, params.dx, params.dy,
@@ -266,33 +335,37 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::subVector(y1Temp[cnt], ext2[cnt], y1Temp[cnt]);
-      agile::addScaledVector(y1[cnt], params.sigma, y1Temp[cnt], y1[cnt]);
+      agile::addScaledVector(y1[cnt], sigmaY1[cnt], y1Temp[cnt], y1[cnt]);
     }
     // q
     utils::SymmetricGradient(ext2, y2Temp, width, height, params.dx, params.dy,
                              params.dz);
     for (unsigned cnt = 0; cnt < 6; cnt++)
     {
-      agile::addScaledVector(y2[cnt], params.sigma, y2Temp[cnt], y2[cnt]);
+      agile::addScaledVector(y2[cnt], sigmaY2[cnt], y2Temp[cnt], y2[cnt]);
     }
   
-    mrOp->BackwardOperation(ext1, zTemp, b1_gpu);
-    agile::addScaledVector(z, params.sigma, zTemp, z);
+    DataDualStep(ext1, z, zTemp, data_gpu, b1_gpu, sigmaZ);
   
     // Proximal mapping
     utils::ProximalMap3(y1, (DType)1.0 / params.alpha1);
     utils::ProximalMap6(y2, (DType)1.0 / params.alpha0);
 
-    agile::subScaledVector(z, params.sigma, data_gpu, z);
-    agile::scale((DType)(1.0 / (1.0 + params.sigma / params.lambda)), z, z);
+    ExtrapolateDual(sigmaZ);
   
     // primal descent
     // ext1
-    mrOp->ForwardOperation(z, imgTemp, b1_gpu);
+    DataAdjoint(z, imgTemp, b1_gpu);
     utils::Divergence(y1, div1Temp, width, height, depth, params.dx, params.dy,
                       params.dz);
     agile::subVector(imgTemp, div1Temp, div1Temp);
-    agile::subScaledVector(x1, params.tau, div1Temp, ext1);
+    if (params.diagonalPreconditioning)
+    {
+      agile::multiplyElementwise(tauX1, div1Temp, div1Temp);
+      agile::subVector(x1, div1Temp, ext1);
+    }
+    else
+      agile::subScaledVector(x1, params.tau, div1Temp, ext1);
    
     // ext2
     utils::SymmetricDivergence(y2, div2Temp, width, height, depth, params.dx,
@@ -300,8 +373,9 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
       agile::addVector(y1[cnt], div2Temp[cnt], div2Temp[cnt]);
-      agile::addScaledVector(x2[cnt], params.tau, div2Temp[cnt], ext2[cnt]);
+      agile::addScaledVector(x2[cnt], tauX2[cnt], div2Temp[cnt], ext2[cnt]);
     }
+    RestoreDual();
 
     // save x_n+1
     agile::copy(ext1, x1_old);
@@ -309,23 +383,23 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
       agile::copy(ext2[cnt], x2_old[cnt]);
 
     // extra gradient
-    agile::scale((DType)2.0, ext1, ext1);
-    agile::subVector(ext1, x1, ext1);
+    Extrapolate(ext1, x1);
     
     // x_n = x_n+1
     agile::copy(x1_old, x1);
     for (unsigned cnt = 0; cnt < 3; cnt++)
     {
-      agile::scale((DType)2.0, ext2[cnt], ext2[cnt]);
-      agile::subVector(ext2[cnt], x2[cnt], ext2[cnt]);
+      Extrapolate(ext2[cnt], x2[cnt]);
       agile::copy(x2_old[cnt], x2[cnt]);
     }
 
     // abs constrain on x1
     
 
-    // adapt step size
-    if (loopCnt < 10 || (loopCnt % 50 == 0))
+    // adapt step size, preconditioned steps are valid by construction
+    if (!params.diagonalPreconditioning &&
+        (loopCnt < 10 ||
+         (params.variant == PD_STANDARD && loopCnt % 50 == 0)))
     {
       agile::subVector(ext1, x1, div1Temp);
       for (unsigned cnt = 0; cnt < 3; cnt++)
@@ -333,19 +407,28 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
         agile::subVector(ext2[cnt], x2[cnt], div2Temp[cnt]);
       }
       AdaptStepSize(div1Temp, div2Temp, b1_gpu);
+      InitSteps(b1_gpu, data_gpu.size());
     }
+    UpdateSteps();
+    AndersonStep(loopCnt);
     
     // compute PD Gap (export,verbose,stopping)
     if ( (verbose && (loopCnt < 10 || (loopCnt % 50 == 0)) ) ||
          ((debug) && (loopCnt % debugstep == 0)) || 
-         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) )
+         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) ||
+         ((params.restart || params.andersonDepth > 0) &&
+          (loopCnt % 20 == 0)) )
     {
       RType pdGap =
             ComputePDGap(x1, x2, y1, y2, z, data_gpu, b1_gpu);
       pdGap=pdGap/N;
       
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
+      CheckPDGap(pdGap);
 
       pdGapExport.push_back( pdGap );
       Log("Normalized Primal-Dual Gap after %d iterations: %.4e\n", loopCnt, pdGap);     
@@ -353,7 +436,9 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
 
 
     // adapt step size
-    if (loopCnt < 10 || (loopCnt % 50 == 0))
+    if (!params.diagonalPreconditioning &&
+        (loopCnt < 10 ||
+         (params.variant == PD_STANDARD && loopCnt % 50 == 0)))
     {
       CVector temp1(N);
    
@@ -365,6 +450,7 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
         agile::subVector(ext2[cnt], x2[cnt], temp2[cnt]);
       }
       AdaptStepSize(temp1, temp2, b1_gpu);
+      InitSteps(b1_gpu, data_gpu.size());
 
       if (verbose)
       {
@@ -385,7 +471,11 @@ void TGV2_3D::IterativeReconstruction(CVector &data_gpu, CVector &x1,
     loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
@@ -45,6 +45,11 @@ void TV::InitParams()
   params.tau = 1.0 / 3.0;
 
   params.sigmaTauRatio = 1.0;
+  params.diagonalPreconditioning = false;
+  params.variant = PD_STANDARD;
+  params.restart = false;
+  params.andersonDepth = 0;
+  params.coilSubsetSize = 0;
   params.timeSpaceWeight = 5.0;
 
   params.dx = 1.0;
@@ -65,6 +70,38 @@ void TV::InitTempVectors()
   zTemp = CVector(0);  //< resized at runtime
 }
 
+void TV::InitSteps(CVector &b1, unsigned dataSize)
+{
+  if (!params.diagonalPreconditioning)
+  {
+    sigmaY.assign(3, params.sigma);
+    sigmaZ = params.sigma;
+    return;
+  }
+
+  RType h[3] = { params.dx, params.dy, params.dt };
+  RType gradientSum = 0;
+  sigmaY.resize(3);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+  {
+    gradientSum += 2.0 / h[cnt];
+    sigmaY[cnt] = h[cnt] / 2.0;
+  }
+
+  tauX = CVector(width * height * frames);
+  sigmaZ = InitDiagonalDataSteps(b1, dataSize, gradientSum, tauX);
+}
+
+void TV::ScaleSteps(RType factor)
+{
+  PDRecon::ScaleSteps(factor);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    sigmaY[cnt] *= factor;
+  sigmaZ *= factor;
+  if (params.diagonalPreconditioning)
+    agile::scale((DType)(1.0 / factor), tauX, tauX);
+}
+
 PDParams &TV::GetParams()
 {
   return params;
@@ -131,55 +168,79 @@ void TV::IterativeReconstruction(CVector &data_gpu, CVector &x, CVector &b1_gpu)
 
   CVector norm(N);
 
-  unsigned loopCnt = 0; 
+  InitSteps(b1_gpu, data_gpu.size());
+
+  ClearState();
+  AddPrimalState(x, ext);
+  for (unsigned cnt = 0; cnt < 3; cnt++)
+    AddDualState(y[cnt]);
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
   // loop 
   Log("Starting iteration\n"); 
   while ( loopCnt < params.maxIt )
   {
+    BeginIteration(loopCnt);
+
     // dual ascent step
     utils::Gradient(ext, tempGradient, width, height, params.dx, params.dy,
                     params.dt);
-    agile::addScaledVector(y[0], params.sigma, tempGradient[0], y[0]);
-    agile::addScaledVector(y[1], params.sigma, tempGradient[1], y[1]);
-    agile::addScaledVector(y[2], params.sigma, tempGradient[2], y[2]);
+    agile::addScaledVector(y[0], sigmaY[0], tempGradient[0], y[0]);
+    agile::addScaledVector(y[1], sigmaY[1], tempGradient[1], y[1]);
+    agile::addScaledVector(y[2], sigmaY[2], tempGradient[2], y[2]);
 
-    mrOp->BackwardOperation(ext, zTemp, b1_gpu);
-    agile::addScaledVector(z, params.sigma, zTemp, z);
+    DataDualStep(ext, z, zTemp, data_gpu, b1_gpu, sigmaZ);
 
     // Proximal mapping
     utils::ProximalMap3(y, (DType)1.0);
 
-    agile::subScaledVector(z, params.sigma, data_gpu, z);
-    agile::scale((DType)(1.0 / (1.0 + params.sigma / params.lambda)), z, z);
+    ExtrapolateDual(sigmaZ);
+
     // primal descent
-    mrOp->ForwardOperation(z, imgTemp, b1_gpu);
+    DataAdjoint(z, imgTemp, b1_gpu);
     utils::Divergence(y, divTemp, width, height, frames, params.dx, params.dy,
                       params.dt);
     agile::subVector(imgTemp, divTemp, divTemp);
-    agile::subScaledVector(x, params.tau, divTemp, ext);
+    if (params.diagonalPreconditioning)
+    {
+      agile::multiplyElementwise(tauX, divTemp, divTemp);
+      agile::subVector(x, divTemp, ext);
+    }
+    else
+      agile::subScaledVector(x, params.tau, divTemp, ext);
+    RestoreDual();
 
     // save x_n+1
     agile::copy(ext, x_old);
 
     // extra gradient
-    agile::scale((DType)2.0, ext, ext);
-    agile::subVector(ext, x, ext);
+    Extrapolate(ext, x);
 
     // x_n = x_n+1
     agile::copy(x_old, x);
 
-    // adapt step size
-    if (loopCnt < 10 || (loopCnt % 50 == 0))
+    // adapt step size, preconditioned steps are valid by construction
+    if (!params.diagonalPreconditioning &&
+        (loopCnt < 10 ||
+         (params.variant == PD_STANDARD && loopCnt % 50 == 0)))
     {
       CVector temp(N);
       agile::subVector(ext, x, temp);
       AdaptStepSize(temp, b1_gpu);
+      InitSteps(b1_gpu, data_gpu.size());
     }
+    UpdateSteps();
+    AndersonStep(loopCnt);
     
     // compute PD Gap (export,verbose,stopping)
     if ( (verbose && (loopCnt < 10 || (loopCnt % 50 == 0)) ) ||
          ((debug) && (loopCnt % debugstep == 0)) || 
-         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) )
+         ((params.stopPDGap > 0) && (loopCnt % 20 == 0)) ||
+         ((params.restart || params.andersonDepth > 0) &&
+          (loopCnt % 20 == 0)) )
     {
       RType pdGap =
             ComputePDGap(x, y, z, data_gpu, b1_gpu);
@@ -189,13 +250,21 @@ void TV::IterativeReconstruction(CVector &data_gpu, CVector &x, CVector &b1_gpu)
       Log("Normalized Primal-Dual Gap after %d iterations: %.4e\n", loopCnt, pdGap);     
       
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
+      CheckPDGap(pdGap);
     }
 
     loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
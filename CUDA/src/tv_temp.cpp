@@ -118,7 +118,14 @@ void TVTEMP::IterativeReconstruction(CVector &data_gpu, CVector &x, CVector &b1_
 
   CVector norm(N);
 
-  unsigned loopCnt = 0; 
+  ClearState();
+  AddPrimalState(x, ext);
+  AddDualState(y[0]);
+  AddDataDualState(z);
+  AddHistoryState(pdGapExport);
+  InitVariant();
+
+  unsigned loopCnt = ResumeIteration(b1_gpu, data_gpu.size());
   // loop 
   Log("Starting iteration\n"); 
 
@@ -177,13 +184,20 @@ void TVTEMP::IterativeReconstruction(CVector &data_gpu, CVector &x, CVector &b1_
       Log("Normalized Primal-Dual Gap after %d iterations: %.4e\n", loopCnt, pdGap);     
       
       if ( pdGap < params.stopPDGap )
+      {
+        iterations = loopCnt + 1;
         return;
+      }
     }
 
     loopCnt++;
     if (loopCnt % 10 == 0)
       std::cout << "." << std::flush;
+
+    if (CheckpointIteration(loopCnt))
+      break;
   }
+  iterations = loopCnt;
   std::cout << std::endl;
 }
 
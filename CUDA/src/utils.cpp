@@ -8,6 +8,8 @@
 #include "ismrmrd/ismrmrd.h"
 #include "ismrmrd/dataset.h"
 #include <fstream>
+#include <cuda_runtime.h>
+#include "agile/calc/fft.hpp"
 
 // Transcribed from MATLAB ellipke function
 // for a single value
@@ -106,16 +108,34 @@ std::vector<CVector> utils::Gradient_temp(CVector &data_gpu, unsigned width,
 void utils::Gradient2D(CVector &data_gpu, std::vector<CVector> &gradient,
                        unsigned width, unsigned height, DType dx, DType dy)
 {
-  unsigned int N = data_gpu.size();
-  agile::lowlevel::diff3(1, width, height, data_gpu.data(), gradient[0].data(),
-                         N, false);
+  std::vector<CVectorView> gradientView;
+  gradientView.push_back(CVectorView(gradient[0]));
+  gradientView.push_back(CVectorView(gradient[1]));
+  Gradient2D(CVectorView(data_gpu), gradientView, width, height, dx, dy);
+}
+
+void utils::Gradient2D(const CVectorView &data,
+                       const std::vector<CVectorView> &gradient, unsigned width,
+                       unsigned height, DType dx, DType dy)
+{
+  // the difference kernels operate on contiguous memory
+  AGILE_ASSERT(data.IsContiguous() && gradient.size() >= 2 &&
+                   gradient[0].IsContiguous() && gradient[1].IsContiguous(),
+               StandardException::ExceptionMessage(
+                   "Gradient2D: views must be contiguous"));
+
+  unsigned int N = data.size();
+  agile::lowlevel::diff3(1, width, height, data.data(), gradient[0].data(), N,
+                         false);
   if (dx != 1.0)
-    agile::scale((DType)1.0 / dx, gradient[0], gradient[0]);
+    agile::lowlevel::scale((DType)1.0 / dx, gradient[0].data(),
+                           gradient[0].data(), N);
 
-  agile::lowlevel::diff3(2, width, height, data_gpu.data(), gradient[1].data(),
-                         N, false);
+  agile::lowlevel::diff3(2, width, height, data.data(), gradient[1].data(), N,
+                         false);
   if (dy != 1.0)
-    agile::scale((DType)1.0 / dy, gradient[1], gradient[1]);
+    agile::lowlevel::scale((DType)1.0 / dy, gradient[1].data(),
+                           gradient[1].data(), N);
 }
 
 std::vector<CVector> utils::Gradient2D(CVector &data_gpu, unsigned width,
@@ -422,20 +442,38 @@ CVector utils::Divergence_temp(std::vector<CVector> &gradient, unsigned width,
 void utils::Divergence2D(std::vector<CVector> &gradient, CVector &divergence,
                          unsigned width, unsigned height, DType dx, DType dy)
 {
-  unsigned int N = width * height;
+  std::vector<CVectorView> gradientView;
+  gradientView.push_back(CVectorView(gradient[0]));
+  gradientView.push_back(CVectorView(gradient[1]));
+  Divergence2D(gradientView, CVectorView(divergence), width, height, dx, dy);
+}
+
+void utils::Divergence2D(const std::vector<CVectorView> &gradient,
+                         const CVectorView &divergence, unsigned width,
+                         unsigned height, DType dx, DType dy)
+{
+  // the difference kernels operate on contiguous memory
+  AGILE_ASSERT(divergence.IsContiguous() && gradient.size() >= 2 &&
+                   gradient[0].IsContiguous() && gradient[1].IsContiguous(),
+               StandardException::ExceptionMessage(
+                   "Divergence2D: views must be contiguous"));
+
+  unsigned int N = divergence.size();
   CVector temp_gpu(N);
   agile::lowlevel::diff3trans(1, width, height, gradient[0].data(),
                               divergence.data(), N, false);
   if (dx != 1.0)
-    agile::scale((DType)1.0 / dx, divergence, divergence);
+    agile::lowlevel::scale((DType)1.0 / dx, divergence.data(),
+                           divergence.data(), N);
 
   agile::lowlevel::diff3trans(2, width, height, gradient[1].data(),
                               temp_gpu.data(), N, false);
   if (dy != 1.0)
     agile::scale((DType)1.0 / dy, temp_gpu, temp_gpu);
 
-  agile::addVector(temp_gpu, divergence, divergence);
-  agile::scale(-1.0f, divergence, divergence);
+  agile::lowlevel::addVector(temp_gpu.data(), divergence.data(),
+                             divergence.data(), N);
+  agile::lowlevel::scale(-1.0f, divergence.data(), divergence.data(), N);
 }
 
 CVector utils::Divergence2D(std::vector<CVector> &gradient, unsigned width,
@@ -520,7 +558,7 @@ void utils::SymmetricDivergence2D(std::vector<CVector> &gradient,
                                   unsigned width, unsigned height, DType dx,
                                   DType dy)
 {
-  unsigned N = width * height;
+  unsigned N = gradient[0].size();
   CVector temp_gpu(N);
   // first component
   agile::lowlevel::bdiff3trans(1, width, height, gradient[0].data(),
@@ -815,6 +853,115 @@ void utils::SetSubVector(CVector &stride, CVector &full, unsigned index,
                                strideLength);
 }
 
+template <typename TType>
+void CropKSpaceCenterImpl(const TType *full, TType *low, unsigned width,
+                          unsigned height, unsigned lowWidth,
+                          unsigned lowHeight, unsigned count)
+{
+  // the centre of a non-centered k-space is located in its four corners
+  unsigned halfWidth = lowWidth / 2;
+  unsigned halfHeight = lowHeight / 2;
+  size_t pitch = width * sizeof(TType);
+  size_t lowPitch = lowWidth * sizeof(TType);
+  size_t rowBytes = halfWidth * sizeof(TType);
+
+  for (unsigned cnt = 0; cnt < count; cnt++)
+  {
+    const TType *src = full + cnt * width * height;
+    TType *dst = low + cnt * lowWidth * lowHeight;
+    const TType *srcLastRows = src + (height - halfHeight) * width;
+    TType *dstLastRows = dst + halfHeight * lowWidth;
+
+    cudaMemcpy2D(dst, lowPitch, src, pitch, rowBytes, halfHeight,
+                 cudaMemcpyDeviceToDevice);
+    cudaMemcpy2D(dst + halfWidth, lowPitch, src + width - halfWidth, pitch,
+                 rowBytes, halfHeight, cudaMemcpyDeviceToDevice);
+    cudaMemcpy2D(dstLastRows, lowPitch, srcLastRows, pitch, rowBytes,
+                 halfHeight, cudaMemcpyDeviceToDevice);
+    cudaMemcpy2D(dstLastRows + halfWidth, lowPitch,
+                 srcLastRows + width - halfWidth, pitch, rowBytes, halfHeight,
+                 cudaMemcpyDeviceToDevice);
+  }
+}
+
+void utils::CropKSpaceCenter(CVector &full, CVector &low, unsigned width,
+                             unsigned height, unsigned lowWidth,
+                             unsigned lowHeight, unsigned count)
+{
+  CropKSpaceCenterImpl(full.data(), low.data(), width, height, lowWidth,
+                       lowHeight, count);
+}
+
+void utils::CropKSpaceCenter(RVector &full, RVector &low, unsigned width,
+                             unsigned height, unsigned lowWidth,
+                             unsigned lowHeight, unsigned count)
+{
+  CropKSpaceCenterImpl(full.data(), low.data(), width, height, lowWidth,
+                       lowHeight, count);
+}
+
+void utils::UpsampleImages(CVector &low, CVector &full, unsigned lowWidth,
+                           unsigned lowHeight, unsigned width,
+                           unsigned height, unsigned count)
+{
+  unsigned lowN = lowWidth * lowHeight;
+  unsigned N = width * height;
+  agile::FFT<CType> lowFFT(lowHeight, lowWidth);
+  agile::FFT<CType> fullFFT(height, width);
+
+  CVector lowK(lowN);
+  CVector fullK(N);
+  unsigned padOffset =
+      (height / 2 - lowHeight / 2) * width + (width / 2 - lowWidth / 2);
+
+  for (unsigned cnt = 0; cnt < count; cnt++)
+  {
+    lowFFT.CenteredInverse(low, lowK, cnt * lowN, 0);
+
+    // zero-pad centered spectrum
+    fullK.assign(N, 0);
+    cudaMemcpy2D(fullK.data() + padOffset, width * sizeof(CType),
+                 lowK.data(), lowWidth * sizeof(CType),
+                 lowWidth * sizeof(CType), lowHeight,
+                 cudaMemcpyDeviceToDevice);
+
+    fullFFT.CenteredForward(fullK, full, 0, cnt * N);
+  }
+
+  // compensate the normalization of the unitary transforms
+  agile::scale((CType)std::sqrt((RType)N / (RType)lowN), full, full);
+}
+
+void utils::DownsampleImages(CVector &full, CVector &low, unsigned width,
+                             unsigned height, unsigned lowWidth,
+                             unsigned lowHeight, unsigned count)
+{
+  unsigned lowN = lowWidth * lowHeight;
+  unsigned N = width * height;
+  agile::FFT<CType> lowFFT(lowHeight, lowWidth);
+  agile::FFT<CType> fullFFT(height, width);
+
+  CVector lowK(lowN);
+  CVector fullK(N);
+  unsigned cropOffset =
+      (height / 2 - lowHeight / 2) * width + (width / 2 - lowWidth / 2);
+
+  for (unsigned cnt = 0; cnt < count; cnt++)
+  {
+    fullFFT.CenteredInverse(full, fullK, cnt * N, 0);
+
+    // crop centered spectrum
+    cudaMemcpy2D(lowK.data(), lowWidth * sizeof(CType),
+                 fullK.data() + cropOffset, width * sizeof(CType),
+                 lowWidth * sizeof(CType), lowHeight,
+                 cudaMemcpyDeviceToDevice);
+
+    lowFFT.CenteredForward(lowK, low, 0, cnt * lowN);
+  }
+
+  // compensate the normalization of the unitary transforms
+  agile::scale((CType)std::sqrt((RType)lowN / (RType)N), low, low);
+}
 
 bool utils::ReadCflHeader(const std::string &filename, long * dimensions)// Dimension &dim)
 {
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/anderson_acceleration.h"
+
+class Test_AndersonAcceleration : public ::testing::Test
+{
+ public:
+  static const unsigned int N = 24;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    // linear contraction T(u) = a .* u + c with three distinct rates
+    std::vector<CType> aHost(N), cHost(N), solutionHost(N);
+    RType rates[3] = { 0.5, 0.9, 0.99 };
+    for (unsigned cnt = 0; cnt < N; cnt++)
+    {
+      aHost[cnt] = rates[cnt % 3];
+      cHost[cnt] = CType(1.0 + 0.1 * cnt, -0.05 * cnt);
+      solutionHost[cnt] = cHost[cnt] / ((RType)1.0 - aHost[cnt]);
+    }
+    a = CVector(N);
+    a.assignFromHost(aHost.begin(), aHost.end());
+    c = CVector(N);
+    c.assignFromHost(cHost.begin(), cHost.end());
+    solution = CVector(N);
+    solution.assignFromHost(solutionHost.begin(), solutionHost.end());
+  }
+
+  void Apply(CVector &u)
+  {
+    agile::multiplyElementwise(a, u, u);
+    agile::addVector(u, c, u);
+  }
+
+  RType RelativeError(CVector &u)
+  {
+    CVector diff(N);
+    agile::subVector(u, solution, diff);
+    return agile::norm2(diff) / agile::norm2(solution);
+  }
+
+  CVector a;
+  CVector c;
+  CVector solution;
+};
+
+TEST_F(Test_AndersonAcceleration, AcceleratesLinearContraction)
+{
+  CVector u(N), uPlain(N);
+  u.assign(N, 0.0);
+  uPlain.assign(N, 0.0);
+
+  AndersonAcceleration anderson(5, N);
+  unsigned accelerated = 0;
+  for (unsigned it = 0; it < 10; it++)
+  {
+    Apply(uPlain);
+
+    Apply(u);
+    if (anderson.Update(u))
+      accelerated++;
+  }
+
+  EXPECT_GT(accelerated, 0u);
+  EXPECT_EQ(5u, anderson.GetHistorySize());
+  EXPECT_GT(RelativeError(uPlain), 0.5);
+  EXPECT_NEAR(0.0, RelativeError(u), EPS);
+}
+
+TEST_F(Test_AndersonAcceleration, ResetClearsHistory)
+{
+  CVector u(N);
+  u.assign(N, 0.0);
+
+  AndersonAcceleration anderson(3, N);
+  for (unsigned it = 0; it < 5; it++)
+  {
+    Apply(u);
+    anderson.Update(u);
+  }
+  EXPECT_EQ(3u, anderson.GetHistorySize());
+
+  anderson.Reset();
+  EXPECT_EQ(0u, anderson.GetHistorySize());
+
+  // the first two updates after a reset only record the iterates
+  Apply(u);
+  EXPECT_FALSE(anderson.Update(u));
+  Apply(u);
+  EXPECT_FALSE(anderson.Update(u));
+  Apply(u);
+  EXPECT_TRUE(anderson.Update(u));
+}
+
+TEST_F(Test_AndersonAcceleration, InvalidStateSize)
+{
+  CVector u(N + 1);
+  AndersonAcceleration anderson(3, N);
+  EXPECT_THROW(anderson.Update(u), std::invalid_argument);
+}
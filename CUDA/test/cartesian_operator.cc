@@ -322,3 +322,74 @@ TEST_F(Test_CartesianOperator, MaskedBackwardOperation)
   delete cartOp;
 }
 
+
+TEST_F(Test_CartesianOperator, CoilSubset)
+{
+  unsigned int width = 6;
+  unsigned int height = 6;
+  unsigned int coils = 3;
+  unsigned int frames = 2;
+  BaseOperator *cartOp = new CartesianOperator(width, height, coils, frames);
+  EXPECT_TRUE(cartOp->SupportsCoilSubsets());
+
+  unsigned int N = width * height * frames;
+  unsigned int sliceSize = width * height;
+
+  std::vector<CType> x;
+  for (unsigned cnt = 0; cnt < N; cnt++)
+    x.push_back(CType(cnt % 5, 0.5 * (cnt % 3)));
+  CVector x_gpu;
+  x_gpu.assignFromHost(x.begin(), x.end());
+
+  CVector b1_gpu(width * height * coils);
+  b1_gpu.assign(width * height * coils, 1.0f);
+  agile::lowlevel::scale(2.0f, b1_gpu.data() + width * height,
+                         b1_gpu.data() + width * height, width * height);
+
+  CVector zFull = cartOp->BackwardOperation(x_gpu, b1_gpu);
+
+  // only the k-space data of coil 1 is written
+  std::vector<unsigned> subset(1, 1);
+  cartOp->SetCoilSubset(subset);
+  CVector z_gpu(N * coils);
+  z_gpu.assign(N * coils, -1.0f);
+  cartOp->BackwardOperation(x_gpu, z_gpu, b1_gpu);
+
+  std::vector<CType> z, zRef;
+  z_gpu.copyToHost(z);
+  zFull.copyToHost(zRef);
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned coil = 0; coil < coils; coil++)
+      for (unsigned ind = 0; ind < sliceSize; ind++)
+      {
+        unsigned pos = (frame * coils + coil) * sliceSize + ind;
+        if (coil == 1)
+          EXPECT_NEAR(0.0, std::abs(zRef[pos] - z[pos]), EPS);
+        else
+          EXPECT_NEAR(0.0, std::abs(CType(-1.0f) - z[pos]), EPS);
+      }
+
+  // the adjoint only sums the subset
+  CVector img(N), imgRef(N);
+  cartOp->ForwardOperation(zFull, img, b1_gpu);
+
+  std::vector<CType> zSubset(zRef.size(), CType(0));
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned ind = 0; ind < sliceSize; ind++)
+    {
+      unsigned pos = (frame * coils + 1) * sliceSize + ind;
+      zSubset[pos] = zRef[pos];
+    }
+  CVector zSubset_gpu;
+  zSubset_gpu.assignFromHost(zSubset.begin(), zSubset.end());
+
+  cartOp->SetCoilSubset(std::vector<unsigned>());
+  cartOp->ForwardOperation(zSubset_gpu, imgRef, b1_gpu);
+
+  agile::subVector(img, imgRef, img);
+  EXPECT_NEAR(0.0, agile::norm2(img), EPS);
+
+  subset[0] = coils;
+  EXPECT_THROW(cartOp->SetCoilSubset(subset), std::invalid_argument);
+  delete cartOp;
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/coil_compression.h"
+
+class Test_CoilCompression : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 8;
+  static const unsigned int height = 6;
+  static const unsigned int coils = 4;
+  static const unsigned int frames = 2;
+  static const unsigned int N = width * height;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    // all coils are linear combinations of two source signals,
+    // i.e. the data has rank 2 in the coil dimension
+    for (unsigned frame = 0; frame < frames; frame++)
+      for (unsigned coil = 0; coil < coils; coil++)
+        for (unsigned cnt = 0; cnt < N; cnt++)
+        {
+          CType s1(std::cos(0.3 * cnt + frame), std::sin(0.1 * cnt));
+          CType s2(0.5 * cnt / N, std::cos(0.7 * cnt * frame));
+          matrix_data.push_back(CType(1.0 + coil, 0.5) * s1 +
+                                CType(0.2, 1.0 * coil) * s2);
+        }
+
+    kdata = CVector(N * coils * frames);
+    kdata.assignFromHost(matrix_data.begin(), matrix_data.end());
+  }
+
+  std::vector<CType> matrix_data;
+  CVector kdata;
+};
+
+TEST_F(Test_CoilCompression, HermitianEigen)
+{
+  // column major hermitian 3x3 matrix
+  std::vector<CType> matrix(9);
+  matrix[0] = 4.0;
+  matrix[4] = 3.0;
+  matrix[8] = 1.0;
+  matrix[3] = CType(1.0, 1.0);
+  matrix[1] = std::conj(matrix[3]);
+  matrix[6] = CType(0.0, -0.5);
+  matrix[2] = std::conj(matrix[6]);
+  matrix[7] = CType(0.25, 0.0);
+  matrix[5] = std::conj(matrix[7]);
+
+  std::vector<RType> eigenvalues;
+  std::vector<CType> eigenvectors;
+  CoilCompression::HermitianEigen(matrix, 3, eigenvalues, eigenvectors);
+
+  ASSERT_EQ(3u, eigenvalues.size());
+  EXPECT_GE(eigenvalues[0], eigenvalues[1]);
+  EXPECT_GE(eigenvalues[1], eigenvalues[2]);
+  EXPECT_NEAR(8.0, eigenvalues[0] + eigenvalues[1] + eigenvalues[2], EPS);
+
+  // A v = lambda v
+  for (unsigned k = 0; k < 3; k++)
+    for (unsigned i = 0; i < 3; i++)
+    {
+      CType av = 0;
+      for (unsigned j = 0; j < 3; j++)
+        av += matrix[i + j * 3] * eigenvectors[j + k * 3];
+      EXPECT_NEAR(0.0, std::abs(av - eigenvalues[k] * eigenvectors[i + k * 3]),
+                  EPS);
+    }
+}
+
+TEST_F(Test_CoilCompression, CompressRankDeficientData)
+{
+  CoilCompressionParams params;
+  params.energyThreshold = 0.9999;
+  CoilCompression coilCompression(params);
+
+  Dimension dims(width, height, 1, width, height, 1, coils, frames);
+  coilCompression.Compress(kdata, dims, true);
+
+  EXPECT_EQ(2u, coilCompression.GetVirtualCoils());
+  EXPECT_EQ(2u, dims.coils);
+  EXPECT_EQ(N * 2 * frames, kdata.size());
+  EXPECT_NEAR(0.0, coilCompression.GetCompressionError(), EPS);
+  EXPECT_NEAR(2.0, coilCompression.GetEstimatedSpeedup(), EPS);
+
+  // compression is unitary on the signal subspace
+  RType energy = 0;
+  for (unsigned cnt = 0; cnt < matrix_data.size(); cnt++)
+    energy += std::norm(matrix_data[cnt]);
+  std::vector<CType> compressed;
+  kdata.copyToHost(compressed);
+  RType compressedEnergy = 0;
+  for (unsigned cnt = 0; cnt < compressed.size(); cnt++)
+    compressedEnergy += std::norm(compressed[cnt]);
+  EXPECT_NEAR(1.0, compressedEnergy / energy, EPS);
+}
+
+TEST_F(Test_CoilCompression, GeometricCompressionPreservesEnergy)
+{
+  CoilCompressionParams params;
+  params.virtualCoils = 2;
+  params.geometric = true;
+  CoilCompression coilCompression(params);
+
+  Dimension dims(width, height, 1, width, height, 1, coils, frames);
+  coilCompression.Compress(kdata, dims, true);
+
+  EXPECT_EQ(2u, dims.coils);
+  EXPECT_EQ(N * 2 * frames, kdata.size());
+  EXPECT_NEAR(0.0, coilCompression.GetCompressionError(), EPS);
+
+  RType energy = 0;
+  for (unsigned cnt = 0; cnt < matrix_data.size(); cnt++)
+    energy += std::norm(matrix_data[cnt]);
+  std::vector<CType> compressed;
+  kdata.copyToHost(compressed);
+  RType compressedEnergy = 0;
+  for (unsigned cnt = 0; cnt < compressed.size(); cnt++)
+    compressedEnergy += std::norm(compressed[cnt]);
+  EXPECT_NEAR(1.0, compressedEnergy / energy, EPS);
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 
 #include "../include/types.h"
 #include "./test_utils.h"
@@ -255,6 +256,85 @@ TEST_F(Test_CoilConstruction, InitialIndex)
   EXPECT_EQ(2u, maxInd);
 }
 
+TEST_F(Test_CoilConstruction, CoilCorrelationAndOrder)
+{
+  unsigned N = width * height;
+
+  CVector u(N);
+  CVector crec(N * coils);
+  u.assign(u.size(), 0);
+  crec.assign(crec.size(), 0);
+
+  coilConstruction->TimeAveragedReconstruction(kdata, u, crec);
+
+  std::vector<RType> correlation;
+  coilConstruction->ComputeCoilCorrelation(crec, correlation);
+  ASSERT_EQ(coils * coils, correlation.size());
+
+  std::vector<CType> crecHost(N * coils);
+  crec.copyToHost(crecHost);
+  for (unsigned i = 0; i < coils; i++)
+    for (unsigned j = 0; j < coils; j++)
+    {
+      RType sum = 0;
+      for (unsigned cnt = 0; cnt < N; cnt++)
+        sum += std::abs(crecHost[i * N + cnt]) *
+               std::abs(crecHost[j * N + cnt]);
+      EXPECT_NEAR(1.0, correlation[i + j * coils] / sum, EPS);
+    }
+
+  std::vector<unsigned> order = coilConstruction->FindCoilOrder(crec);
+  ASSERT_EQ(coils, order.size());
+  EXPECT_EQ(coilConstruction->FindMaximumSum(crec), order[0]);
+  std::vector<unsigned> sorted(order);
+  std::sort(sorted.begin(), sorted.end());
+  for (unsigned cnt = 0; cnt < coils; cnt++)
+    EXPECT_EQ(cnt, sorted[cnt]);
+}
+
+TEST_F(Test_CoilConstruction, BatchedB1PhaseReconEqualsSingleCoil)
+{
+  unsigned N = width * height;
+
+  CVector u(N);
+  CVector crec(N * coils);
+  u.assign(u.size(), 0);
+  crec.assign(crec.size(), 0);
+
+  coilConstruction->TimeAveragedReconstruction(kdata, u, crec);
+
+  // coil-wise weighted images
+  CVector uBatch(N * coils);
+  for (unsigned cnt = 0; cnt < coils; cnt++)
+  {
+    utils::SetSubVector(u, uBatch, cnt, N);
+    agile::lowlevel::scale((CType)(1.0 + cnt), uBatch.data() + cnt * N,
+                           uBatch.data() + cnt * N, N);
+  }
+
+  CVector x1(N * coils);
+  coilConstruction->B1PhaseRecon(uBatch, crec, x1, coils, 500, 2);
+  std::vector<CType> x1Host(N * coils);
+  x1.copyToHost(x1Host);
+
+  CVector uSingle(N), crecSingle(N), x1Single(N);
+  for (unsigned cnt = 0; cnt < coils; cnt++)
+  {
+    utils::GetSubVector(uBatch, uSingle, cnt, N);
+    utils::GetSubVector(crec, crecSingle, cnt, N);
+    coilConstruction->B1PhaseRecon(uSingle, crecSingle, x1Single, 1, 500, 2);
+
+    std::vector<CType> x1SingleHost(N);
+    x1Single.copyToHost(x1SingleHost);
+    for (unsigned ind = 0; ind < N; ind++)
+    {
+      CType phase = std::polar(1.0f, std::arg(x1Host[cnt * N + ind]));
+      CType phaseSingle = std::polar(1.0f, std::arg(x1SingleHost[ind]));
+      EXPECT_NEAR(0.0, std::abs(phase - phaseSingle), EPS);
+    }
+  }
+}
+
 TEST_F(Test_CoilConstruction, UReconWithTGV2Regularization)
 {
   communicator_type com;
@@ -404,6 +484,126 @@ TEST_F(Test_CoilConstruction, U1B1ComputationLoop)
   EXPECT_NEAR(-0.06341, std::real(uHost[XYZ2Lin(4, 4, 2, width, height)]), EPS);
 }
 
+TEST_F(Test_CoilConstruction, WarmStartedLoopMatchesColdStart)
+{
+  communicator_type com;
+  com.allocateGPU();
+
+  CoilConstructionParams &params =
+      static_cast<CoilConstructionParams &>(coilConstruction->GetParams());
+
+  CVector u(N * coils), uWarm(N * coils);
+  u.assign(N * coils, 0.0);
+  uWarm.assign(N * coils, 0.0);
+  CVector b1(N * coils), b1Warm(N * coils);
+  b1.assign(N * coils, 0.0);
+  b1Warm.assign(N * coils, 0.0);
+
+  params.uWarmNrIt = 0;
+  coilConstruction->PerformCoilConstruction(kdata, u, b1, com);
+
+  params.uWarmNrIt = 30;
+  coilConstruction->PerformCoilConstruction(kdata, uWarm, b1Warm, com);
+
+  // UTGV2 iterations of all greedy steps
+  unsigned batchSize = std::max(params.b1BatchSize, 1u);
+  unsigned steps = 1 + (coils - 1 + batchSize - 1) / batchSize;
+  unsigned coldIterations = steps * params.uNrIt;
+  unsigned warmIterations = params.uNrIt + (steps - 1) * params.uWarmNrIt;
+  RecordProperty("coldIterations", coldIterations);
+  RecordProperty("warmIterations", warmIterations);
+  std::cout << "UTGV2 iterations cold: " << coldIterations
+            << " warm: " << warmIterations << std::endl;
+  EXPECT_LT(warmIterations, coldIterations);
+
+  agile::subVector(u, uWarm, uWarm);
+  EXPECT_NEAR(0.0, agile::norm2(uWarm) / agile::norm2(u), 1E-2);
+  agile::subVector(b1, b1Warm, b1Warm);
+  EXPECT_NEAR(0.0, agile::norm2(b1Warm) / agile::norm2(b1), 1E-2);
+}
+
+TEST(Test_CoilConstruction_LowRes, LowResolutionMatchesFullResolution)
+{
+  communicator_type com;
+  com.allocateGPU();
+
+  unsigned width = 32, height = 32, coils = 4, frames = 2;
+  unsigned N = width * height;
+
+  // smooth object and smooth coil sensitivities
+  std::vector<CType> imgHost(N * frames), b1Host(N * coils);
+  std::vector<bool> support(N);
+  for (unsigned y = 0; y < height; y++)
+    for (unsigned x = 0; x < width; x++)
+    {
+      RType dx = x - width / 2.0, dy = y - height / 2.0;
+      RType r2 = (dx * dx + dy * dy) / (width * width / 9.0);
+      support[x + y * width] = r2 < 0.8;
+      for (unsigned frame = 0; frame < frames; frame++)
+        imgHost[x + y * width + frame * N] =
+            CType(r2 < 1 ? 1.0 - 0.5 * r2 : 0.0, 0.0);
+      for (unsigned coil = 0; coil < coils; coil++)
+      {
+        RType cx = (coil % 2) * width, cy = (coil / 2) * height;
+        RType d2 = ((x - cx) * (x - cx) + (y - cy) * (y - cy)) /
+                   (RType)(2 * N);
+        b1Host[x + y * width + coil * N] =
+            std::exp(-d2) * CType(std::cos(0.5 * coil), std::sin(0.5 * coil));
+      }
+    }
+  CVector img(imgHost.size()), b1True(b1Host.size());
+  img.assignFromHost(imgHost.begin(), imgHost.end());
+  b1True.assignFromHost(b1Host.begin(), b1Host.end());
+
+  RVector mask(N * frames);
+  mask.assign(mask.size(), 1.0);
+  CartesianOperator *cartOp =
+      new CartesianOperator(width, height, coils, frames, mask, false);
+  CVector kdata(N * coils * frames);
+  cartOp->BackwardOperation(img, kdata, b1True);
+
+  // full resolution reference
+  CartesianCoilConstruction coilConstruction(width, height, coils, frames,
+                                             cartOp);
+  CVector u(N * coils), b1(N * coils);
+  u.assign(u.size(), 0.0);
+  b1.assign(b1.size(), 0.0);
+  coilConstruction.PerformCoilConstruction(kdata, u, b1, com);
+
+  CoilConstructionParams params =
+      static_cast<CoilConstructionParams &>(coilConstruction.GetParams());
+  params.lowResFactor = 2;
+  CVector uLow(N * coils), b1Low(N * coils);
+  CartesianCoilConstruction::PerformLowResCoilConstruction(
+      width, height, coils, frames, params, kdata, mask, uLow, b1Low, com);
+
+  // relative error inside the object, b1 is defined up to a common phase
+  // per pixel
+  std::vector<CType> b1Full, b1Upsampled;
+  b1.copyToHost(b1Full);
+  b1Low.copyToHost(b1Upsampled);
+  RType error = 0, norm = 0;
+  for (unsigned cnt = 0; cnt < N; cnt++)
+  {
+    if (!support[cnt])
+      continue;
+    CType inner(0);
+    for (unsigned coil = 0; coil < coils; coil++)
+      inner += std::conj(b1Full[cnt + coil * N]) * b1Upsampled[cnt + coil * N];
+    CType phase = std::abs(inner) > 0 ? inner / std::abs(inner) : CType(1);
+    for (unsigned coil = 0; coil < coils; coil++)
+    {
+      error += std::norm(b1Upsampled[cnt + coil * N] * std::conj(phase) -
+                         b1Full[cnt + coil * N]);
+      norm += std::norm(b1Full[cnt + coil * N]);
+    }
+  }
+  std::cout << "Relative b1 error low/full resolution: "
+            << std::sqrt(error / norm) << std::endl;
+  EXPECT_LT(std::sqrt(error / norm), 0.1);
+  delete cartOp;
+}
+
 TEST(Test_CoilConstruction_Real, DISABLED_H1Regularization)
 {
   communicator_type com;
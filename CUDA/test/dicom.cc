@@ -4,6 +4,9 @@
 #include <map>
 #include <algorithm>
 #include <functional>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 #include "./test_utils.h"
 #include "../include/types.h"
@@ -13,8 +16,10 @@
 #include "agile/calc/fft.hpp"
 #include "../include/raw_data_preparation.h"
 #include "../include/dicom_reader.h"
+#include "../include/siemens_vd11_reader.h"
 #include "../include/cartesian_coil_construction.h"
 #include "../include/noncartesian_coil_construction.h"
+#include "../include/utils.h"
 
 class Test_Dicom : public ::testing::Test
 {
@@ -95,6 +100,42 @@ TEST_F(Test_Dicom, ReadFileAndGenerateMeasDat)
   EXPECT_EQ(length, 4128000u);
 }
 
+TEST_F(Test_Dicom, ExtractRawDataInMemory)
+{
+  std::string filename("../test/data/dicom/test.dcm");
+  op.kdataFilename = filename;
+  DicomReader reader(op);
+
+  std::vector<char> rawData;
+  reader.ExtractRawData(rawData);
+  ASSERT_EQ(377856u, rawData.size());
+
+  // identical to the meas.dat written by agile
+  agile::DICOM dicom;
+  std::string measdatFile("../test/data/dicom/test_in_memory.dat");
+  std::ofstream measdat(measdatFile.c_str());
+  unsigned long length;
+  Uint8 *pdata = NULL;
+  EXPECT_EQ(dicom.readdicom(filename, measdat, length, pdata), 0);
+  measdat.close();
+  ASSERT_EQ(rawData.size(), length);
+
+  std::ifstream written(measdatFile.c_str(), std::ios::binary);
+  std::vector<char> measdatData((std::istreambuf_iterator<char>(written)),
+                                std::istreambuf_iterator<char>());
+  written.close();
+  EXPECT_TRUE(measdatData == rawData);
+
+  boost::filesystem::remove(measdatFile);
+}
+
+TEST_F(Test_Dicom, GenerateMeasDatWithoutRawDataThrows)
+{
+  op.kdataFilename = "../test/data/dicom/missing.dcm";
+  DicomReader reader(op);
+  EXPECT_THROW(reader.GenerateMeasDat("missing.dat"), std::runtime_error);
+}
+
 TEST_F(Test_Dicom, ReadMeasDatHeader)
 {
   std::string measdat("../test/data/dicom/test_large.dat");
@@ -255,6 +296,115 @@ TEST_F(Test_Dicom, FindNormalizationFactor)
   EXPECT_EQ(28.5, rdp.FindNormalizationFactor(data));
 }
 
+TEST_F(Test_Dicom, FindNormalizationFactorMaximumNotFirst)
+{
+  RawDataPreparation rdp;
+  std::vector<RType> data;
+  unsigned cnt = 0;
+  while (cnt < 30)
+    data.push_back(++cnt);
+
+  // elements preceding the first maximum are not considered
+  EXPECT_EQ(30, rdp.FindNormalizationFactor(data));
+
+  data.assign(10, 0.0);
+  EXPECT_THROW(rdp.FindNormalizationFactor(data), std::runtime_error);
+}
+
+TEST_F(Test_Dicom, NonCartNormalizationAgreesWithCoilCombinedFactor)
+{
+  unsigned width = 16, height = 16, coils = 4, frames = 2;
+  unsigned nFE = 2 * width, spokesPerFrame = 16;
+  unsigned nSpokes = spokesPerFrame * frames;
+  unsigned nSamplesPerFrame = nFE * spokesPerFrame;
+  unsigned N = width * height;
+
+  // golden angle radial trajectory and ramp density compensation
+  std::vector<RType> trajHost(2 * nSpokes * nFE), densHost(nSpokes * nFE);
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned spoke = 0; spoke < spokesPerFrame; spoke++)
+      for (unsigned cnt = 0; cnt < nFE; cnt++)
+      {
+        RType angle = (frame * spokesPerFrame + spoke) * M_PI * 0.618034;
+        RType radius = (RType)cnt / nFE - 0.5;
+        unsigned ind = frame * 2 * nSamplesPerFrame + spoke * nFE + cnt;
+        trajHost[ind] = radius * std::cos(angle);
+        trajHost[ind + nSamplesPerFrame] = radius * std::sin(angle);
+        densHost[frame * nSamplesPerFrame + spoke * nFE + cnt] =
+            std::abs(radius) + 1.0 / nFE;
+      }
+  RVector traj(trajHost.size()), dens(densHost.size());
+  traj.assignFromHost(trajHost.begin(), trajHost.end());
+  dens.assignFromHost(densHost.begin(), densHost.end());
+
+  // smooth object and smooth coil sensitivities
+  std::vector<CType> imgHost(N * frames), b1Host(N * coils);
+  for (unsigned y = 0; y < height; y++)
+    for (unsigned x = 0; x < width; x++)
+    {
+      RType dx = x - width / 2.0, dy = y - height / 2.0;
+      RType r2 = (dx * dx + dy * dy) / (width * width / 9.0);
+      for (unsigned frame = 0; frame < frames; frame++)
+        imgHost[x + y * width + frame * N] =
+            CType(r2 < 1 ? 1.0 - 0.5 * r2 : 0.0, 0.0);
+      for (unsigned coil = 0; coil < coils; coil++)
+      {
+        RType cx = (coil % 2) * width, cy = (coil / 2) * height;
+        RType d2 = ((x - cx) * (x - cx) + (y - cy) * (y - cy)) /
+                   (RType)(width * height);
+        b1Host[x + y * width + coil * N] =
+            std::exp(-d2) * CType(std::cos(0.3 * coil), std::sin(0.3 * coil));
+      }
+    }
+  CVector img(imgHost.size()), b1(b1Host.size());
+  img.assignFromHost(imgHost.begin(), imgHost.end());
+  b1.assignFromHost(b1Host.begin(), b1Host.end());
+
+  NoncartesianOperator nonCartOp(width, height, coils, frames, nSpokes, nFE,
+                                 spokesPerFrame, traj, dens);
+  CVector kdata(nSpokes * nFE * coils);
+  nonCartOp.BackwardOperation(img, kdata, b1);
+
+  NoncartesianCoilConstruction coilConstruction(width, height, coils, frames,
+                                                &nonCartOp);
+
+  // previous definition: time averaged image combined with the estimated
+  // coil sensitivities
+  CVector u(N * coils), b1Est(N * coils);
+  coilConstruction.PerformCoilConstruction(kdata, u, b1Est, com);
+  CVector u0(N), crec(N * coils), crecTemp(N), b1Temp(N);
+  u0.assign(N, 0);
+  crec.assign(crec.size(), 0);
+  coilConstruction.TimeAveragedReconstruction(kdata, u0, crec, false);
+  u0.assign(N, 0);
+  for (unsigned coil = 0; coil < coils; coil++)
+  {
+    utils::GetSubVector(crec, crecTemp, coil, N);
+    utils::GetSubVector(b1Est, b1Temp, coil, N);
+    agile::multiplyConjElementwise(b1Temp, crecTemp, crecTemp);
+    agile::addVector(u0, crecTemp, u0);
+  }
+  RVector u0Abs(N);
+  agile::absVector(u0, u0Abs);
+  std::vector<RType> u0Host;
+  u0Abs.copyToHost(u0Host);
+
+  RawDataPreparation rdp;
+  RType previous = 255.0 * frames / rdp.FindNormalizationFactor(u0Host);
+
+  // sum-of-squares based datanorm
+  Dimension dims(width, height, 1, nFE, spokesPerFrame, 1, coils, frames);
+  CType datanorm;
+  rdp.NormalizeNonCartData(kdata, dims, &coilConstruction, datanorm);
+
+  std::cout << "datanorm coil combined: " << previous
+            << ", sum-of-squares: " << std::real(datanorm) << std::endl;
+
+  // both images coincide for exact sensitivities, the factors agree within
+  // 10 percent for estimated ones
+  EXPECT_NEAR(1.0, std::real(datanorm) / previous, 0.1);
+}
+
 TEST_F(Test_Dicom, DISABLED_ReadMeasDatCompleteDataRemoveOSAndNormalize)
 {
   std::string measdat("../test/data/dicom/test_large.dat");
@@ -347,3 +497,119 @@ TEST_F(Test_Dicom, DISABLED_ReadMeasDatCompleteDataRemoveOSNormalizeAndChop)
   agile::writeVectorFile(output, raw);
 }
 
+
+void WriteVD11Scan(std::ofstream &out, unsigned evalInfoMask,
+                   unsigned short samples, unsigned short channels,
+                   unsigned short line, unsigned short phase,
+                   unsigned short slice = 0, unsigned short centreLine = 2)
+{
+  std::vector<char> mdh(192, 0);
+  unsigned dmaLength = 192 + channels * (32 + samples * sizeof(CType));
+  unsigned short centreColumn = samples / 2;
+  std::memcpy(&mdh[0], &dmaLength, sizeof(unsigned));
+  std::memcpy(&mdh[40], &evalInfoMask, sizeof(unsigned));
+  std::memcpy(&mdh[48], &samples, sizeof(unsigned short));
+  std::memcpy(&mdh[50], &channels, sizeof(unsigned short));
+  std::memcpy(&mdh[52], &line, sizeof(unsigned short));
+  std::memcpy(&mdh[56], &slice, sizeof(unsigned short));
+  std::memcpy(&mdh[62], &phase, sizeof(unsigned short));
+  std::memcpy(&mdh[84], &centreColumn, sizeof(unsigned short));
+  std::memcpy(&mdh[96], &centreLine, sizeof(unsigned short));
+  out.write(&mdh[0], mdh.size());
+
+  std::vector<char> channelHeader(32, 0);
+  for (unsigned c = 0; c < channels; c++)
+  {
+    out.write(&channelHeader[0], channelHeader.size());
+    for (unsigned s = 0; s < samples; s++)
+    {
+      CType value(s, line * 10 + c + 100 * phase);
+      out.write(reinterpret_cast<const char *>(&value), sizeof(CType));
+    }
+  }
+}
+
+TEST_F(Test_Dicom, ReadSyntheticMeasDatRandomAccess)
+{
+  std::string measdat("vd11_test.dat");
+  unsigned short samples = 8, channels = 3, lines = 4, phases = 2;
+  {
+    std::ofstream out(measdat.c_str(), std::ios::binary);
+    for (unsigned short phase = 0; phase < phases; phase++)
+      for (unsigned short line = 0; line < lines; line++)
+        WriteVD11Scan(out, (line == 1) ? (1u << 24) : (1u << 3), samples,
+                      channels, line, phase);
+    // acquisition end
+    WriteVD11Scan(out, 1u, 0, 0, 0, 0);
+  }
+
+  op.kdataFilename = measdat;
+  SiemensVD11Reader reader(op);
+  reader.LoadRawData();
+
+  Dimension dims = reader.GetRawDataDimensions();
+  EXPECT_EQ(samples, dims.width);
+  EXPECT_EQ(lines, dims.height);
+  EXPECT_EQ(channels, dims.coils);
+  EXPECT_EQ(phases, dims.frames);
+  EXPECT_EQ((unsigned)(lines * phases), reader.GetNumberOfAcquisitions());
+  EXPECT_EQ(samples / 2u, reader.GetCenterColumn());
+  EXPECT_EQ(2u, reader.GetCenterRow());
+
+  // random access in reverse order
+  for (int index = lines * phases - 1; index >= 0; index--)
+  {
+    Acquisition acq = reader.GetAcquisition(index);
+    EXPECT_EQ(index % lines, (int)acq.line);
+    EXPECT_EQ(index / lines, (int)acq.phase);
+    EXPECT_EQ(channels, acq.coils);
+    for (unsigned c = 0; c < channels; c++)
+    {
+      // reflected lines are reversed
+      unsigned s = (acq.line == 1) ? samples - 1 : 0;
+      EXPECT_EQ(CType(s, acq.line * 10 + c + 100 * acq.phase),
+                acq.coilData(c)[0]);
+    }
+  }
+}
+
+TEST_F(Test_Dicom, ReadSyntheticMeasDatNoiseAndNonImagingScans)
+{
+  std::string measdat("vd11_test_noise.dat");
+  unsigned short samples = 8, channels = 2, lines = 3, slices = 2;
+  {
+    std::ofstream out(measdat.c_str(), std::ios::binary);
+    // noise adjust scan with different length and without k-space centre
+    WriteVD11Scan(out, 1u << 25, samples / 2, channels, 0, 0, 0, 0);
+    // sync data and phase correction scans are not indexed
+    WriteVD11Scan(out, 1u << 5, 0, 0, 0, 0);
+    WriteVD11Scan(out, 1u << 21, samples, channels, 0, 0);
+    for (unsigned short slice = 0; slice < slices; slice++)
+      for (unsigned short line = 0; line < lines; line++)
+        WriteVD11Scan(out, 1u << 3, samples, channels, line, 0, slice);
+    WriteVD11Scan(out, 1u, 0, 0, 0, 0);
+  }
+
+  op.kdataFilename = measdat;
+  SiemensVD11Reader reader(op);
+  reader.LoadRawData();
+
+  // centre and dimensions are taken from the imaging scans
+  Dimension dims = reader.GetRawDataDimensions();
+  EXPECT_EQ(samples, dims.width);
+  EXPECT_EQ(lines, dims.height);
+  EXPECT_EQ(1u, dims.frames);
+  EXPECT_EQ(samples / 2u, reader.GetCenterColumn());
+  EXPECT_EQ(2u, reader.GetCenterRow());
+  ASSERT_EQ((unsigned)(1 + lines * slices), reader.GetNumberOfAcquisitions());
+
+  std::vector<AcquisitionHeader> headers;
+  reader.GetAcquisitionHeaders(headers);
+  EXPECT_TRUE(headers[0].isNoiseMeasurement);
+  for (unsigned index = 1; index < headers.size(); index++)
+  {
+    EXPECT_FALSE(headers[index].isNoiseMeasurement);
+    EXPECT_EQ((index - 1) / lines, headers[index].slice);
+    EXPECT_EQ((index - 1) % lines, headers[index].line);
+  }
+}
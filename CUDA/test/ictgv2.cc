@@ -11,6 +11,7 @@
 #include "agile/io/file.hpp"
 
 #include "./test_utils.h"
+#include "./pd_test_problem.h"
 #include "../include/types.h"
 #include "../include/ictgv2.h"
 #include "../include/utils.h"
@@ -680,6 +681,30 @@ TEST_F(Test_ICTGV, Iteration)
   delete cartOp;
 }
 
+class Test_ICTGVSolver : public PDTestProblem
+{
+};
+
+TEST_F(Test_ICTGVSolver, PDGapStopping)
+{
+  ICTGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 2000;
+  CVector x1 = Reconstruct(solver);
+
+  // gap from the by-products of the iteration
+  ICTGV2 stoppedSolver(width, height, coils, frames, cartOp);
+  stoppedSolver.GetParams().maxIt = 2000;
+  stoppedSolver.GetParams().stopPDGap = 1E-2;
+  stoppedSolver.SetDebug(true, 20);
+  CVector x1Stopped = Reconstruct(stoppedSolver);
+
+  EXPECT_LT(stoppedSolver.GetIterations(), 2000u);
+  EXPECT_EQ(1u, stoppedSolver.GetIterations() % 20);
+  // by-product gap equals ComputePDGap at the same iterate (ext, y_n+1)
+  EXPECT_LT(stoppedSolver.GetPDGapDeviation(), 1E-3);
+  EXPECT_NEAR(0.0, RelativeDifference(x1Stopped, x1), 5E-2);
+}
+
 TEST(Test_ICTGV_Real, DISABLED_Iteration)
 {
   agile::GPUEnvironment::allocateGPU(0);
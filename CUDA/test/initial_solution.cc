@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/cartesian_operator.h"
+#include "../include/initial_solution.h"
+
+class Test_InitialSolution : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 8;
+  static const unsigned int height = 8;
+  static const unsigned int coils = 2;
+  static const unsigned int frames = 4;
+  static const unsigned int N = width * height;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    // normalized sensitivities, sum |b1|^2 = 1
+    std::vector<CType> b1Host;
+    for (unsigned cnt = 0; cnt < N * coils; cnt++)
+      b1Host.push_back(cnt < N ? CType(0.6, 0.0) : CType(0.0, 0.8));
+    b1 = CVector(N * coils);
+    b1.assignFromHost(b1Host.begin(), b1Host.end());
+
+    for (unsigned cnt = 0; cnt < N * frames; cnt++)
+      xTrueHost.push_back(
+          CType(1.0 + std::cos(0.3 * cnt), 0.5 * std::sin(0.7 * cnt)));
+    xTrue = CVector(N * frames);
+    xTrue.assignFromHost(xTrueHost.begin(), xTrueHost.end());
+
+    // time averaged image
+    std::vector<CType> u0Host(N, CType(0));
+    for (unsigned cnt = 0; cnt < N * frames; cnt++)
+      u0Host[cnt % N] += xTrueHost[cnt] / (RType)frames;
+    u0 = CVector(N);
+    u0.assignFromHost(u0Host.begin(), u0Host.end());
+  }
+
+  void GenerateData(BaseOperator *op)
+  {
+    kdata = CVector(N * coils * frames);
+    op->BackwardOperation(xTrue, kdata, b1);
+  }
+
+  RType RelativeError(CVector &x)
+  {
+    CVector diff(N * frames);
+    agile::subVector(x, xTrue, diff);
+    return agile::norm2(diff) / agile::norm2(xTrue);
+  }
+
+  std::vector<CType> xTrueHost;
+  CVector xTrue;
+  CVector u0;
+  CVector b1;
+  CVector kdata;
+};
+
+TEST_F(Test_InitialSolution, U0IsReplicated)
+{
+  BaseOperator *cartOp = new CartesianOperator(width, height, coils, frames);
+  GenerateData(cartOp);
+
+  InitialSolution init(N, frames, InitialSolutionParams(), cartOp);
+  CVector x(0);
+  init.Compute(kdata, u0, b1, x);
+  ASSERT_EQ(N * frames, x.size());
+
+  std::vector<CType> xHost, u0Host;
+  x.copyToHost(xHost);
+  u0.copyToHost(u0Host);
+  for (unsigned cnt = 0; cnt < N * frames; cnt++)
+    EXPECT_NEAR(0.0, std::abs(u0Host[cnt % N] - xHost[cnt]), EPS);
+  EXPECT_EQ(0u, init.GetIterations());
+  delete cartOp;
+}
+
+TEST_F(Test_InitialSolution, ViewSharingOfFullySampledFrames)
+{
+  BaseOperator *cartOp = new CartesianOperator(width, height, coils, frames);
+  GenerateData(cartOp);
+
+  // a single frame window reproduces every frame
+  InitialSolutionParams params;
+  params.method = INIT_VIEWSHARING;
+  params.window = 1;
+  InitialSolution init(N, frames, params, cartOp);
+  CVector x(N * frames);
+  init.Compute(kdata, u0, b1, x);
+
+  EXPECT_NEAR(0.0, RelativeError(x), 1E-4);
+  EXPECT_NEAR(0.0, init.GetResidual(), 1E-4);
+  EXPECT_GT(init.GetInitialResidual(), init.GetResidual());
+  delete cartOp;
+}
+
+TEST_F(Test_InitialSolution, ViewSharingIsDensityWeighted)
+{
+  // static object, the central lines are sampled in every frame
+  for (unsigned cnt = N; cnt < N * frames; cnt++)
+    xTrueHost[cnt] = xTrueHost[cnt % N];
+  xTrue.assignFromHost(xTrueHost.begin(), xTrueHost.end());
+
+  std::vector<RType> maskHost(N * frames, 0.0);
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned row = 0; row < height; row++)
+      if (row % 2 == frame % 2 || row == height / 2 || row == height / 2 - 1)
+        for (unsigned col = 0; col < width; col++)
+          maskHost[frame * N + row * width + col] = 1.0;
+  RVector mask(N * frames);
+  mask.assignFromHost(maskHost.begin(), maskHost.end());
+
+  BaseOperator *cartOp =
+      new CartesianOperator(width, height, coils, frames, mask, false);
+  GenerateData(cartOp);
+
+  // two frames cover all lines, the doubly sampled centre is averaged
+  InitialSolutionParams params;
+  params.method = INIT_VIEWSHARING;
+  params.window = 2;
+  InitialSolution init(N, frames, params, cartOp);
+  CVector x(N * frames);
+  init.Compute(kdata, u0, b1, x);
+
+  EXPECT_NEAR(0.0, RelativeError(x), 1E-4);
+  delete cartOp;
+}
+
+TEST_F(Test_InitialSolution, CGSenseReducesResidual)
+{
+  // interleaved lines, each frame samples every second phase encoding line
+  std::vector<RType> maskHost(N * frames, 0.0);
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned row = frame % 2; row < height; row += 2)
+      for (unsigned col = 0; col < width; col++)
+        maskHost[frame * N + row * width + col] = 1.0;
+  RVector mask(N * frames);
+  mask.assignFromHost(maskHost.begin(), maskHost.end());
+
+  BaseOperator *cartOp =
+      new CartesianOperator(width, height, coils, frames, mask, false);
+  GenerateData(cartOp);
+
+  InitialSolutionParams params;
+  params.method = INIT_CGSENSE;
+  params.cgIt = 10;
+  params.cgTolerance = 1E-4;
+  InitialSolution init(N, frames, params, cartOp);
+  CVector x(N * frames);
+  init.Compute(kdata, u0, b1, x);
+
+  EXPECT_GT(init.GetIterations(), 0u);
+  EXPECT_LE(init.GetIterations(), 10u);
+  EXPECT_LT(init.GetResidual(), 0.5 * init.GetInitialResidual());
+
+  // view sharing of the interleaves, scaled to the data
+  params.method = INIT_VIEWSHARING;
+  params.window = 2;
+  InitialSolution viewSharing(N, frames, params, cartOp);
+  viewSharing.Compute(kdata, u0, b1, x);
+  EXPECT_LT(viewSharing.GetResidual(), 1.0);
+  delete cartOp;
+}
@@ -6,6 +6,9 @@
 #include "ismrmrd/xml.h"
 #include "ismrmrd/version.h"
 #include "../include/types.h"
+#include "../include/ismrmrd_reader.h"
+#include "../include/acquisition_stream.h"
+#include "../include/raw_data_preparation.h"
 #include "agile/calc/fft.hpp"
 
 std::string outfile("test.h5");
@@ -240,3 +243,207 @@ TEST(Test_Ismrmrd, Reconstruct2DCartesianPhantom)
   d.appendNDArray("recon", reconArray);
 }
 
+
+void GenerateCartesianTestFile(const std::string &filename,
+                               unsigned oversampling = 1)
+{
+  std::remove(filename.c_str());
+  ISMRMRD::Dataset d(filename.c_str(), dataset.c_str(), true);
+
+  ISMRMRD::IsmrmrdHeader h;
+  h.version = ISMRMRD_XMLHDR_VERSION;
+  ISMRMRD::AcquisitionSystemInformation sys;
+  sys.receiverChannels = coils;
+  h.acquisitionSystemInformation = sys;
+
+  ISMRMRD::Encoding e;
+  e.encodedSpace.matrixSize.x = readout * oversampling;
+  e.encodedSpace.matrixSize.y = matrix_size;
+  e.encodedSpace.matrixSize.z = 1;
+  e.reconSpace.matrixSize = e.encodedSpace.matrixSize;
+  e.reconSpace.matrixSize.x = readout;
+  e.trajectory = "cartesian";
+  e.encodingLimits.kspace_encoding_step_1 =
+      ISMRMRD::Limit(0, matrix_size - 1, (matrix_size >> 1));
+  e.encodingLimits.phase = ISMRMRD::Limit(0, 0, 0);
+  e.encodingLimits.repetition = ISMRMRD::Limit(0, 0, 0);
+  h.encoding.push_back(e);
+
+  std::stringstream str;
+  ISMRMRD::serialize(h, str);
+  d.writeHeader(str.str());
+
+  unsigned samples = readout * oversampling;
+  ISMRMRD::Acquisition acq(samples, coils, 0);
+  acq.center_sample() = (samples >> 1);
+  for (size_t i = 0; i < matrix_size; i++)
+  {
+    acq.idx().kspace_encode_step_1 = i;
+    for (size_t c = 0; c < coils; c++)
+      for (size_t s = 0; s < samples; s++)
+        acq.data(s, c) = (oversampling > 1) ? std::complex<float>(i + 1, c)
+                                            : std::complex<float>(s + i, c);
+    d.appendAcquisition(acq);
+  }
+}
+
+TEST(Test_Ismrmrd, BlockReadEqualsSingleRead)
+{
+  std::string filename("stream_test.h5");
+  GenerateCartesianTestFile(filename);
+
+  OptionsParser op;
+  op.kdataFilename = filename;
+  IsmrmrdReader reader(op);
+  reader.LoadRawData();
+  EXPECT_EQ(matrix_size, reader.GetNumberOfAcquisitions());
+
+  std::vector<Acquisition> block;
+  reader.GetAcquisitions(2, 5, block);
+  EXPECT_EQ(5u, block.size());
+
+  for (unsigned cnt = 0; cnt < block.size(); cnt++)
+  {
+    Acquisition acq = reader.GetAcquisition(2 + cnt);
+    EXPECT_EQ(acq.line, block[cnt].line);
+    EXPECT_EQ(acq.readouts, block[cnt].readouts);
+    EXPECT_EQ(coils, block[cnt].coils);
+    EXPECT_EQ(readout, block[cnt].samples);
+    for (unsigned coil = 0; coil < coils; coil++)
+      for (unsigned s = 0; s < readout; s++)
+      {
+        EXPECT_EQ(acq.coilData(coil)[s], block[cnt].coilData(coil)[s]);
+        // contiguous coil-major layout
+        EXPECT_EQ(std::complex<float>(s + 2 + cnt, coil),
+                  block[cnt].data[s + coil * readout]);
+      }
+  }
+}
+
+TEST(Test_Ismrmrd, AcquisitionStreamDeliversAllAcquisitionsInOrder)
+{
+  std::string filename("stream_test.h5");
+  GenerateCartesianTestFile(filename);
+
+  OptionsParser op;
+  op.kdataFilename = filename;
+  IsmrmrdReader reader(op);
+  reader.LoadRawData();
+
+  // block size not dividing the number of acquisitions
+  AcquisitionStream stream(&reader, 3, 1);
+  stream.Start();
+
+  std::vector<Acquisition> block;
+  unsigned acqCnt = 0;
+  while (stream.NextBlock(block))
+  {
+    for (unsigned cnt = 0; cnt < block.size(); cnt++, acqCnt++)
+    {
+      EXPECT_EQ(acqCnt, block[cnt].line);
+      EXPECT_EQ(std::complex<float>(1 + acqCnt, coils - 1),
+                block[cnt].coilData(coils - 1)[1]);
+    }
+  }
+  EXPECT_EQ(matrix_size, acqCnt);
+}
+
+TEST(Test_Ismrmrd, AcquisitionHeadersMatchDecodedAcquisitions)
+{
+  std::string filename("stream_test.h5");
+  GenerateCartesianTestFile(filename);
+
+  OptionsParser op;
+  op.kdataFilename = filename;
+  IsmrmrdReader reader(op);
+  reader.LoadRawData();
+
+  std::vector<AcquisitionHeader> headers;
+  reader.GetAcquisitionHeaders(headers);
+  EXPECT_EQ(reader.GetNumberOfAcquisitions(), headers.size());
+
+  for (unsigned cnt = 0; cnt < headers.size(); cnt++)
+  {
+    Acquisition acq = reader.GetAcquisition(cnt);
+    EXPECT_EQ(acq.line, headers[cnt].line);
+    EXPECT_EQ(acq.phase, headers[cnt].phase);
+    EXPECT_EQ(acq.slice, headers[cnt].slice);
+    EXPECT_EQ(acq.readouts, headers[cnt].readouts);
+    EXPECT_EQ(acq.centerRow, headers[cnt].centerRow);
+    EXPECT_EQ(acq.centerColumn, headers[cnt].centerColumn);
+    EXPECT_FALSE(headers[cnt].hasTrajectory);
+    EXPECT_FALSE(headers[cnt].isNoiseMeasurement);
+  }
+}
+
+TEST(Test_Ismrmrd, RemoveReadoutOversampling)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  std::string filename("stream_test_os.h5");
+  GenerateCartesianTestFile(filename, 2);
+
+  OptionsParser op;
+  op.slice = 0;
+  op.tpat = 1;
+  op.verbose = false;
+  op.nonuniform = false;
+  op.forceOSRemoval = false;
+
+  std::vector<CType> data;
+  std::vector<RType> mask, w;
+  Dimension dims;
+  CType datanorm(1.0);
+  RawDataPreparation rdp(op, false, true, false, false);
+  rdp.PrepareIsmrmrdData(filename, data, mask, w, dims, datanorm);
+
+  EXPECT_EQ(readout, dims.width);
+  EXPECT_EQ(readout * matrix_size * coils, data.size());
+
+  // constant lines are preserved, scaled by sqrt(2) due to the unitary
+  // transforms of different length
+  for (unsigned coil = 0; coil < coils; coil++)
+    for (unsigned line = 0; line < matrix_size; line++)
+      for (unsigned s = 0; s < readout; s++)
+      {
+        CType value = data[s + line * readout + coil * readout * matrix_size];
+        EXPECT_NEAR(std::sqrt(2.0) * (line + 1), value.real(), EPS);
+        EXPECT_NEAR(std::sqrt(2.0) * coil, value.imag(), EPS);
+      }
+}
+
+TEST(Test_Ismrmrd, FusedChopEqualsChopData)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  std::string filename("stream_test.h5");
+  GenerateCartesianTestFile(filename);
+
+  OptionsParser op;
+  op.slice = 0;
+  op.tpat = 1;
+  op.verbose = false;
+  op.nonuniform = false;
+  op.forceOSRemoval = false;
+
+  std::vector<CType> data, chopped;
+  std::vector<RType> mask, choppedMask, w;
+  Dimension dims;
+  CType datanorm(1.0);
+
+  RawDataPreparation rdp(op, false, false, false, false);
+  rdp.PrepareIsmrmrdData(filename, data, mask, w, dims, datanorm);
+  rdp.ChopData(data, mask, dims);
+
+  RawDataPreparation rdpChop(op, false, false, false, true);
+  rdpChop.PrepareIsmrmrdData(filename, chopped, choppedMask, w, dims,
+                             datanorm);
+
+  ASSERT_EQ(data.size(), chopped.size());
+  ASSERT_EQ(mask.size(), choppedMask.size());
+  for (unsigned cnt = 0; cnt < data.size(); cnt++)
+  {
+    EXPECT_NEAR(data[cnt].real(), chopped[cnt].real(), EPS);
+    EXPECT_NEAR(data[cnt].imag(), chopped[cnt].imag(), EPS);
+  }
+  for (unsigned cnt = 0; cnt < mask.size(); cnt++)
+    EXPECT_EQ(mask[cnt], choppedMask[cnt]);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "../include/options_parser.h"
+#include <cstdio>
+#include <fstream>
 #include <string>
 
 class Test_Options : public ::testing::Test
@@ -103,6 +105,21 @@ TEST_F(Test_Options, AdaptLambdaFlagPassed)
   EXPECT_TRUE(op.adaptLambdaParams.adaptLambda);
 }
 
+TEST_F(Test_Options, SosNormalizationFlagPassed)
+{
+  OptionsParser op;
+  int argc = 6;
+  const char *argv[] = { "./fredy_mri", "-r", "dataDir", "output.bin", "-o",
+                         "--sosNormalization" };
+  EXPECT_TRUE(op.ParseOptions(argc, const_cast<char **>(argv)));
+  EXPECT_TRUE(op.sosNormalization);
+
+  // coil combined normalization by default
+  OptionsParser defaultOp;
+  EXPECT_TRUE(defaultOp.ParseOptions(argc - 1, const_cast<char **>(argv)));
+  EXPECT_FALSE(defaultOp.sosNormalization);
+}
+
 TEST_F(Test_Options, DensityDataPassed)
 {
   OptionsParser op;
@@ -136,3 +153,142 @@ TEST_F(Test_Options, U0DataPassed)
   EXPECT_EQ("u0.bin", op.u0Filename);
 }
 
+TEST_F(Test_Options, SensitivityCacheDirPassed)
+{
+  OptionsParser op;
+  int argc = 8;
+  const char *argv[] = { "./fredy_mri", "kdata.bin", "traj.bin",
+                         "output.bin",  "-d",        "128:128:256:64:18:20",
+                         "-c",          "b1cache" };
+  EXPECT_TRUE(op.ParseOptions(argc, const_cast<char **>(argv)));
+  EXPECT_EQ("b1cache", op.sensitivityCacheDir);
+}
+
+TEST_F(Test_Options, PDVariantPassed)
+{
+  OptionsParser op;
+  int argc = 9;
+  const char *argv[] = { "./fredy_mri", "kdata.bin", "traj.bin",
+                         "output.bin",  "-d",        "128:128:256:64:18:20",
+                         "--pdVariant", "accelerated", "--pdRestart=true" };
+  EXPECT_TRUE(op.ParseOptions(argc, const_cast<char **>(argv)));
+  EXPECT_EQ(PD_ACCELERATED, op.tgv2Params.variant);
+  EXPECT_EQ(PD_ACCELERATED, op.ictgv2Params.variant);
+  EXPECT_TRUE(op.ictgv2Params.restart);
+}
+
+TEST_F(Test_Options, CheckpointOptionsPassed)
+{
+  OptionsParser op;
+  int argc = 12;
+  const char *argv[] = { "./fredy_mri",    "kdata.bin",  "traj.bin",
+                         "output.bin",     "-d",         "128:128:256:64:18:20",
+                         "--checkpoint",   "run.ckpt",   "--checkpointInterval",
+                         "100",            "--resume",   "old.ckpt" };
+  EXPECT_TRUE(op.ParseOptions(argc, const_cast<char **>(argv)));
+  EXPECT_EQ("run.ckpt", op.checkpointFilename);
+  EXPECT_EQ(100u, op.checkpointInterval);
+  EXPECT_EQ("old.ckpt", op.resumeFilename);
+  EXPECT_TRUE(op.warmStartFilename.empty());
+}
+
+TEST_F(Test_Options, ParameterSweepPassed)
+{
+  const char *sweepFile = "../test/data/output/test_sweep.txt";
+  std::ofstream sweep(sweepFile);
+  sweep << "# continuation path\n"
+        << "ictgv2.lambda=4,2 ictgv2.alpha=0.3,0.5\n"
+        << "\n"
+        << "tgv2.lambda=1\n";
+  sweep.close();
+
+  OptionsParser op;
+  int argc = 9;
+  const char *argv[] = { "./fredy_mri", "kdata.bin", "traj.bin",
+                         "output.bin",  "-d",        "128:128:256:64:18:20",
+                         "--sweep",     sweepFile,   "--sweepWarmStart" };
+  EXPECT_TRUE(op.ParseOptions(argc, const_cast<char **>(argv)));
+  EXPECT_TRUE(op.sweepWarmStart);
+  ASSERT_EQ(5u, op.parameterSets.size());
+  EXPECT_EQ("ictgv2.lambda=4 ictgv2.alpha=0.5", op.parameterSets[1]);
+
+  RType lambda = op.ictgv2Params.lambda;
+  op.ApplyParameterSet(1);
+  EXPECT_FLOAT_EQ(4.0, op.ictgv2Params.lambda);
+  EXPECT_FLOAT_EQ(0.5, op.ictgv2Params.alpha);
+
+  // entries of previous sets are reset
+  op.ApplyParameterSet(4);
+  EXPECT_FLOAT_EQ(1.0, op.tgv2Params.lambda);
+  EXPECT_FLOAT_EQ(lambda, op.ictgv2Params.lambda);
+
+  std::remove(sweepFile);
+}
+
+TEST_F(Test_Options, InvalidParameterSweepRejected)
+{
+  const char *sweepFile = "../test/data/output/test_sweep_invalid.txt";
+  std::ofstream sweep(sweepFile);
+  sweep << "ictgv2.lambda=1 coil.uNrIt=10\n";
+  sweep.close();
+
+  OptionsParser op;
+  int argc = 8;
+  const char *argv[] = { "./fredy_mri", "kdata.bin", "traj.bin",
+                         "output.bin",  "-d",        "128:128:256:64:18:20",
+                         "--sweep",     sweepFile };
+  EXPECT_THROW(op.ParseOptions(argc, const_cast<char **>(argv)), po::error);
+
+  std::remove(sweepFile);
+}
+
+TEST_F(Test_Options, ParameterSweepConflictingOptionsRejected)
+{
+  const char *sweepFile = "../test/data/output/test_sweep_conflict.txt";
+  std::ofstream sweep(sweepFile);
+  sweep << "ictgv2.lambda=4,2\n";
+  sweep.close();
+
+  const char *conflicts[][2] = { { "--resume", "old.ckpt" },
+                                 { "--warmStart", "old.ckpt" },
+                                 { "--checkpoint", "run.ckpt" },
+                                 { "--adaptlambda", NULL } };
+  for (unsigned cnt = 0; cnt < 4; cnt++)
+  {
+    OptionsParser op;
+    int argc = conflicts[cnt][1] == NULL ? 9 : 10;
+    const char *argv[] = { "./fredy_mri",     "kdata.bin",
+                           "traj.bin",        "output.bin",
+                           "-d",              "128:128:256:64:18:20",
+                           "--sweep",         sweepFile,
+                           conflicts[cnt][0], conflicts[cnt][1] };
+    EXPECT_FALSE(op.ParseOptions(argc, const_cast<char **>(argv)))
+        << conflicts[cnt][0];
+  }
+
+  std::remove(sweepFile);
+}
+
+TEST_F(Test_Options, SubspaceWithDiagonalPreconditioningRejected)
+{
+  const char *configFile = "../test/data/output/test_subspace.cfg";
+  std::ofstream config(configFile);
+  config << "[subspace]\n"
+         << "rank = 2\n";
+  config.close();
+
+  OptionsParser op;
+  int argc = 10;
+  const char *argv[] = { "./fredy_mri",   "kdata.bin",  "traj.bin",
+                         "output.bin",    "-d",         "128:128:256:64:18:20",
+                         "-p",            configFile,   "--diagPrecond",
+                         "true" };
+  EXPECT_FALSE(op.ParseOptions(argc, const_cast<char **>(argv)));
+
+  // accepted without preconditioning
+  OptionsParser opSubspace;
+  EXPECT_TRUE(opSubspace.ParseOptions(argc - 2, const_cast<char **>(argv)));
+  EXPECT_EQ(2u, opSubspace.subspaceRank);
+
+  std::remove(configFile);
+}
@@ -0,0 +1,98 @@
+#ifndef TEST_PD_TEST_PROBLEM_H_
+
+#define TEST_PD_TEST_PROBLEM_H_
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./test_utils.h"
+#include "../include/types.h"
+#include "../include/cartesian_operator.h"
+
+/**
+ * \brief Small fully sampled Cartesian two-coil problem shared by the
+ * primal-dual solver variant tests
+ *
+ */
+class PDTestProblem : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 5;
+  static const unsigned int height = 5;
+  static const unsigned int coils = 2;
+  static const unsigned int frames = 3;
+  static const unsigned int N = width * height * frames;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    std::vector<CType> data;
+    for (unsigned cnt = 0; cnt < N * coils; cnt++)
+      data.push_back(CType(cnt % 7 + 0.1 * cnt, 0.5 * (cnt % 3)));
+    data_gpu = CVector(N * coils);
+    data_gpu.assignFromHost(data.begin(), data.end());
+
+    b1_gpu = CVector(width * height * coils);
+    b1_gpu.assign(width * height * coils, 1.0);
+    agile::lowlevel::scale(CType(0.0, 2.0), b1_gpu.data() + width * height,
+                           b1_gpu.data() + width * height, width * height);
+
+    mask_gpu = RVector(N);
+    mask_gpu.assign(N, 1.0);
+
+    cartOp = new CartesianOperator(width, height, coils, frames, mask_gpu,
+                                   false);
+  }
+
+  virtual void TearDown()
+  {
+    delete cartOp;
+  }
+
+  /** \brief Reconstruction of the test data starting from zero */
+  template <typename TSolver> CVector Reconstruct(TSolver &solver)
+  {
+    CVector x(N);
+    x.assign(N, 0.0);
+    solver.IterativeReconstruction(data_gpu, x, b1_gpu);
+    return x;
+  }
+
+  /**
+   * \brief Number of iterations the solver needs to reach the normalized
+   * PD gap target, checked every 20 iterations
+   *
+   * The count is recorded as test property under the given name.
+   */
+  template <typename TSolver>
+  unsigned IterationsToPDGap(TSolver &solver, const std::string &name,
+                             RType pdGap = 1E-2, unsigned maxIt = 2000)
+  {
+    solver.GetParams().maxIt = maxIt;
+    solver.GetParams().stopPDGap = pdGap;
+    Reconstruct(solver);
+    unsigned iterations = solver.GetIterations();
+    ::testing::Test::RecordProperty(name, iterations);
+    std::cout << name << ": " << iterations << " iterations to PD gap "
+              << pdGap << std::endl;
+    return iterations;
+  }
+
+  /** \brief Relative l2 distance of x to the reference */
+  RType RelativeDifference(CVector &x, CVector &reference)
+  {
+    CVector diff(N);
+    agile::subVector(reference, x, diff);
+    return agile::norm2(diff) / agile::norm2(reference);
+  }
+
+  CVector data_gpu;
+  CVector b1_gpu;
+  RVector mask_gpu;
+  BaseOperator *cartOp;
+};
+
+#endif  // TEST_PD_TEST_PROBLEM_H_
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/coil_construction.h"
+#include "../include/screened_poisson_solver.h"
+
+#include "agile/operator/cg.hpp"
+
+class Test_ScreenedPoissonSolver : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 8;
+  static const unsigned int height = 6;
+  static const unsigned int batch = 2;
+  static const unsigned int N = width * height;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    std::vector<CType> coefficientHost(N);
+    for (unsigned cnt = 0; cnt < N; cnt++)
+      coefficientHost[cnt] = 0.1 + 0.05 * std::cos(0.4 * cnt);
+    coefficient = CVector(N);
+    coefficient.assignFromHost(coefficientHost.begin(), coefficientHost.end());
+
+    for (unsigned img = 0; img < batch; img++)
+      for (unsigned cnt = 0; cnt < N; cnt++)
+        rhs_data.push_back(
+            CType(std::sin(0.3 * cnt + img), 0.5 * std::cos(0.2 * cnt * img)));
+    rhs = CVector(N * batch);
+    rhs.assignFromHost(rhs_data.begin(), rhs_data.end());
+  }
+
+  std::vector<CType> rhs_data;
+  CVector coefficient;
+  CVector rhs;
+};
+
+TEST_F(Test_ScreenedPoissonSolver, PeriodicSolutionEqualsCG)
+{
+  communicator_type com;
+  com.allocateGPU();
+
+  ScreenedPoissonSolver solver(width, height, batch, true);
+  CVector x(N * batch);
+  x.assign(N * batch, 0);
+  solver.Solve(coefficient, 1.0, rhs, x, 1E-6, 100);
+
+  EXPECT_TRUE(solver.HasConverged());
+  EXPECT_GT(N, solver.GetIterations());
+
+  std::vector<CType> xHost(N * batch);
+  x.copyToHost(xHost);
+
+  // reference: unpreconditioned CG used in B1FromUH1
+  forward_type forward(com, coefficient, width, height);
+  typedef agile::ScalarProductMeasure<communicator_type> measure_type;
+  measure_type scalar_product(com);
+  agile::ConjugateGradient<communicator_type, forward_type, measure_type> cg(
+      com, forward, scalar_product, 1e-12, 1e-12, 800);
+
+  CVector y(N), xRef(N);
+  for (unsigned img = 0; img < batch; img++)
+  {
+    utils::GetSubVector(rhs, y, img, N);
+    xRef.assign(N, 0);
+    cg(y, xRef);
+
+    std::vector<CType> xRefHost(N);
+    xRef.copyToHost(xRefHost);
+    for (unsigned cnt = 0; cnt < N; cnt++)
+      EXPECT_NEAR(0.0, std::abs(xRefHost[cnt] - xHost[img * N + cnt]), EPS);
+  }
+}
+
+TEST_F(Test_ScreenedPoissonSolver, NeumannResidual)
+{
+  ScreenedPoissonSolver solver(width, height, batch, false);
+  CVector x(N * batch);
+  x.assign(N * batch, 0);
+  solver.Solve(coefficient, 2.0, rhs, x, 1E-6, 100);
+
+  EXPECT_TRUE(solver.HasConverged());
+  EXPECT_GT(N, solver.GetIterations());
+
+  CVector Ax(N * batch);
+  solver.ApplyOperator(coefficient, 2.0, x, Ax);
+  agile::subVector(Ax, rhs, Ax);
+  EXPECT_NEAR(0.0, agile::norm2(Ax) / agile::norm2(rhs), EPS);
+}
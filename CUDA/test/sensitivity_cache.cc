@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/sensitivity_cache.h"
+
+#include <boost/filesystem.hpp>
+
+class Test_SensitivityCache : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 8;
+  static const unsigned int height = 6;
+  static const unsigned int coils = 3;
+  static const unsigned int N = width * height;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    for (unsigned cnt = 0; cnt < N * coils; cnt++)
+      b1_data.push_back(CType(std::cos(0.3 * cnt), std::sin(0.2 * cnt)));
+    b1 = CVector(N * coils);
+    b1.assignFromHost(b1_data.begin(), b1_data.end());
+
+    for (unsigned cnt = 0; cnt < N; cnt++)
+      u0_data.push_back(CType(1.0 + 0.1 * cnt, 0.0));
+    u0 = CVector(N);
+    u0.assignFromHost(u0_data.begin(), u0_data.end());
+
+    kdata = CVector(N * coils);
+    kdata.assignFromHost(b1_data.begin(), b1_data.end());
+
+    dims = Dimension(width, height, 1, width, height, 1, coils, 1);
+  }
+
+  std::vector<CType> b1_data;
+  std::vector<CType> u0_data;
+  CVector b1;
+  CVector u0;
+  CVector kdata;
+  Dimension dims;
+};
+
+TEST_F(Test_SensitivityCache, KeyDependsOnDataAndParams)
+{
+  CoilConstructionParams params;
+  params.b1NrIt = 100;
+
+  SensitivityCache cache1("cache");
+  cache1.AddToKey(kdata);
+  cache1.AddToKey(params);
+
+  SensitivityCache cache2("cache");
+  cache2.AddToKey(kdata);
+  cache2.AddToKey(params);
+  EXPECT_EQ(cache1.GetKey(), cache2.GetKey());
+  EXPECT_EQ(cache1.GetFilename(), cache2.GetFilename());
+
+  params.b1NrIt = 101;
+  SensitivityCache cache3("cache");
+  cache3.AddToKey(kdata);
+  cache3.AddToKey(params);
+  EXPECT_NE(cache1.GetKey(), cache3.GetKey());
+
+  params.b1NrIt = 100;
+  agile::scale((CType)2.0, kdata, kdata);
+  SensitivityCache cache4("cache");
+  cache4.AddToKey(kdata);
+  cache4.AddToKey(params);
+  EXPECT_NE(cache1.GetKey(), cache4.GetKey());
+}
+
+TEST_F(Test_SensitivityCache, DisabledCache)
+{
+  SensitivityCache cache("");
+  EXPECT_FALSE(cache.IsEnabled());
+  EXPECT_FALSE(cache.Store(dims, b1, u0));
+  EXPECT_FALSE(cache.Load(dims, b1, u0));
+}
+
+TEST_F(Test_SensitivityCache, StoreAndLoad)
+{
+  SensitivityCache cache("../test/data/output/b1cache");
+  cache.AddToKey(kdata);
+  cache.AddToKey(dims);
+  boost::filesystem::remove(cache.GetFilename());
+
+  CVector b1Loaded(N * coils), u0Loaded(N);
+  EXPECT_FALSE(cache.Load(dims, b1Loaded, u0Loaded));
+  EXPECT_TRUE(cache.Store(dims, b1, u0));
+  EXPECT_TRUE(cache.Load(dims, b1Loaded, u0Loaded));
+
+  // no temporary file is left behind
+  boost::filesystem::directory_iterator end;
+  for (boost::filesystem::directory_iterator it("../test/data/output/b1cache");
+       it != end; ++it)
+    EXPECT_NE(".tmp", it->path().extension().string());
+
+  std::vector<CType> b1Host, u0Host;
+  b1Loaded.copyToHost(b1Host);
+  u0Loaded.copyToHost(u0Host);
+  ASSERT_EQ(b1_data.size(), b1Host.size());
+  ASSERT_EQ(u0_data.size(), u0Host.size());
+  for (unsigned cnt = 0; cnt < b1Host.size(); cnt++)
+    EXPECT_NEAR(0.0, std::abs(b1_data[cnt] - b1Host[cnt]), EPS);
+  for (unsigned cnt = 0; cnt < u0Host.size(); cnt++)
+    EXPECT_NEAR(0.0, std::abs(u0_data[cnt] - u0Host[cnt]), EPS);
+
+  // entries of other dimensions are rejected
+  Dimension otherDims(width, height, 1, width, height, 1, coils - 1, 1);
+  EXPECT_FALSE(cache.Load(otherDims, b1Loaded, u0Loaded));
+
+  boost::filesystem::remove(cache.GetFilename());
+}
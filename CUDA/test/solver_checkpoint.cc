@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/solver_checkpoint.h"
+#include "../include/ictv.h"
+#include "../include/tv_temp.h"
+#include "./pd_test_problem.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+class Test_SolverCheckpoint : public ::testing::Test
+{
+ public:
+  virtual void SetUp()
+  {
+    data.iteration = 42;
+    data.scalars.push_back(0.25);
+    data.scalars.push_back(-3.0);
+
+    data.vectors.resize(3);
+    for (unsigned cnt = 0; cnt < 20; cnt++)
+      data.vectors[0].push_back(CType(std::cos(0.3 * cnt), std::sin(0.2 * cnt)));
+    data.vectors[2].push_back(CType(1.0, -1.0));
+
+    data.histories.resize(1);
+    data.histories[0].push_back(CType(1E-3, 0.0));
+  }
+
+  void ExpectEqual(const SolverCheckpointData &expected,
+                   const SolverCheckpointData &actual)
+  {
+    EXPECT_EQ(expected.iteration, actual.iteration);
+    EXPECT_EQ(expected.scalars, actual.scalars);
+    ASSERT_EQ(expected.vectors.size(), actual.vectors.size());
+    for (unsigned cnt = 0; cnt < expected.vectors.size(); cnt++)
+      EXPECT_EQ(expected.vectors[cnt], actual.vectors[cnt]);
+    ASSERT_EQ(expected.histories.size(), actual.histories.size());
+    for (unsigned cnt = 0; cnt < expected.histories.size(); cnt++)
+      EXPECT_EQ(expected.histories[cnt], actual.histories[cnt]);
+  }
+
+  SolverCheckpointData data;
+};
+
+TEST_F(Test_SolverCheckpoint, WriteAndRead)
+{
+  std::string filename = "../test/data/output/solver.ckpt";
+  boost::filesystem::remove(filename);
+
+  SolverCheckpointData loaded;
+  EXPECT_FALSE(SolverCheckpoint::Read(filename, loaded));
+
+  SolverCheckpoint checkpoint(filename);
+  EXPECT_TRUE(checkpoint.Write(data));
+  EXPECT_TRUE(SolverCheckpoint::Read(filename, loaded));
+  ExpectEqual(data, loaded);
+
+  boost::filesystem::remove(filename);
+}
+
+TEST_F(Test_SolverCheckpoint, WriteAsync)
+{
+  std::string filename = "../test/data/output/solver_async.ckpt";
+  boost::filesystem::remove(filename);
+
+  SolverCheckpointData expected = data;
+  SolverCheckpoint checkpoint(filename);
+  checkpoint.WriteAsync(data);
+  EXPECT_TRUE(data.vectors.empty());
+  EXPECT_TRUE(checkpoint.Wait());
+
+  SolverCheckpointData loaded;
+  EXPECT_TRUE(SolverCheckpoint::Read(filename, loaded));
+  ExpectEqual(expected, loaded);
+
+  boost::filesystem::remove(filename);
+}
+
+TEST_F(Test_SolverCheckpoint, RejectsInvalidFiles)
+{
+  std::string filename = "../test/data/output/invalid.ckpt";
+  std::ofstream file(filename.c_str(), std::ios_base::binary);
+  file << "no checkpoint data";
+  file.close();
+
+  SolverCheckpointData loaded;
+  EXPECT_FALSE(SolverCheckpoint::Read(filename, loaded));
+
+  // truncated checkpoint
+  SolverCheckpoint checkpoint(filename);
+  EXPECT_TRUE(checkpoint.Write(data));
+  boost::filesystem::resize_file(filename,
+                                 boost::filesystem::file_size(filename) - 4);
+  EXPECT_FALSE(SolverCheckpoint::Read(filename, loaded));
+
+  boost::filesystem::remove(filename);
+}
+
+class Test_SolverResume : public PDTestProblem
+{
+ public:
+  /** \brief Interrupt after 60 iterations and compare the resumed result
+   * after 80 iterations to an uninterrupted run */
+  template <typename TSolver> void ExpectBitExactResume(std::string filename)
+  {
+    TSolver solver(width, height, coils, frames, cartOp);
+    solver.GetParams().maxIt = 80;
+    CVector x = Reconstruct(solver);
+
+    {
+      TSolver interruptedSolver(width, height, coils, frames, cartOp);
+      interruptedSolver.GetParams().maxIt = 60;
+      interruptedSolver.SetCheckpoint(filename, 30);
+      Reconstruct(interruptedSolver);
+    }
+
+    TSolver resumedSolver(width, height, coils, frames, cartOp);
+    resumedSolver.GetParams().maxIt = 80;
+    resumedSolver.SetResume(filename);
+    CVector xResumed = Reconstruct(resumedSolver);
+    EXPECT_EQ(80u, resumedSolver.GetIterations());
+
+    std::vector<CType> result, resumed;
+    x.copyToHost(result);
+    xResumed.copyToHost(resumed);
+    EXPECT_EQ(result, resumed);
+
+    boost::filesystem::remove(filename);
+  }
+};
+
+TEST_F(Test_SolverResume, ICTV)
+{
+  ExpectBitExactResume<ICTV>("../test/data/output/ictv.ckpt");
+}
+
+TEST_F(Test_SolverResume, TVTEMP)
+{
+  ExpectBitExactResume<TVTEMP>("../test/data/output/tvtemp.ckpt");
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include "../include/types.h"
+#include "./test_utils.h"
+#include "../include/cartesian_operator.h"
+#include "../include/subspace_operator.h"
+
+class Test_SubspaceOperator : public ::testing::Test
+{
+ public:
+  static const unsigned int width = 8;
+  static const unsigned int height = 6;
+  static const unsigned int coils = 2;
+  static const unsigned int frames = 5;
+  static const unsigned int rank = 2;
+  static const unsigned int N = width * height;
+
+  virtual void SetUp()
+  {
+    agile::GPUEnvironment::allocateGPU(0);
+
+    // image series of rank 2
+    std::vector<CType> xHost;
+    for (unsigned frame = 0; frame < frames; frame++)
+      for (unsigned cnt = 0; cnt < N; cnt++)
+        xHost.push_back(CType(1.0 + 0.1 * cnt, 0.2) +
+                        CType(std::cos(0.3 * cnt), std::sin(0.5 * cnt)) *
+                            (RType)std::cos(0.7 * frame));
+    x = CVector(N * frames);
+    x.assignFromHost(xHost.begin(), xHost.end());
+
+    std::vector<CType> b1Host;
+    for (unsigned cnt = 0; cnt < N * coils; cnt++)
+      b1Host.push_back(CType(0.5 + 0.01 * cnt, 0.3 * (cnt % 3)));
+    b1 = CVector(N * coils);
+    b1.assignFromHost(b1Host.begin(), b1Host.end());
+
+    std::vector<RType> maskHost;
+    for (unsigned cnt = 0; cnt < N * frames; cnt++)
+      maskHost.push_back((cnt * 7 + cnt / N) % 3 == 0 ? 0.0 : 1.0);
+    mask = RVector(N * frames);
+    mask.assignFromHost(maskHost.begin(), maskHost.end());
+  }
+
+  CVector x;
+  CVector b1;
+  RVector mask;
+};
+
+TEST_F(Test_SubspaceOperator, EstimatedBasisRepresentsSeries)
+{
+  std::vector<CType> basis;
+  RType residualEnergy =
+      SubspaceOperator::EstimateBasis(x, N, frames, rank, basis);
+  EXPECT_EQ(frames * rank, basis.size());
+  EXPECT_NEAR(0.0, residualEnergy, 1E-4);
+
+  BaseOperator *cartOp =
+      new CartesianOperator(width, height, coils, frames, mask, false);
+  SubspaceOperator subspaceOp(cartOp, width, height, coils, frames, basis,
+                              rank);
+  EXPECT_EQ(rank + 0u, subspaceOp.GetBasisSize());
+
+  CVector coefficients(N * rank), series(N * frames);
+  subspaceOp.Project(x, coefficients);
+  subspaceOp.Expand(coefficients, series);
+
+  agile::subVector(series, x, series);
+  EXPECT_NEAR(0.0, agile::norm2(series) / agile::norm2(x), 1E-3);
+
+  EXPECT_THROW(SubspaceOperator::EstimateBasis(x, N, frames, frames + 1,
+                                               basis),
+               std::invalid_argument);
+  delete cartOp;
+}
+
+TEST_F(Test_SubspaceOperator, CartesianOperationsMatchExpandedSeries)
+{
+  std::vector<CType> basis;
+  SubspaceOperator::EstimateBasis(x, N, frames, rank, basis);
+
+  BaseOperator *cartOp =
+      new CartesianOperator(width, height, coils, frames, mask, false);
+  SubspaceOperator subspaceOp(cartOp, width, height, coils, frames, basis,
+                              rank);
+
+  CVector coefficients(N * rank), series(N * frames);
+  subspaceOp.Project(x, coefficients);
+  subspaceOp.Expand(coefficients, series);
+
+  // k-space of the coefficients equals the k-space of the series
+  CVector z(N * coils * frames), zRef(N * coils * frames);
+  subspaceOp.BackwardOperation(coefficients, z, b1);
+  cartOp->BackwardOperation(series, zRef, b1);
+
+  agile::subVector(z, zRef, zRef);
+  EXPECT_NEAR(0.0, agile::norm2(zRef) / agile::norm2(z), 1E-4);
+
+  // adjoint equals the projection of the adjoint series
+  CVector adjoint(N * rank), adjointRef(N * rank);
+  subspaceOp.ForwardOperation(z, adjoint, b1);
+  cartOp->ForwardOperation(z, series, b1);
+  subspaceOp.Project(series, adjointRef);
+
+  agile::subVector(adjoint, adjointRef, adjointRef);
+  EXPECT_NEAR(0.0, agile::norm2(adjointRef) / agile::norm2(adjoint), 1E-4);
+  delete cartOp;
+}
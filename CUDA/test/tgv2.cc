@@ -2,6 +2,7 @@
 
 #include <stdlib.h>  //< srand, rand
 #include <time.h>    //< time
+#include <stdexcept>
 
 #include "agile/gpu_environment.hpp"
 #include "agile/gpu_vector.hpp"
@@ -10,12 +11,15 @@
 #include "agile/io/file.hpp"
 
 #include "./test_utils.h"
+#include "./pd_test_problem.h"
 #include "../include/types.h"
 #include "../include/tgv2.h"
 #include "../include/utils.h"
 #include "../include/cartesian_operator.h"
 #include "../include/noncartesian_operator.h"
 
+#include <boost/filesystem.hpp>
+
 class Test_TGV : public ::testing::Test
 {
  public:
@@ -550,6 +554,197 @@ TEST_F(Test_TGV, Iteration)
   delete cartOp;
 }
 
+class Test_TGVSolver : public PDTestProblem
+{
+};
+
+TEST_F(Test_TGVSolver, DiagonallyPreconditionedIteration)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 2000;
+  CVector x1 = Reconstruct(solver);
+
+  TGV2 precondSolver(width, height, coils, frames, cartOp);
+  precondSolver.GetParams().maxIt = 2000;
+  precondSolver.GetParams().diagonalPreconditioning = true;
+  CVector x1Precond = Reconstruct(precondSolver);
+
+  EXPECT_EQ(2000u, precondSolver.GetIterations());
+
+  // both variants converge to the same minimizer
+  EXPECT_NEAR(0.0, RelativeDifference(x1Precond, x1), 1E-2);
+}
+
+TEST_F(Test_TGVSolver, PreconditionedIterationsToPDGap)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  unsigned scalarIterations = IterationsToPDGap(solver, "scalar");
+
+  TGV2 precondSolver(width, height, coils, frames, cartOp);
+  precondSolver.GetParams().diagonalPreconditioning = true;
+  unsigned precondIterations = IterationsToPDGap(precondSolver, "diagPrecond");
+
+  EXPECT_LT(scalarIterations, 2000u);
+  EXPECT_LT(precondIterations, 2000u);
+}
+
+TEST_F(Test_TGVSolver, AcceleratedAndAdaptiveVariants)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 2000;
+  CVector x1 = Reconstruct(solver);
+
+  PDVariant variants[2] = { PD_ACCELERATED, PD_ADAPTIVE };
+  for (unsigned cnt = 0; cnt < 2; cnt++)
+  {
+    TGV2 variantSolver(width, height, coils, frames, cartOp);
+    variantSolver.GetParams().maxIt = 2000;
+    variantSolver.GetParams().variant = variants[cnt];
+    variantSolver.GetParams().restart = true;
+    CVector x1Variant = Reconstruct(variantSolver);
+
+    // all variants converge to the same minimizer
+    EXPECT_NEAR(0.0, RelativeDifference(x1Variant, x1), 1E-2);
+  }
+}
+
+TEST_F(Test_TGVSolver, VariantIterationsToPDGap)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  unsigned standardIterations = IterationsToPDGap(solver, "standard");
+  EXPECT_LT(standardIterations, 2000u);
+
+  PDVariant variants[2] = { PD_ACCELERATED, PD_ADAPTIVE };
+  const char *names[2] = { "accelerated", "adaptive" };
+  for (unsigned cnt = 0; cnt < 2; cnt++)
+  {
+    TGV2 variantSolver(width, height, coils, frames, cartOp);
+    variantSolver.GetParams().variant = variants[cnt];
+    variantSolver.GetParams().restart = true;
+    unsigned variantIterations = IterationsToPDGap(variantSolver, names[cnt]);
+
+    EXPECT_LE(variantIterations, standardIterations);
+  }
+}
+
+TEST_F(Test_TGVSolver, AndersonAcceleratedIteration)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 2000;
+  CVector x1 = Reconstruct(solver);
+
+  TGV2 andersonSolver(width, height, coils, frames, cartOp);
+  andersonSolver.GetParams().maxIt = 2000;
+  andersonSolver.GetParams().andersonDepth = 5;
+  CVector x1Anderson = Reconstruct(andersonSolver);
+
+  EXPECT_EQ(0u, solver.GetAndersonSteps());
+  EXPECT_GT(andersonSolver.GetAndersonSteps(), 0u);
+  EXPECT_NEAR(0.0, RelativeDifference(x1Anderson, x1), 1E-2);
+}
+
+TEST_F(Test_TGVSolver, AndersonIterationsToPDGap)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  unsigned plainIterations = IterationsToPDGap(solver, "plain");
+  EXPECT_LT(plainIterations, 2000u);
+
+  TGV2 andersonSolver(width, height, coils, frames, cartOp);
+  andersonSolver.GetParams().andersonDepth = 5;
+  unsigned andersonIterations = IterationsToPDGap(andersonSolver, "anderson");
+
+  EXPECT_LE(andersonIterations, plainIterations);
+}
+
+TEST_F(Test_TGVSolver, StochasticCoilSubsetVariant)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 2000;
+  CVector x1 = Reconstruct(solver);
+
+  // one of two coils per iteration
+  TGV2 stochasticSolver(width, height, coils, frames, cartOp);
+  stochasticSolver.GetParams().maxIt = 4000;
+  stochasticSolver.GetParams().variant = PD_STOCHASTIC;
+  stochasticSolver.GetParams().coilSubsetSize = 1;
+  CVector x1Stochastic = Reconstruct(stochasticSolver);
+
+  EXPECT_NEAR(0.0, RelativeDifference(x1Stochastic, x1), 5E-2);
+}
+
+TEST_F(Test_TGVSolver, FramesIndependentWithoutTemporalRegularization)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 500;
+  solver.SetTemporalRegularization(false);
+  CVector x1 = Reconstruct(solver);
+
+  // reversed frames give the reversed reconstruction
+  std::vector<CType> data, reversedData;
+  data_gpu.copyToHost(data);
+  unsigned frameSize = width * height * coils;
+  for (unsigned frame = frames; frame > 0; frame--)
+    reversedData.insert(reversedData.end(),
+                        data.begin() + (frame - 1) * frameSize,
+                        data.begin() + frame * frameSize);
+  data_gpu.assignFromHost(reversedData.begin(), reversedData.end());
+
+  TGV2 reversedSolver(width, height, coils, frames, cartOp);
+  reversedSolver.GetParams().maxIt = 500;
+  reversedSolver.SetTemporalRegularization(false);
+  CVector x1Reversed = Reconstruct(reversedSolver);
+
+  std::vector<CType> result, reversed;
+  x1.copyToHost(result);
+  x1Reversed.copyToHost(reversed);
+  unsigned imageSize = width * height;
+  for (unsigned frame = 0; frame < frames; frame++)
+    for (unsigned cnt = 0; cnt < imageSize; cnt++)
+      EXPECT_NEAR(0.0,
+                  std::abs(result[frame * imageSize + cnt] -
+                           reversed[(frames - 1 - frame) * imageSize + cnt]),
+                  EPS);
+}
+
+TEST_F(Test_TGVSolver, PreconditioningWithoutTemporalRegularizationRejected)
+{
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 10;
+  solver.GetParams().diagonalPreconditioning = true;
+  solver.SetTemporalRegularization(false);
+  EXPECT_THROW(Reconstruct(solver), std::invalid_argument);
+}
+
+TEST_F(Test_TGVSolver, ResumeFromCheckpoint)
+{
+  std::string filename = "../test/data/output/tgv2.ckpt";
+
+  TGV2 solver(width, height, coils, frames, cartOp);
+  solver.GetParams().maxIt = 80;
+  CVector x1 = Reconstruct(solver);
+
+  {
+    TGV2 interruptedSolver(width, height, coils, frames, cartOp);
+    interruptedSolver.GetParams().maxIt = 60;
+    interruptedSolver.SetCheckpoint(filename, 30);
+    Reconstruct(interruptedSolver);
+  }
+
+  // continue after 60 iterations
+  TGV2 resumedSolver(width, height, coils, frames, cartOp);
+  resumedSolver.GetParams().maxIt = 80;
+  resumedSolver.SetResume(filename);
+  CVector x1Resumed = Reconstruct(resumedSolver);
+  EXPECT_EQ(80u, resumedSolver.GetIterations());
+
+  std::vector<CType> result, resumed;
+  x1.copyToHost(result);
+  x1Resumed.copyToHost(resumed);
+  EXPECT_EQ(result, resumed);
+
+  boost::filesystem::remove(filename);
+}
+
 TEST(Test_TGV_Real, DISABLED_Iteration)
 {
   agile::GPUEnvironment::allocateGPU(0);
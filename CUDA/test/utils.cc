@@ -43,3 +43,219 @@ TEST(Test_Utils, GetFileExtension)
   EXPECT_EQ(".dcm", utils::GetFileExtension("test.dcm"));
 }
 
+
+TEST(Test_Utils, CropKSpaceCenter)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned width = 8, height = 6, lowWidth = 4, lowHeight = 2, count = 2;
+
+  std::vector<CType> full(width * height * count);
+  for (unsigned cnt = 0; cnt < full.size(); cnt++)
+    full[cnt] = CType(cnt, 0);
+  CVector fullGPU(full.size());
+  fullGPU.assignFromHost(full.begin(), full.end());
+
+  CVector lowGPU(lowWidth * lowHeight * count);
+  utils::CropKSpaceCenter(fullGPU, lowGPU, width, height, lowWidth,
+                          lowHeight, count);
+  std::vector<CType> low;
+  lowGPU.copyToHost(low);
+
+  // non-centered layout: low frequencies in the corners
+  unsigned rows[] = { 0, 5 };
+  unsigned cols[] = { 0, 1, 6, 7 };
+  for (unsigned cnt = 0; cnt < count; cnt++)
+    for (unsigned y = 0; y < lowHeight; y++)
+      for (unsigned x = 0; x < lowWidth; x++)
+        EXPECT_EQ(full[cols[x] + rows[y] * width + cnt * width * height],
+                  low[x + y * lowWidth + cnt * lowWidth * lowHeight]);
+}
+
+TEST(Test_Utils, UpsampleImagesIsBandLimitedInterpolation)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned lowWidth = 8, lowHeight = 8, width = 16, height = 16;
+
+  // cosine below Nyquist frequency of the low resolution grid
+  std::vector<CType> low(lowWidth * lowHeight);
+  for (unsigned y = 0; y < lowHeight; y++)
+    for (unsigned x = 0; x < lowWidth; x++)
+      low[x + y * lowWidth] = CType(2.0 + std::cos(2.0 * M_PI * x / lowWidth),
+                                    1.0);
+  CVector lowGPU(low.size());
+  lowGPU.assignFromHost(low.begin(), low.end());
+
+  CVector fullGPU(width * height);
+  utils::UpsampleImages(lowGPU, fullGPU, lowWidth, lowHeight, width, height,
+                        1);
+  std::vector<CType> full;
+  fullGPU.copyToHost(full);
+
+  for (unsigned y = 0; y < height; y++)
+    for (unsigned x = 0; x < width; x++)
+    {
+      EXPECT_NEAR(2.0 + std::cos(2.0 * M_PI * x / width),
+                  full[x + y * width].real(), EPS);
+      EXPECT_NEAR(1.0, full[x + y * width].imag(), EPS);
+    }
+}
+
+TEST(Test_Utils, DownsampleImagesInvertsUpsampling)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned lowWidth = 8, lowHeight = 6, width = 16, height = 12, count = 2;
+  unsigned lowN = lowWidth * lowHeight;
+
+  std::vector<CType> low(lowN * count);
+  for (unsigned cnt = 0; cnt < low.size(); cnt++)
+    low[cnt] = CType(std::cos(0.4 * cnt), 0.5 * std::sin(0.3 * cnt));
+  CVector lowGPU(low.size());
+  lowGPU.assignFromHost(low.begin(), low.end());
+
+  CVector fullGPU(width * height * count);
+  utils::UpsampleImages(lowGPU, fullGPU, lowWidth, lowHeight, width, height,
+                        count);
+  CVector restoredGPU(lowN * count);
+  utils::DownsampleImages(fullGPU, restoredGPU, width, height, lowWidth,
+                          lowHeight, count);
+  std::vector<CType> restored;
+  restoredGPU.copyToHost(restored);
+
+  for (unsigned cnt = 0; cnt < low.size(); cnt++)
+    EXPECT_NEAR(0.0, std::abs(low[cnt] - restored[cnt]), EPS);
+}
+
+TEST(Test_Utils, GradientOfVectorViewSlice)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned width = 5, height = 4, coils = 3;
+  unsigned N = width * height;
+
+  std::vector<CType> data(N * coils);
+  for (unsigned cnt = 0; cnt < data.size(); cnt++)
+    data[cnt] = CType(cnt * cnt % 7, cnt % 3);
+  CVector dataGPU(data.size());
+  dataGPU.assignFromHost(data.begin(), data.end());
+
+  // reference: copy slice and compute gradient
+  CVector slice(N);
+  utils::GetSubVector(dataGPU, slice, 1, N);
+  std::vector<CVector> gradient = utils::Gradient2D(slice, width, height);
+
+  // view: gradient of slice 1 written to slice 2 of stacked vectors
+  std::vector<CVector> stacked;
+  stacked.push_back(CVector(N * coils));
+  stacked.push_back(CVector(N * coils));
+  std::vector<CVectorView> gradientView;
+  gradientView.push_back(CVectorView::Slice(stacked[0], 2, N));
+  gradientView.push_back(CVectorView::Slice(stacked[1], 2, N));
+  utils::Gradient2D(CVectorView::Slice(dataGPU, 1, N), gradientView, width,
+                    height);
+
+  for (unsigned dim = 0; dim < 2; dim++)
+  {
+    std::vector<CType> expected, result;
+    gradient[dim].copyToHost(expected);
+    stacked[dim].copyToHost(result);
+    for (unsigned cnt = 0; cnt < N; cnt++)
+      EXPECT_NEAR(0.0, std::abs(expected[cnt] - result[2 * N + cnt]), EPS);
+  }
+}
+
+TEST(Test_Utils, StridedVectorViewCopy)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned N = 6, coils = 3;
+
+  std::vector<RType> data(N * coils);
+  for (unsigned cnt = 0; cnt < data.size(); cnt++)
+    data[cnt] = cnt;
+  RVector dataGPU(data.size());
+  dataGPU.assignFromHost(data.begin(), data.end());
+
+  // pixel 4 over all coils
+  RVectorView pixel(dataGPU, 4, coils, N);
+  EXPECT_FALSE(pixel.IsContiguous());
+  RVector pixelGPU(coils);
+  pixel.CopyTo(pixelGPU);
+
+  std::vector<RType> pixelHost;
+  pixelGPU.copyToHost(pixelHost);
+  for (unsigned coil = 0; coil < coils; coil++)
+    EXPECT_NEAR(4.0 + coil * N, pixelHost[coil], EPS);
+
+  pixelGPU.assign(coils, -1.0);
+  pixel.CopyFrom(pixelGPU);
+  dataGPU.copyToHost(data);
+  for (unsigned cnt = 0; cnt < data.size(); cnt++)
+    EXPECT_NEAR(cnt % N == 4 ? -1.0 : (RType)cnt, data[cnt], EPS);
+
+  EXPECT_ANY_THROW(RVectorView(dataGPU, 4, coils + 1, N));
+}
+
+TEST(Test_Utils, StridedViewsRejectedByGradientAndDivergence2D)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned width = 5, height = 4, coils = 2;
+  unsigned N = width * height;
+
+  CVector dataGPU(N * coils);
+  dataGPU.assign(N * coils, 1.0);
+  std::vector<CVector> stacked;
+  stacked.push_back(CVector(N));
+  stacked.push_back(CVector(N));
+  std::vector<CVectorView> views;
+  views.push_back(CVectorView(stacked[0]));
+  views.push_back(CVectorView(stacked[1]));
+
+  // all pixels of coil 0 interleaved with coil 1
+  CVectorView strided(dataGPU, 0, N, coils);
+  EXPECT_ANY_THROW(utils::Gradient2D(strided, views, width, height));
+  EXPECT_ANY_THROW(utils::Divergence2D(views, strided, width, height));
+
+  std::vector<CVectorView> stridedViews(2, strided);
+  CVectorView slice = CVectorView::Slice(dataGPU, 0, N);
+  EXPECT_ANY_THROW(utils::Gradient2D(slice, stridedViews, width, height));
+  EXPECT_ANY_THROW(utils::Divergence2D(stridedViews, slice, width, height));
+}
+
+TEST(Test_Utils, StackedGradientAndDivergence2D)
+{
+  agile::GPUEnvironment::allocateGPU(0);
+  unsigned width = 5, height = 4, coils = 3;
+  unsigned N = width * height;
+
+  std::vector<CType> data(N * coils);
+  for (unsigned cnt = 0; cnt < data.size(); cnt++)
+    data[cnt] = CType(cnt * cnt % 11, cnt % 5);
+  CVector dataGPU(data.size());
+  dataGPU.assignFromHost(data.begin(), data.end());
+
+  // all coil slices at once
+  std::vector<CVector> gradient;
+  gradient.push_back(CVector(N * coils));
+  gradient.push_back(CVector(N * coils));
+  utils::Gradient2D(dataGPU, gradient, width, height);
+  CVector divergence(N * coils);
+  utils::Divergence2D(gradient, divergence, width, height);
+  std::vector<CType> divergenceHost;
+  divergence.copyToHost(divergenceHost);
+
+  // slice by slice
+  CVector slice(N), sliceDivergence(N);
+  std::vector<CVector> sliceGradient;
+  sliceGradient.push_back(CVector(N));
+  sliceGradient.push_back(CVector(N));
+  for (unsigned coil = 0; coil < coils; coil++)
+  {
+    utils::GetSubVector(dataGPU, slice, coil, N);
+    utils::Gradient2D(slice, sliceGradient, width, height);
+    utils::Divergence2D(sliceGradient, sliceDivergence, width, height);
+
+    std::vector<CType> expected;
+    sliceDivergence.copyToHost(expected);
+    for (unsigned cnt = 0; cnt < N; cnt++)
+      EXPECT_NEAR(0.0, std::abs(expected[cnt] - divergenceHost[coil * N + cnt]),
+                  EPS);
+  }
+}
@@ -5,6 +5,9 @@
 FUNCTYPE="ICTGV2"
 PATTERN="vista"
 R=16
+PRECOND="false"
+VARIANT="standard"
+COILSUBSET=0
 
 function usage()
 {
@@ -14,6 +17,9 @@ function usage()
     echo "--functype=$FUNCTYPE:   Regularization functional: ICTGV2, TGV2, TV"
     echo "--pattern=$PATTERN:     Sampling pattern: vista, vd (variable density), uni"
     echo "--red=$R options:       Undersampling factor: 4 8 12 16"
+    echo "--precond=$PRECOND:     Diagonally preconditioned primal-dual steps: true, false"
+    echo "--variant=$VARIANT:     Primal-dual variant: standard, accelerated, adaptive, stochastic"
+    echo "--coilsubset=$COILSUBSET: Coils per stochastic iteration (0: all coils)"
     echo ""
 }
 
@@ -34,6 +40,15 @@ while [ "$1" != "" ]; do
         --red)
             R=$VALUE
             ;;
+        --precond)
+            PRECOND=$VALUE
+            ;;
+        --variant)
+            VARIANT=$VALUE
+            ;;
+        --coilsubset)
+            COILSUBSET=$VALUE
+            ;;
           *)
             echo "ERROR: unknown parameter \"$PARAM\""
             usage
@@ -50,6 +65,18 @@ echo "==========================================================================
 DATAFILE="cardiac_cine_data.bin"
 PATTERNFILE="cardiac_cine_${PATTERN}_acc${R}.bin"
 RESULTSFILE="${FUNCTYPE}_recon_cardiac_cine_${PATTERN}_acc${R}"
+if [ "$PRECOND" == "true" ]
+then
+  RESULTSFILE="${RESULTSFILE}_precond"
+fi
+if [ "$VARIANT" != "standard" ]
+then
+  RESULTSFILE="${RESULTSFILE}_${VARIANT}"
+fi
+if [ "$COILSUBSET" != "0" ]
+then
+  RESULTSFILE="${RESULTSFILE}_coils${COILSUBSET}"
+fi
 echo "$RESULTSFILE"
 
 echo "==================================================================================="
@@ -77,7 +104,8 @@ nX=$nENC;nY=$nRO;
 if [ ! -f ./results_cine/${RESULTSFILE}.bin ]
 then
 
-  recon_cmd="./CUDA/bin/avionic -o -i 500 -m $FUNCTYPE -e -a \
+  recon_cmd="./CUDA/bin/avionic -o -i 500 -m $FUNCTYPE -e -a --diagPrecond=$PRECOND \
+            --pdVariant=$VARIANT --coilSubset=$COILSUBSET \
    	    -p ./CUDA/config/default_cine.cfg -d $nX:$nY:0:$nRO:$nENC:0:$nCOILS:$nFRAMES \
  			  $DATAFILE $PATTERNFILE \
 			  ./results_cine/${RESULTSFILE}.bin"
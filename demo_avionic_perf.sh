@@ -5,6 +5,7 @@
 FUNCTYPE="ICTGV2"
 PATTERN="vista"
 R=16
+PRECOND="false"
 
 function usage()
 {
@@ -14,6 +15,7 @@ function usage()
     echo "--functype=$FUNCTYPE:   Regularization functional: ICTGV2, TGV2, TV"
     echo "--pattern=$PATTERN:     Sampling pattern: vista, vd (variable density), uni"
     echo "--red=$R options:       Undersampling factor: 4 8 12 16"
+    echo "--precond=$PRECOND:     Diagonally preconditioned primal-dual steps: true, false"
     echo ""
 }
 
@@ -34,6 +36,9 @@ while [ "$1" != "" ]; do
         --red)
             R=$VALUE
             ;;
+        --precond)
+            PRECOND=$VALUE
+            ;;
           *)
             echo "ERROR: unknown parameter \"$PARAM\""
             usage
@@ -50,6 +55,10 @@ echo "==========================================================================
 DATAFILE="cardiac_perfusion_data.bin"
 PATTERNFILE="cardiac_perfusion_${PATTERN}_acc${R}.bin"
 RESULTSFILE="${FUNCTYPE}_recon_cardiac_perfusion_${PATTERN}_acc${R}"
+if [ "$PRECOND" == "true" ]
+then
+  RESULTSFILE="${RESULTSFILE}_precond"
+fi
 
 echo "==================================================================================="
 echo "Downloading Data"
@@ -75,7 +84,7 @@ nX=$nRO;nY=$nENC;
 if [ ! -f ./results_perfusion/${RESULTSFILE}.bin ]
 then
 
-  recon_cmd="./CUDA/bin/avionic -o -i 500 -m $FUNCTYPE -e -a \
+  recon_cmd="./CUDA/bin/avionic -o -i 500 -m $FUNCTYPE -e -a --diagPrecond=$PRECOND \
    	    -p ./CUDA/config/default_perf.cfg -d $nX:$nY:0:$nRO:$nENC:0:$nCOILS:$nFRAMES \
  			  $DATAFILE $PATTERNFILE \
 			  ./results_perfusion/${RESULTSFILE}.bin"
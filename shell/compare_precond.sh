@@ -0,0 +1,84 @@
+#!/bin/bash
+# Compare scalar and diagonally preconditioned primal-dual steps on the
+# CINE demo data: iterations and wall-clock time to a fixed PD gap
+
+# setting paths
+FUNCTYPE="ICTGV2"
+PATTERN="vista"
+R=16
+PDGAP=0.01
+MAXIT=2000
+
+function usage()
+{
+    echo "Compare scalar and diagonally preconditioned primal-dual steps"
+    echo "Run from the repository root after ./demo_avionic_cine.sh has"
+    echo "downloaded the data."
+    echo ""
+    echo "-h: Display help"
+    echo "--functype=$FUNCTYPE: Regularization functional: ICTGV2, TGV2, TV"
+    echo "--pattern=$PATTERN: Sampling pattern: vista, vd, uni"
+    echo "--red=$R: Undersampling factor: 4 8 12 16"
+    echo "--pdgap=$PDGAP: PD gap stopping target"
+    echo "--maxit=$MAXIT: Maximum number of iterations"
+    echo ""
+}
+
+while [ "$1" != "" ]; do
+    PARAM=`echo $1 | awk -F= '{print $1}'`
+    VALUE=`echo $1 | awk -F= '{print $2}'`
+    case $PARAM in
+        -h | --help)
+            usage
+            exit
+            ;;
+        --functype)
+            FUNCTYPE=$VALUE
+            ;;
+        --pattern)
+            PATTERN=$VALUE
+            ;;
+        --red)
+            R=$VALUE
+            ;;
+        --pdgap)
+            PDGAP=$VALUE
+            ;;
+        --maxit)
+            MAXIT=$VALUE
+            ;;
+          *)
+            echo "ERROR: unknown parameter \"$PARAM\""
+            usage
+            exit 1
+            ;;
+    esac
+    shift
+done
+
+DATAFILE="cardiac_cine_data.bin"
+PATTERNFILE="cardiac_cine_${PATTERN}_acc${R}.bin"
+if [ ! -f $DATAFILE ] || [ ! -f $PATTERNFILE ]
+then
+  echo "ERROR: $DATAFILE or $PATTERNFILE not found, run ./demo_avionic_cine.sh first"
+  exit 1
+fi
+
+mkdir -p ./results_precond/
+nENC=168;nRO=416;nFRAMES=25;nCOILS=30;
+nX=$nENC;nY=$nRO;
+
+echo -e "diagPrecond\titerations\ttime"
+for PRECOND in false true
+do
+  LOGFILE="./results_precond/${FUNCTYPE}_${PATTERN}_acc${R}_precond_${PRECOND}.log"
+  ./CUDA/bin/avionic -o -i $MAXIT -j $PDGAP -m $FUNCTYPE -a \
+    --diagPrecond=$PRECOND -p ./CUDA/config/default_cine.cfg \
+    -d $nX:$nY:0:$nRO:$nENC:0:$nCOILS:$nFRAMES \
+    $DATAFILE $PATTERNFILE \
+    ./results_precond/${FUNCTYPE}_${PATTERN}_acc${R}_precond_${PRECOND}.bin \
+    > $LOGFILE 2>&1
+  ITERATIONS=`grep "^Iterations:" $LOGFILE | tail -1 | awk '{print $2}'`
+  TIME=`grep "^Execution time:" $LOGFILE | tail -1 | awk '{print $3}'`
+  echo -e "$PRECOND\t\t$ITERATIONS\t\t$TIME"
+done